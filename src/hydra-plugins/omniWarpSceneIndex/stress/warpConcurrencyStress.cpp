@@ -0,0 +1,786 @@
+// Copyright 2023 NVIDIA CORPORATION
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Standalone stress driver for the concurrency of the warp scene index.
+//
+// It doesn't need USD, python or warp: the synchronization of
+// OmniWarpSceneIndex and OmniWarpPythonModule is reproduced here over
+// stand-in types, with the simulation replaced by a step returning the
+// time it was stepped to.  The members below carry the names of the code
+// they mirror, keep them in step when that code changes:
+//
+//   OmniWarpSceneIndex     _pythonModuleMap, _pythonModulePaths,
+//                          _pythonModuleMapMutex,
+//                          GetPrim, GetWarpPythonModule,
+//                          CreateWarpPythonModule, RetireWarpPythonModule,
+//                          _PrimsRemoved, _PrimsDirtied, _TakeLandedFrames,
+//                          OnWarpFrameLanded, _CallbackGuard, the destructor
+//   OmniWarpPythonModule   ExecSim, Terminate, _RequestAsyncStep,
+//                          _RunAsyncSteps
+//
+// Build it with the thread sanitizer and run it, it exits with 1 if a
+// check failed; the sanitizer reports races and deadlocks on its own:
+//
+//   g++ -std=c++14 -O1 -g -fsanitize=thread warpConcurrencyStress.cpp \
+//       -o warpConcurrencyStress -ltbb -lpthread
+//   ./warpConcurrencyStress
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <tbb/concurrent_hash_map.h>
+
+namespace {
+
+std::atomic<int> failures(0);
+
+void
+_Check(bool condition, const char* what)
+{
+    if (!condition)
+    {
+        if (failures++ < 20)
+        {
+            std::fprintf(stderr, "FAILED: %s\n", what);
+        }
+    }
+}
+
+// Stand-ins for the USD types
+struct SdfPath
+{
+    std::string path;
+
+    bool HasPrefix(const SdfPath& prefix) const
+    {
+        return path.compare(0, prefix.path.size(), prefix.path) == 0 &&
+            (path.size() == prefix.path.size() || path[prefix.path.size()] == '/');
+    }
+
+    size_t GetHash() const { return std::hash<std::string>()(path); }
+    bool operator==(const SdfPath& other) const { return path == other.path; }
+    bool operator<(const SdfPath& other) const { return path < other.path; }
+};
+
+typedef std::vector<float> VtVec3fArray;
+typedef std::shared_ptr<const int> OmniWarpSimParamsConstPtr;
+typedef std::set<SdfPath> SdfPathSet;
+typedef std::vector<SdfPath> SdfPathVector;
+
+// The python modules key their state by prim path, stands in for it so
+// a module initialized over one that wasn't terminated yet is caught
+class _PythonState
+{
+public:
+    void InitSim(const SdfPath& primPath)
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _Check(_live.insert(primPath).second, "a prim was initialized before its old module terminated");
+    }
+
+    void TerminateSim(const SdfPath& primPath)
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _Check(_live.erase(primPath) == 1, "a prim was terminated that wasn't initialized");
+    }
+
+    bool IsLive(const SdfPath& primPath)
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _live.count(primPath) != 0;
+    }
+
+private:
+    std::mutex _mutex;
+    SdfPathSet _live;
+};
+
+_PythonState pythonState;
+
+class OmniWarpPythonModule
+{
+public:
+    OmniWarpPythonModule(const SdfPath& primPath, bool isAsync,
+        std::function<void(const SdfPath&)> frameLandedCallback)
+      : _primPath(primPath),
+        _isAsync(isAsync),
+        _frameLandedCallback(std::move(frameLandedCallback)),
+        _terminated(false),
+        _asyncStopping(false),
+        _asyncStepping(false),
+        _asyncSteppingTime(0.f),
+        _asyncSteppingPrefetch(false),
+        _asyncSteppingRequestId(0),
+        _asyncRequestId(0),
+        _asyncLandedRequestId(0)
+    {
+    }
+
+    ~OmniWarpPythonModule()
+    {
+        Terminate();
+    }
+
+    void InitMesh()
+    {
+        pythonState.InitSim(_primPath);
+    }
+
+    void Terminate()
+    {
+        {
+            std::lock_guard<std::mutex> execLock(_execMutex);
+            _asyncStopping = true;
+        }
+        _asyncRequested.notify_all();
+        if (_asyncThread.joinable())
+        {
+            _asyncThread.join();
+        }
+
+        std::lock_guard<std::mutex> execLock(_execMutex);
+        if (_terminated)
+        {
+            return;
+        }
+
+        _terminated = true;
+        _frameLanded.notify_all();
+        pythonState.TerminateSim(_primPath);
+    }
+
+    // Returns the points of dt, *terminated tells whether the module was
+    // terminated meanwhile, in which case they may be those of another time
+    VtVec3fArray ExecSim(float dt, OmniWarpSimParamsConstPtr simParams, bool* terminated)
+    {
+        std::unique_lock<std::mutex> execLock(_execMutex);
+        VtVec3fArray points;
+        if (_terminated || _asyncStopping)
+        {
+            points = _lastResult.points;
+        }
+        else if (_lastResult.valid && _lastResult.time == dt && _lastResult.simParams == simParams)
+        {
+            points = _lastResult.points;
+        }
+        else if (_isAsync)
+        {
+            points = _RequestAsyncStep(execLock, dt, std::move(simParams));
+        }
+        else
+        {
+            points = _StepTo(dt);
+            _lastResult.valid = true;
+            _lastResult.time = dt;
+            _lastResult.simParams = std::move(simParams);
+            _lastResult.points = points;
+        }
+
+        *terminated = _terminated || _asyncStopping;
+        return points;
+    }
+
+    const SdfPath& GetPrimPath() const { return _primPath; }
+
+private:
+    struct _ExecResult
+    {
+        bool valid = false;
+        float time = 0.f;
+        OmniWarpSimParamsConstPtr simParams;
+        VtVec3fArray points;
+        bool prefetch = false;
+        size_t requestId = 0;
+    };
+
+    // The simulation, called with or without the lock like the real one
+    VtVec3fArray _StepTo(float time)
+    {
+        _Check(pythonState.IsLive(_primPath), "a module stepped after it was terminated");
+        std::this_thread::sleep_for(std::chrono::microseconds(200));
+        return VtVec3fArray(1, time);
+    }
+
+    VtVec3fArray _RequestAsyncStep(std::unique_lock<std::mutex>& execLock,
+        float dt, OmniWarpSimParamsConstPtr simParams)
+    {
+        if (!_asyncThread.joinable())
+        {
+            _asyncThread = std::thread(&OmniWarpPythonModule::_RunAsyncSteps, this);
+        }
+
+        const float previousTime = _lastResult.valid ? _lastResult.time : dt;
+        const float nextTime = dt + (dt > previousTime ? dt - previousTime : 1.f);
+
+        do
+        {
+            _frameLanded.wait(execLock, [this, dt]()
+            {
+                return !_asyncStepping || !_asyncSteppingPrefetch || _asyncSteppingTime != dt || _terminated;
+            });
+            if (_terminated || _asyncStopping)
+            {
+                return _lastResult.points;
+            }
+
+            if (_prefetchResult.valid && _prefetchResult.time == dt)
+            {
+                _lastResult = std::move(_prefetchResult);
+                _lastResult.simParams = simParams;
+                _prefetchResult = _ExecResult();
+                break;
+            }
+
+            size_t requestId = 0;
+            if (_asyncRequest.valid && !_asyncRequest.prefetch && _asyncRequest.time == dt)
+            {
+                requestId = _asyncRequest.requestId;
+            }
+            else if (_asyncStepping && !_asyncSteppingPrefetch && _asyncSteppingTime == dt)
+            {
+                requestId = _asyncSteppingRequestId;
+            }
+            else
+            {
+                requestId = ++_asyncRequestId;
+                _asyncRequest = _ExecResult();
+                _asyncRequest.valid = true;
+                _asyncRequest.time = dt;
+                _asyncRequest.simParams = simParams;
+                _asyncRequest.requestId = requestId;
+                _prefetchResult = _ExecResult();
+                _asyncRequested.notify_one();
+            }
+
+            _frameLanded.wait(execLock, [this, requestId]()
+            {
+                return _asyncLandedRequestId >= requestId || _terminated || _asyncStopping;
+            });
+            if (_terminated || _asyncStopping)
+            {
+                return _lastResult.points;
+            }
+        }
+        while (_lastResult.time != dt);
+
+        if (!_asyncRequest.valid)
+        {
+            _asyncRequest = _ExecResult();
+            _asyncRequest.valid = true;
+            _asyncRequest.time = nextTime;
+            _asyncRequest.simParams = std::move(simParams);
+            _asyncRequest.prefetch = true;
+            _asyncRequested.notify_one();
+        }
+
+        return _lastResult.points;
+    }
+
+    void _RunAsyncSteps()
+    {
+        std::unique_lock<std::mutex> execLock(_execMutex);
+        while (true)
+        {
+            _asyncRequested.wait(execLock, [this]() { return _asyncRequest.valid || _asyncStopping; });
+            if (_asyncStopping)
+            {
+                return;
+            }
+
+            _ExecResult request = std::move(_asyncRequest);
+            _asyncRequest = _ExecResult();
+            _asyncStepping = true;
+            _asyncSteppingTime = request.time;
+            _asyncSteppingPrefetch = request.prefetch;
+            _asyncSteppingRequestId = request.requestId;
+
+            execLock.unlock();
+            VtVec3fArray points = _StepTo(request.time);
+            execLock.lock();
+
+            _asyncStepping = false;
+            request.points = points;
+            if (request.prefetch)
+            {
+                _prefetchResult = std::move(request);
+            }
+            else
+            {
+                _asyncLandedRequestId = request.requestId;
+                _lastResult = std::move(request);
+            }
+            _frameLanded.notify_all();
+
+            if (_frameLandedCallback)
+            {
+                execLock.unlock();
+                _frameLandedCallback(_primPath);
+                execLock.lock();
+            }
+        }
+    }
+
+    SdfPath _primPath;
+    bool _isAsync;
+    std::function<void(const SdfPath&)> _frameLandedCallback;
+
+    std::mutex _execMutex;
+    bool _terminated;
+    _ExecResult _lastResult;
+    _ExecResult _asyncRequest;
+    _ExecResult _prefetchResult;
+    bool _asyncStopping;
+    bool _asyncStepping;
+    float _asyncSteppingTime;
+    bool _asyncSteppingPrefetch;
+    size_t _asyncSteppingRequestId;
+    size_t _asyncRequestId;
+    size_t _asyncLandedRequestId;
+    std::condition_variable _asyncRequested;
+    std::condition_variable _frameLanded;
+    std::thread _asyncThread;
+};
+
+typedef std::shared_ptr<OmniWarpPythonModule> OmniWarpPythonModuleSharedPtr;
+
+class OmniWarpSceneIndex
+{
+public:
+    OmniWarpSceneIndex()
+      : _alive(true),
+        _callbackGuard(std::make_shared<_CallbackGuard>(this))
+    {
+    }
+
+    ~OmniWarpSceneIndex()
+    {
+        _callbackGuard->Close();
+
+        std::lock_guard<std::mutex> mapLock(_pythonModuleMapMutex);
+        for (const SdfPath& modulePath : _pythonModulePaths)
+        {
+            OmniWarpPythonModuleSharedPtr pythonModule = GetWarpPythonModule(modulePath);
+            if (pythonModule)
+            {
+                pythonModule->Terminate();
+            }
+        }
+        _alive = false;
+    }
+
+    // Returns the module a data source of primPath would hold, if any
+    OmniWarpPythonModuleSharedPtr GetPrim(const SdfPath& primPath) const
+    {
+        return GetWarpPythonModule(primPath);
+    }
+
+    void PrimsAdded(const SdfPathVector& primPaths, bool isAsync)
+    {
+        std::lock_guard<std::mutex> mapLock(_pythonModuleMapMutex);
+        for (const SdfPath& primPath : primPaths)
+        {
+            CreateWarpPythonModule(primPath, isAsync);
+        }
+    }
+
+    void PrimsRemoved(const SdfPathVector& primPaths)
+    {
+        std::lock_guard<std::mutex> mapLock(_pythonModuleMapMutex);
+
+        SdfPathVector removedPaths;
+        for (const SdfPath& modulePath : _pythonModulePaths)
+        {
+            for (const SdfPath& primPath : primPaths)
+            {
+                if (modulePath.HasPrefix(primPath))
+                {
+                    removedPaths.push_back(modulePath);
+                    break;
+                }
+            }
+        }
+
+        for (const SdfPath& removedPath : removedPaths)
+        {
+            RetireWarpPythonModule(removedPath);
+        }
+    }
+
+    // Returns the number of landed frames announced
+    size_t PrimsDirtied()
+    {
+        SdfPathSet landedFramePaths;
+        {
+            std::lock_guard<std::mutex> landedFramesLock(_landedFramesMutex);
+            landedFramePaths.swap(_landedFramePaths);
+        }
+        return landedFramePaths.size();
+    }
+
+    OmniWarpPythonModuleSharedPtr GetWarpPythonModule(const SdfPath& primPath) const
+    {
+        _WarpPythonModuleMap::const_accessor accessor;
+        if (!_pythonModuleMap.find(accessor, primPath))
+        {
+            return OmniWarpPythonModuleSharedPtr(nullptr);
+        }
+        return accessor->second;
+    }
+
+    void OnWarpFrameLanded(const SdfPath& primPath)
+    {
+        _Check(_alive, "a module called back into a destroyed scene index");
+        std::lock_guard<std::mutex> landedFramesLock(_landedFramesMutex);
+        _landedFramePaths.insert(primPath);
+    }
+
+private:
+    void RetireWarpPythonModule(const SdfPath& primPath)
+    {
+        OmniWarpPythonModuleSharedPtr pythonModule;
+        {
+            _WarpPythonModuleMap::accessor accessor;
+            if (!_pythonModuleMap.find(accessor, primPath))
+            {
+                return;
+            }
+            pythonModule = accessor->second;
+            _pythonModuleMap.erase(accessor);
+        }
+        _pythonModulePaths.erase(primPath);
+
+        if (pythonModule)
+        {
+            pythonModule->Terminate();
+        }
+    }
+
+    OmniWarpPythonModuleSharedPtr CreateWarpPythonModule(const SdfPath& primPath, bool isAsync)
+    {
+        RetireWarpPythonModule(primPath);
+
+        std::shared_ptr<_CallbackGuard> guard = _callbackGuard;
+        OmniWarpPythonModuleSharedPtr pythonModule = std::make_shared<OmniWarpPythonModule>(primPath, isAsync,
+            [guard](const SdfPath& landedPrimPath)
+            {
+                guard->Call([&](OmniWarpSceneIndex* sceneIndex) { sceneIndex->OnWarpFrameLanded(landedPrimPath); });
+            });
+        pythonModule->InitMesh();
+
+        _WarpPythonModuleMap::accessor accessor;
+        _pythonModuleMap.insert(accessor, primPath);
+        accessor->second = pythonModule;
+        _pythonModulePaths.insert(primPath);
+        return pythonModule;
+    }
+
+    struct SdfPathHash
+    {
+        static size_t hash(const SdfPath& path)
+        {
+            return path.GetHash();
+        }
+
+        static bool equal(const SdfPath& path1, const SdfPath& path2)
+        {
+            return path1 == path2;
+        }
+    };
+
+    typedef tbb::concurrent_hash_map<SdfPath, OmniWarpPythonModuleSharedPtr, SdfPathHash> _WarpPythonModuleMap;
+    mutable _WarpPythonModuleMap _pythonModuleMap;
+    SdfPathSet _pythonModulePaths;
+    std::mutex _pythonModuleMapMutex;
+
+    class _CallbackGuard
+    {
+    public:
+        explicit _CallbackGuard(OmniWarpSceneIndex* sceneIndex)
+          : _sceneIndex(sceneIndex),
+            _callsInFlight(0)
+        {
+        }
+
+        template <class Fn>
+        bool Call(const Fn& fn)
+        {
+            OmniWarpSceneIndex* sceneIndex = _Enter();
+            if (!sceneIndex)
+            {
+                return false;
+            }
+
+            struct _CallScope
+            {
+                _CallbackGuard* guard;
+                ~_CallScope() { guard->_Exit(); }
+            } scope{this};
+            fn(sceneIndex);
+            return true;
+        }
+
+        void Close()
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _sceneIndex = nullptr;
+            _idle.wait(lock, [this]() { return _callsInFlight == 0; });
+        }
+
+    private:
+        OmniWarpSceneIndex* _Enter()
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            if (_sceneIndex)
+            {
+                _callsInFlight++;
+            }
+            return _sceneIndex;
+        }
+
+        void _Exit()
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            if (--_callsInFlight == 0)
+            {
+                _idle.notify_all();
+            }
+        }
+
+        std::mutex _mutex;
+        std::condition_variable _idle;
+        OmniWarpSceneIndex* _sceneIndex;
+        size_t _callsInFlight;
+    };
+
+    // Set to false once destroyed, a callback reading it afterwards is a
+    // use after free the sanitizer reports
+    bool _alive;
+    std::shared_ptr<_CallbackGuard> _callbackGuard;
+
+    std::mutex _landedFramesMutex;
+    SdfPathSet _landedFramePaths;
+};
+
+SdfPathVector
+_MakePrimPaths(size_t count)
+{
+    SdfPathVector primPaths;
+    for (size_t i = 0; i < count; i++)
+    {
+        primPaths.push_back(SdfPath{ "/World/group" + std::to_string(i % 4) + "/mesh" + std::to_string(i) });
+    }
+    return primPaths;
+}
+
+// Render threads query the modules of the prims while a notice thread
+// removes, re-creates and dirties them
+void
+_StressModuleMap(bool isAsync)
+{
+    const SdfPathVector primPaths = _MakePrimPaths(16);
+    const OmniWarpSimParamsConstPtr simParams = std::make_shared<const int>(0);
+
+    OmniWarpSceneIndex sceneIndex;
+    sceneIndex.PrimsAdded(primPaths, isAsync);
+
+    std::atomic<bool> stop(false);
+    std::atomic<size_t> queries(0);
+    std::vector<std::thread> renderThreads;
+    for (int t = 0; t < 8; t++)
+    {
+        renderThreads.emplace_back([&, t]()
+        {
+            std::mt19937 random(t);
+            while (!stop)
+            {
+                const SdfPath& primPath = primPaths[random() % primPaths.size()];
+                OmniWarpPythonModuleSharedPtr pythonModule = sceneIndex.GetPrim(primPath);
+                if (!pythonModule)
+                {
+                    continue;
+                }
+
+                // Data sources keep using the module they were created
+                // with after it left the map
+                for (int frame = 0; frame < 4; frame++)
+                {
+                    const float time = static_cast<float>(random() % 8);
+                    bool terminated = false;
+                    VtVec3fArray points = pythonModule->ExecSim(time, simParams, &terminated);
+                    _Check(terminated || (points.size() == 1 && points[0] == time),
+                        "a query returned the frame of another time");
+                    queries++;
+                }
+            }
+        });
+    }
+
+    std::thread noticeThread([&]()
+    {
+        std::mt19937 random(100);
+        for (int notice = 0; notice < 300; notice++)
+        {
+            SdfPathVector changed;
+            switch (random() % 3)
+            {
+                case 0:
+                    changed.push_back(primPaths[random() % primPaths.size()]);
+                    sceneIndex.PrimsRemoved(changed);
+                    sceneIndex.PrimsAdded(changed, isAsync);
+                    break;
+                case 1:
+                    changed.push_back(SdfPath{ "/World/group" + std::to_string(random() % 4) });
+                    sceneIndex.PrimsRemoved(changed);
+                    sceneIndex.PrimsAdded(primPaths, isAsync);
+                    break;
+                default:
+                    sceneIndex.PrimsDirtied();
+                    break;
+            }
+            std::this_thread::sleep_for(std::chrono::microseconds(500));
+        }
+        stop = true;
+    });
+
+    noticeThread.join();
+    for (std::thread& renderThread : renderThreads)
+    {
+        renderThread.join();
+    }
+
+    std::printf("module map (%s): %zu queries\n", isAsync ? "async" : "sync", queries.load());
+}
+
+// Data sources outlive the scene index, their modules keep landing
+// frames while it is destroyed
+void
+_StressTeardown()
+{
+    const SdfPathVector primPaths = _MakePrimPaths(8);
+    const OmniWarpSimParamsConstPtr simParams = std::make_shared<const int>(0);
+
+    for (int round = 0; round < 50; round++)
+    {
+        std::vector<OmniWarpPythonModuleSharedPtr> dataSources;
+        std::unique_ptr<OmniWarpSceneIndex> sceneIndex(new OmniWarpSceneIndex());
+        sceneIndex->PrimsAdded(primPaths, true);
+        for (const SdfPath& primPath : primPaths)
+        {
+            dataSources.push_back(sceneIndex->GetPrim(primPath));
+        }
+
+        std::atomic<bool> stop(false);
+        std::vector<std::thread> renderThreads;
+        for (size_t t = 0; t < dataSources.size(); t++)
+        {
+            renderThreads.emplace_back([&, t]()
+            {
+                for (float time = 0.f; !stop; time++)
+                {
+                    bool terminated = false;
+                    dataSources[t]->ExecSim(time, simParams, &terminated);
+                }
+            });
+        }
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        sceneIndex.reset();
+        stop = true;
+        for (std::thread& renderThread : renderThreads)
+        {
+            renderThread.join();
+        }
+    }
+
+    std::printf("teardown: 50 rounds\n");
+}
+
+// Playback, a paused timeline, a jump back and concurrent queries of one
+// frame each return the frame of their own time from an async module
+void
+_StressAsyncFrames()
+{
+    const SdfPath primPath{ "/World/mesh" };
+    const OmniWarpSimParamsConstPtr simParams = std::make_shared<const int>(0);
+
+    OmniWarpSceneIndex sceneIndex;
+    sceneIndex.PrimsAdded(SdfPathVector(1, primPath), true);
+    OmniWarpPythonModuleSharedPtr pythonModule = sceneIndex.GetPrim(primPath);
+
+    auto query = [&](float time)
+    {
+        bool terminated = false;
+        VtVec3fArray points = pythonModule->ExecSim(time, simParams, &terminated);
+        _Check(!terminated && points.size() == 1 && points[0] == time,
+            "an async query returned the frame of another time");
+    };
+
+    for (int frame = 1; frame <= 200; frame++)
+    {
+        query(static_cast<float>(frame));
+    }
+    for (int i = 0; i < 20; i++)
+    {
+        query(200.f);
+    }
+    query(10.f);
+
+    std::vector<std::thread> renderThreads;
+    for (int t = 0; t < 8; t++)
+    {
+        renderThreads.emplace_back([&, t]()
+        {
+            for (int frame = 0; frame < 50; frame++)
+            {
+                query(static_cast<float>(frame % 5 + (t % 2) * 100));
+            }
+        });
+    }
+    for (std::thread& renderThread : renderThreads)
+    {
+        renderThread.join();
+    }
+
+    std::printf("async frames: %zu landed frames announced\n", sceneIndex.PrimsDirtied());
+}
+
+} // namespace
+
+int
+main()
+{
+    _StressModuleMap(false);
+    _StressModuleMap(true);
+    _StressTeardown();
+    _StressAsyncFrames();
+
+    if (failures)
+    {
+        std::printf("%d checks failed\n", failures.load());
+        return 1;
+    }
+
+    std::printf("all checks passed\n");
+    return 0;
+}
@@ -19,6 +19,8 @@
 
 #include "warpComputationAPIAdapter.h"
 #include "warpComputationAPI.h"
+#include "warpComputationSchema.h"
+#include "tokens.h"
 
 PXR_NAMESPACE_OPEN_SCOPE
 
@@ -234,6 +236,30 @@ WarpComputationAPIAdapter::InvalidateImagingSubprim(
     const UsdImagingPropertyInvalidationType invalidationType)
 #endif
 {
+    // The simulation parameters are the custom data of warp:sourceFile,
+    // the scene index drops its cached copy when they are dirtied.  It
+    // orders the prims it steps by their dependentPrims
+    HdDataSourceLocatorSet locators;
+    if (subprim.IsEmpty())
+    {
+        for (const TfToken &propertyName : properties)
+        {
+            if (propertyName == OmniWarpSceneIndexTokens->warpSourceFile)
+            {
+                locators.insert(OmniWarpComputationSchema::GetSimulationParamsLocator());
+            }
+            else if (propertyName == OmniWarpSceneIndexTokens->warpDependentPrims)
+            {
+                locators.insert(OmniWarpComputationSchema::GetDependentPrimsLocator());
+            }
+        }
+    }
+
+    if (!locators.IsEmpty())
+    {
+        return locators;
+    }
+
 #if 0
     if (!subprim.IsEmpty() || appliedInstanceName.IsEmpty()) {
         return HdDataSourceLocatorSet();
@@ -11,4 +11,32 @@
 # WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
 # See the License for the specific language governing permissions and
 # limitations under the License.
-#
\ No newline at end of file
+#
+
+def write_points(points, out_points):
+    """
+    Copies a warp array of vec3 points into the buffer passed to exec_sim_into.
+
+    Args:
+        points: A warp array of vec3 on any device.
+        out_points: The writable buffer passed to exec_sim_into as out_points.
+
+    Returns:
+        None if the points were written to out_points.  If out_points doesn't hold exactly
+        as many points (on the first step, or when the number of points changes) the points
+        are returned as a new Vt.Vec3fArray instead, which sizes the buffer for the next step.
+    """
+    import numpy as np
+    import warp as wp
+    from pxr import Vt
+
+    out_view = np.frombuffer(out_points, dtype=np.float32)
+    if out_view.size != 3 * len(points):
+        return Vt.Vec3fArray.FromNumpy(points.numpy())
+
+    # alias the buffer rather than going through an intermediate numpy array,
+    # so points on the GPU are copied once, straight into the buffer
+    dest = wp.array(out_view.reshape(-1, 3), dtype=wp.vec3, device="cpu", copy=False)
+    wp.copy(dest, points)
+    wp.synchronize_device(points.device)
+    return None
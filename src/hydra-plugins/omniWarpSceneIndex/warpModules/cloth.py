@@ -25,6 +25,8 @@ import warp.sim.render
 
 from pxr import Usd, UsdGeom, Vt, Sdf
 
+from . import write_points
+
 import sys
 
 wp.init()
@@ -134,4 +136,36 @@ def exec_sim(primPath: Sdf.Path, sim_dt: float, dep_mesh_points: Vt.Vec3fArray =
     # Not respecting sim_dt at all, using internal time
     global global_examples
     global_examples[primPath].update(sim_dt)
-    return Vt.Vec3fArray.FromNumpy(global_examples[primPath].state_0.particle_q.numpy())
\ No newline at end of file
+    return Vt.Vec3fArray.FromNumpy(global_examples[primPath].state_0.particle_q.numpy())
+
+
+def exec_sim_into(primPath: Sdf.Path, sim_dt: float, dep_mesh_points: Vt.Vec3fArray = None, sim_params: dict = None,
+    out_points: memoryview = None):
+    global global_examples
+    global_examples[primPath].update(sim_dt)
+    return write_points(global_examples[primPath].state_0.particle_q, out_points)
+
+
+def save_state(primPath: Sdf.Path):
+    global global_examples
+    state = global_examples[primPath].state_0
+    # numpy() aliases arrays on the cpu, the state has to be a copy
+    positions = np.copy(state.particle_q.numpy())
+    velocities = np.copy(state.particle_qd.numpy())
+    return ((positions, velocities), positions.nbytes + velocities.nbytes)
+
+def restore_state(primPath: Sdf.Path, saved_state):
+    global global_examples
+    example = global_examples[primPath]
+    positions, velocities = saved_state
+    state = example.state_0
+    wp.copy(state.particle_q, wp.array(positions, dtype=wp.vec3, device=state.particle_q.device))
+    wp.copy(state.particle_qd, wp.array(velocities, dtype=wp.vec3, device=state.particle_qd.device))
+
+def exec_sim_batch(primPaths: list, sim_dt: float, dep_mesh_points: list = None, sim_params: list = None):
+    # Batches are all-or-nothing, fail before any prim has stepped
+    missing = [primPath for primPath in primPaths if primPath not in global_examples]
+    if missing:
+        raise KeyError(missing)
+    return [exec_sim(primPath, sim_dt, points, params)
+        for primPath, points, params in zip(primPaths, dep_mesh_points, sim_params)]
@@ -17,6 +17,8 @@ import warp as wp
 import numpy as np
 from pxr import Vt, Sdf
 
+from . import write_points
+
 @wp.kernel
 def deform(positions: wp.array(dtype=wp.vec3), t: float):
     tid = wp.tid()
@@ -61,5 +63,34 @@ def exec_sim(primPath: Sdf.Path, sim_dt: float, dep_mesh_points: Vt.Vec3fArray =
     global_examples[primPath].update(sim_dt / 60.0)
     return Vt.Vec3fArray.FromNumpy(global_examples[primPath].mesh.points.numpy())
 
+
+def exec_sim_into(primPath: Sdf.Path, sim_dt: float, dep_mesh_points: Vt.Vec3fArray = None, sim_params: dict = None,
+    out_points: memoryview = None):
+    global global_examples
+    global_examples[primPath].update(sim_dt / 60.0)
+    return write_points(global_examples[primPath].mesh.points, out_points)
+
+
+def save_state(primPath: Sdf.Path):
+    global global_examples
+    # numpy() aliases arrays on the cpu, the state has to be a copy
+    points = np.copy(global_examples[primPath].mesh.points.numpy())
+    return (points, points.nbytes)
+
+def restore_state(primPath: Sdf.Path, saved_state):
+    global global_examples
+    example = global_examples[primPath]
+    wp.copy(example.mesh.points, wp.array(saved_state, dtype=wp.vec3, device=example.mesh.points.device))
+    example.mesh.refit()
+
+def exec_sim_batch(primPaths: list, sim_dt: float, dep_mesh_points: list = None, sim_params: list = None):
+    global global_examples
+    examples = [global_examples[primPath] for primPath in primPaths]
+    # Launch every prim's kernel before reading any back,
+    # so the device isn't synchronized in between
+    for example in examples:
+        example.update(sim_dt / 60.0)
+    return [Vt.Vec3fArray.FromNumpy(example.mesh.points.numpy()) for example in examples]
+
 def is_enabled():
     return True
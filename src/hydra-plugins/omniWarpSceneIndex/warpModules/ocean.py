@@ -17,6 +17,8 @@ import warp as wp
 import numpy as np
 from pxr import Vt, Sdf
 
+from . import write_points
+
 wp.init()
 
 sim_params_global = {
@@ -203,10 +205,12 @@ class Example:
         self.profile_extent = 410.0  #physical size of profile, should be around half the resolution
         self.profile_res = int(8192)
         self.profile_wavenum = int(1000)
-        self.profile_CUDA = wp.zeros(self.profile_res, dtype=wp.vec3, device="cuda:0")
+        # the default device is the first CUDA device if there is one, otherwise the CPU
+        self.device = wp.get_device()
+        self.profile_CUDA = wp.zeros(self.profile_res, dtype=wp.vec3, device=self.device)
 
-        self.points_in = wp.array(points, dtype=wp.vec3, device="cuda:0")
-        self.points_out = wp.array(points, dtype=wp.vec3, device="cuda:0")
+        self.points_in = wp.array(points, dtype=wp.vec3, device=self.device)
+        self.points_out = wp.array(points, dtype=wp.vec3, device=self.device)
 
         print(self.points_in)
         print(self.points_out)
@@ -244,7 +248,7 @@ class Example:
             dim=self.profile_res, 
             inputs=[self.profile_CUDA, int(self.profile_res), int(self.profile_wavenum), float(minWavelength), float(maxWavelength), float(self.profile_extent), float(time), float(windspeed), float(waterdepth)], 
             outputs=[],
-            device="cuda:0")
+            device=self.device)
                                 
         # update point positions using the profile buffer created above
         wp.launch(
@@ -252,7 +256,7 @@ class Example:
             dim=len(self.points_out), 
             inputs=[self.points_out, self.points_in, self.profile_CUDA, int(self.profile_res), float(self.profile_extent*scale), float(amplitude), float(directionality), float(direction), int(antiAlias), float(campos[0]), float(campos[1]), float(campos[2]) ], 
             outputs=[],
-            device="cuda:0")
+            device=self.device)
 
 
 
@@ -281,3 +285,22 @@ def exec_sim(primPath: Sdf.Path, sim_dt: float, dep_mesh_points: Vt.Vec3fArray =
     # Sim expects 60 samples per second (or hydra time of 1.0)
     global_examples[primPath].update(sim_dt / 60.0)
     return Vt.Vec3fArray.FromNumpy(global_examples[primPath].points_out.numpy())
+
+
+def exec_sim_into(primPath: Sdf.Path, sim_dt: float, dep_mesh_points: Vt.Vec3fArray = None, sim_params: dict = None,
+    out_points: memoryview = None):
+    global global_examples
+    global sim_params_global
+    if sim_params:
+        sim_params_global = sim_params
+
+    global_examples[primPath].update(sim_dt / 60.0)
+    return write_points(global_examples[primPath].points_out, out_points)
+
+def exec_sim_batch(primPaths: list, sim_dt: float, dep_mesh_points: list = None, sim_params: list = None):
+    # Batches are all-or-nothing, fail before any prim has stepped
+    missing = [primPath for primPath in primPaths if primPath not in global_examples]
+    if missing:
+        raise KeyError(missing)
+    return [exec_sim(primPath, sim_dt, points, params)
+        for primPath, points, params in zip(primPaths, dep_mesh_points, sim_params)]
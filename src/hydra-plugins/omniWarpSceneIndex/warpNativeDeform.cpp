@@ -0,0 +1,111 @@
+// Copyright 2023 NVIDIA CORPORATION
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include <cmath>
+#include <vector>
+
+#include <pxr/base/tf/registryManager.h>
+#include <pxr/base/work/loops.h>
+
+#include "warpNativeKernel.h"
+
+PXR_NAMESPACE_OPEN_SCOPE
+
+///
+/// Native port of warpModules/deform01.py and warpModules/deform02.py,
+/// which only differ in the amplitude of the deformation.
+///
+/// Each step moves every point along y by -sin(x) * amplitude * sin(t).
+/// The deformation never changes x, so -sin(x) * amplitude is computed
+/// once per point at initialization and a step is a single multiply-add
+/// per point, which the compiler vectorizes within each chunk.
+///
+class _DeformKernel : public OmniWarpNativeKernel
+{
+public:
+    explicit _DeformKernel(float amplitude) : _amplitude(amplitude)
+    {
+    }
+
+    void InitMesh(const VtIntArray& indices, const VtVec3fArray& vertices,
+        const VtIntArray& depIndices, const VtVec3fArray& depVertices, const VtDictionary& simParams) override
+    {
+        _points = vertices;
+
+        const size_t numPoints = _points.size();
+        const GfVec3f* const points = _points.cdata();
+        _offsets.resize(numPoints);
+        float* const offsets = _offsets.data();
+        const float amplitude = _amplitude;
+        WorkParallelForN(numPoints, [points, offsets, amplitude](size_t begin, size_t end)
+        {
+            for (size_t i = begin; i < end; i++)
+            {
+                offsets[i] = -std::sin(points[i][0]) * amplitude;
+            }
+        });
+    }
+
+    VtVec3fArray ExecSim(float time, const VtVec3fArray& dependentVertices, const VtDictionary& simParams) override
+    {
+        // Sim expects 60 samples per second (or hydra time of 1.0)
+        const float scale = std::sin(time / 60.f);
+
+        // data() detaches the points from the array handed out by
+        // the previous step, if anyone still holds on to it
+        float* const points = _points.data()->data();
+        const float* const offsets = _offsets.data();
+        WorkParallelForN(_offsets.size(), [points, offsets, scale](size_t begin, size_t end)
+        {
+            for (size_t i = begin; i < end; i++)
+            {
+                points[3 * i + 1] += offsets[i] * scale;
+            }
+        });
+
+        return _points;
+    }
+
+    // The points are the whole state, the saved state shares their
+    // storage until the next step detaches them
+    bool SaveState(VtValue* state, size_t* stateSize) const override
+    {
+        *state = VtValue(_points);
+        *stateSize = _points.size() * sizeof(GfVec3f);
+        return true;
+    }
+
+    void RestoreState(const VtValue& state) override
+    {
+        if (state.IsHolding<VtVec3fArray>())
+        {
+            _points = state.UncheckedGet<VtVec3fArray>();
+        }
+    }
+
+private:
+    const float _amplitude;
+    VtVec3fArray _points;
+    std::vector<float> _offsets;
+};
+
+TF_REGISTRY_FUNCTION(OmniWarpNativeKernelRegistry)
+{
+    OmniWarpNativeKernelRegistry& registry = OmniWarpNativeKernelRegistry::GetInstance();
+    registry.RegisterKernel("deform01", []() { return OmniWarpNativeKernelUniquePtr(new _DeformKernel(0.06f)); });
+    registry.RegisterKernel("deform02", []() { return OmniWarpNativeKernelUniquePtr(new _DeformKernel(0.02f)); });
+}
+
+PXR_NAMESPACE_CLOSE_SCOPE
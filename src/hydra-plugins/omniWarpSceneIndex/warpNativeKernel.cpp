@@ -0,0 +1,100 @@
+// Copyright 2023 NVIDIA CORPORATION
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include <cstring>
+
+#include <pxr/base/tf/diagnostic.h>
+#include <pxr/base/tf/instantiateSingleton.h>
+#include <pxr/base/tf/registryManager.h>
+#include <pxr/base/tf/stringUtils.h>
+
+#include "warpNativeKernel.h"
+
+PXR_NAMESPACE_OPEN_SCOPE
+
+TF_INSTANTIATE_SINGLETON(OmniWarpNativeKernelRegistry);
+
+static const char* const NATIVE_MODULE_SCHEME = "native:";
+
+OmniWarpNativeKernel::~OmniWarpNativeKernel()
+{
+}
+
+void OmniWarpNativeKernel::InitMesh(const VtIntArray& indices, const VtVec3fArray& vertices,
+    const VtIntArray& depIndices, const VtVec3fArray& depVertices, const VtDictionary& simParams)
+{
+    TF_CODING_ERROR("Native kernel does not simulate meshes");
+}
+
+void OmniWarpNativeKernel::InitParticles(const VtVec3fArray& positions,
+    const VtIntArray& depIndices, const VtVec3fArray& depVertices, const VtDictionary& simParams)
+{
+    TF_CODING_ERROR("Native kernel does not simulate particles");
+}
+
+bool OmniWarpNativeKernel::SaveState(VtValue* state, size_t* stateSize) const
+{
+    return false;
+}
+
+void OmniWarpNativeKernel::RestoreState(const VtValue& state)
+{
+    TF_CODING_ERROR("Native kernel does not restore states");
+}
+
+OmniWarpNativeKernelRegistry::OmniWarpNativeKernelRegistry()
+{
+    // the registry functions of the kernels access the instance
+    // so it has to be available before they are run
+    TfSingleton<OmniWarpNativeKernelRegistry>::SetInstanceConstructed(*this);
+    TfRegistryManager::GetInstance().SubscribeTo<OmniWarpNativeKernelRegistry>();
+}
+
+OmniWarpNativeKernelRegistry::~OmniWarpNativeKernelRegistry()
+{
+}
+
+bool OmniWarpNativeKernelRegistry::IsNativeModuleName(const std::string& moduleName, std::string* kernelName)
+{
+    if (!TfStringStartsWith(moduleName, NATIVE_MODULE_SCHEME))
+    {
+        return false;
+    }
+
+    *kernelName = moduleName.substr(strlen(NATIVE_MODULE_SCHEME));
+    return true;
+}
+
+void OmniWarpNativeKernelRegistry::RegisterKernel(const std::string& kernelName,
+    const OmniWarpNativeKernelFactory& factory)
+{
+    if (!this->_factories.emplace(kernelName, factory).second)
+    {
+        TF_CODING_ERROR("Native warp kernel '%s' registered more than once", kernelName.c_str());
+    }
+}
+
+OmniWarpNativeKernelUniquePtr OmniWarpNativeKernelRegistry::CreateKernel(const std::string& kernelName) const
+{
+    auto it = this->_factories.find(kernelName);
+    if (it == this->_factories.end())
+    {
+        return nullptr;
+    }
+
+    return it->second();
+}
+
+PXR_NAMESPACE_CLOSE_SCOPE
@@ -0,0 +1,125 @@
+// Copyright 2023 NVIDIA CORPORATION
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#ifndef OMNI_WARP_SCENE_INDEX_WARP_NATIVE_KERNEL_H
+#define OMNI_WARP_SCENE_INDEX_WARP_NATIVE_KERNEL_H
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+#include <pxr/pxr.h>
+#include <pxr/base/tf/singleton.h>
+#include <pxr/base/vt/array.h>
+#include <pxr/base/vt/dictionary.h>
+#include <pxr/base/vt/value.h>
+#include <pxr/base/gf/vec3f.h>
+
+#include "api.h"
+
+PXR_NAMESPACE_OPEN_SCOPE
+
+///
+/// \class OmniWarpNativeKernel
+///
+/// A simulation implemented in C++ rather than as a warp python module.
+/// Kernels follow the same lifecycle as a python module: one of the
+/// Init methods is called once when the prim is added, ExecSim for each
+/// step and the kernel is destroyed in place of terminate_sim.  Native
+/// kernels never take the GIL, so prims using them simulate concurrently.
+///
+class OmniWarpNativeKernel
+{
+public:
+    OMNIWARPSCENEINDEX_API
+    virtual ~OmniWarpNativeKernel();
+
+    OMNIWARPSCENEINDEX_API
+    virtual void InitMesh(const VtIntArray& indices, const VtVec3fArray& vertices,
+        const VtIntArray& depIndices, const VtVec3fArray& depVertices, const VtDictionary& simParams);
+
+    OMNIWARPSCENEINDEX_API
+    virtual void InitParticles(const VtVec3fArray& positions,
+        const VtIntArray& depIndices, const VtVec3fArray& depVertices, const VtDictionary& simParams);
+
+    /// Advances the simulation to the given stage time
+    /// and returns the resulting points.
+    OMNIWARPSCENEINDEX_API
+    virtual VtVec3fArray ExecSim(float time, const VtVec3fArray& dependentVertices,
+        const VtDictionary& simParams) = 0;
+
+    /// Saves the state of the simulation to state and sets stateSize to
+    /// the memory it holds.  Returns false if the kernel can't save its
+    /// state, which is the default, and so doesn't support checkpoints.
+    OMNIWARPSCENEINDEX_API
+    virtual bool SaveState(VtValue* state, size_t* stateSize) const;
+
+    /// Restores a state saved by SaveState.
+    OMNIWARPSCENEINDEX_API
+    virtual void RestoreState(const VtValue& state);
+};
+
+using OmniWarpNativeKernelUniquePtr = std::unique_ptr<OmniWarpNativeKernel>;
+using OmniWarpNativeKernelFactory = std::function<OmniWarpNativeKernelUniquePtr()>;
+
+///
+/// \class OmniWarpNativeKernelRegistry
+///
+/// Registry of the native kernels a prim can select with a
+/// "native:<kernel name>" value of warp:sourceFile.  Kernels register
+/// themselves from a TF_REGISTRY_FUNCTION(OmniWarpNativeKernelRegistry)
+/// block, which is run the first time the registry is accessed.
+///
+class OmniWarpNativeKernelRegistry
+{
+public:
+    static OmniWarpNativeKernelRegistry& GetInstance()
+    {
+        return TfSingleton<OmniWarpNativeKernelRegistry>::GetInstance();
+    }
+
+    // prevent copying and assignment
+    OmniWarpNativeKernelRegistry(const OmniWarpNativeKernelRegistry&) = delete;
+    OmniWarpNativeKernelRegistry& operator=(const OmniWarpNativeKernelRegistry&) = delete;
+
+    /// Returns true if moduleName selects a native kernel rather than a
+    /// python module, and if so sets kernelName to the name of the kernel.
+    OMNIWARPSCENEINDEX_API
+    static bool IsNativeModuleName(const std::string& moduleName, std::string* kernelName);
+
+    OMNIWARPSCENEINDEX_API
+    void RegisterKernel(const std::string& kernelName, const OmniWarpNativeKernelFactory& factory);
+
+    /// Returns a new instance of the kernel registered as kernelName,
+    /// or null if there is no such kernel.
+    OMNIWARPSCENEINDEX_API
+    OmniWarpNativeKernelUniquePtr CreateKernel(const std::string& kernelName) const;
+
+private:
+
+    OmniWarpNativeKernelRegistry();
+    ~OmniWarpNativeKernelRegistry();
+
+    friend class TfSingleton<OmniWarpNativeKernelRegistry>;
+
+private:
+
+    std::unordered_map<std::string, OmniWarpNativeKernelFactory> _factories;
+};
+
+PXR_NAMESPACE_CLOSE_SCOPE
+
+#endif // OMNI_WARP_SCENE_INDEX_WARP_NATIVE_KERNEL_H
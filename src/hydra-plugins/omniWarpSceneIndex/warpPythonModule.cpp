@@ -13,76 +13,1001 @@
 // limitations under the License.
 //
 
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <unordered_map>
+
+#include <pxr/base/tf/envSetting.h>
 #include <pxr/base/tf/pyInvoke.h>
 #include <pxr/base/tf/errorMark.h>
 #include <pxr/base/tf/pyExceptionState.h>
 #include <pxr/base/tf/pyInterpreter.h>
 #include <pxr/imaging/hd/tokens.h>
 
+#include "warpNativeKernel.h"
 #include "warpPythonModule.h"
 #include "tokens.h"
 
 PXR_NAMESPACE_OPEN_SCOPE
 
+TF_DEFINE_ENV_SETTING(OMNI_WARP_ASYNC_SIM, false,
+    "Step warp simulations on a worker thread while the previous frame renders");
+
+TF_DEFINE_ENV_SETTING(OMNI_WARP_CHECKPOINT_INTERVAL, 0,
+    "Save the state of warp simulations every this many frames, so seeking "
+    "back steps at most this many frames (0 disables checkpoints)");
+
+TF_DEFINE_ENV_SETTING(OMNI_WARP_CHECKPOINT_BUDGET_MB, 512,
+    "Memory the checkpoints of all warp simulations together may use");
+
+TF_DEFINE_ENV_SETTING(OMNI_WARP_SIM_CACHE, "",
+    "Bake the steps of warp simulations to cache files (\"bake\") "
+    "or play them back from those files (\"playback\")");
+
+TF_DEFINE_ENV_SETTING(OMNI_WARP_SIM_CACHE_DIR, "",
+    "Directory of the warp simulation cache files, one per prim");
+
+TF_DEFINE_ENV_SETTING(OMNI_WARP_SIM_CACHE_QUANTIZE, false,
+    "Bake warp simulation cache files with 16 bit quantized points");
+
+// memory held by the checkpoints of all modules
+static std::atomic<size_t> checkpointBytes(0);
+
 OmniWarpPythonModule::OmniWarpPythonModule(const SdfPath &primPath,
-    const std::string& moduleName, UsdImagingStageSceneIndexConstRefPtr usdImagingSi)
-    : _primPath(primPath),
-      _moduleName(moduleName),
-      _usdImagingSi(usdImagingSi)
+    const std::string& moduleName, const SdfPath &simParamsPath,
+    UsdImagingStageSceneIndexConstRefPtr usdImagingSi,
+    const FrameLandedCallback& frameLandedCallback,
+    const ExecBatchCallback& execBatchCallback,
+    const ExecFrameCallback& execFrameCallback,
+    const DependentVerticesCallback& dependentVerticesCallback)
+    : _moduleName(moduleName),
+      _primPath(primPath),
+      _simParamsPath(simParamsPath),
+      _usdImagingSi(usdImagingSi),
+      _isNative(false),
+      _terminated(false),
+      _frameLandedCallback(frameLandedCallback),
+      _asyncStopping(false),
+      _asyncStepping(false),
+      _asyncSteppingTime(0.f),
+      _asyncSteppingPrefetch(false),
+      _asyncSteppingRequestId(0),
+      _asyncRequestId(0),
+      _asyncLandedRequestId(0),
+      _execBatchCallback(execBatchCallback),
+      _execFrameCallback(execFrameCallback),
+      _dependentVerticesCallback(dependentVerticesCallback),
+      _scheduled(false),
+      _simParamsVersion(0),
+      _checkpointInterval(0),
+      _checkpointStride(0),
+      _checkpointsStarted(false),
+      _initialTime(0.f),
+      _stateTime(0.f),
+      _nextOutputBuffer(0),
+      _outputPointCount(0)
 {
+    std::string kernelName;
+    if (OmniWarpNativeKernelRegistry::IsNativeModuleName(moduleName, &kernelName))
+    {
+        _isNative = true;
+        _nativeKernel = OmniWarpNativeKernelRegistry::GetInstance().CreateKernel(kernelName);
+        if (!_nativeKernel)
+        {
+            TF_WARN("No native warp kernel named '%s' for prim <%s>", kernelName.c_str(), primPath.GetText());
+        }
+    }
+
+    // Asynchronous steps are keyed on stage time, without
+    // the stage scene index every query has to be a step
+    _isAsync = TfGetEnvSetting(OMNI_WARP_ASYNC_SIM) && _usdImagingSi;
+
+    // Checkpoints are keyed on stage time as well
+    if (_usdImagingSi)
+    {
+        _checkpointInterval = std::max(0, TfGetEnvSetting(OMNI_WARP_CHECKPOINT_INTERVAL));
+        _checkpointStride = _checkpointInterval;
+    }
+
+    // Cache files are keyed on stage time as well
+    const std::string simCacheMode = TfGetEnvSetting(OMNI_WARP_SIM_CACHE);
+    if (_usdImagingSi && !simCacheMode.empty())
+    {
+        const std::string simCacheFile = OmniWarpSimCache::GetCacheFilePath(
+            TfGetEnvSetting(OMNI_WARP_SIM_CACHE_DIR), primPath);
+        if (simCacheMode == "playback")
+        {
+            _simCache = OmniWarpSimCache::Open(simCacheFile);
+        }
+        else if (simCacheMode == "bake")
+        {
+            _simCacheWriter = OmniWarpSimCacheWriter::Create(simCacheFile,
+                TfGetEnvSetting(OMNI_WARP_SIM_CACHE_QUANTIZE));
+        }
+        else
+        {
+            TF_WARN("Unknown OMNI_WARP_SIM_CACHE mode '%s'", simCacheMode.c_str());
+        }
+    }
 }
 
 OmniWarpPythonModule::~OmniWarpPythonModule()
 {
+    Terminate();
+}
+
+void OmniWarpPythonModule::Terminate()
+{
+    // Let the worker finish its step, it needs the lock to publish it
+    {
+        std::lock_guard<std::mutex> execLock(_execMutex);
+        _asyncStopping = true;
+    }
+    _asyncRequested.notify_all();
+    if (_asyncThread.joinable())
+    {
+        _asyncThread.join();
+    }
+
+    std::lock_guard<std::mutex> execLock(_execMutex);
+    if (_terminated)
+    {
+        return;
+    }
+
+    _terminated = true;
+    _frameLanded.notify_all();
+
+    // finishes the baked cache file
+    _simCacheWriter.reset();
+    if (_simCache)
+    {
+        // the simulation was never initialized
+        _simCache.reset();
+        return;
+    }
+
+    _ReleaseCheckpoints();
+    if (_isNative)
+    {
+        _nativeKernel.reset();
+        return;
+    }
+
     TfPyLock pyLock;
     boost::python::object result;
     TfPyInvokeAndReturn(_moduleName.c_str(), "terminate_sim", &result, _primPath);
+
+    _pySimParamsSource.reset();
+    _pySimParams = TfPyObjWrapper();
 }
 
-void OmniWarpPythonModule::InitMesh(VtIntArray indices, VtVec3fArray vertices,
-    VtIntArray depIndices, VtVec3fArray depVertices, VtDictionary simParams)
+void OmniWarpPythonModule::InitMesh(const VtIntArray& indices, const VtVec3fArray& vertices,
+    const VtIntArray& depIndices, const VtVec3fArray& depVertices, const VtDictionary& simParams)
 {
+    if (_simCache)
+    {
+        return;
+    }
+
+    if (_isNative)
+    {
+        if (_nativeKernel)
+        {
+            _nativeKernel->InitMesh(indices, vertices, depIndices, depVertices, simParams);
+        }
+        return;
+    }
+
     TfPyLock pyLock;
     boost::python::object result;
     TfPyInvokeAndReturn(_moduleName.c_str(), "initialize_sim_mesh", &result, _primPath, indices, vertices,
         depIndices, depVertices, simParams);
 }
 
-void OmniWarpPythonModule::InitParticles(
-    VtVec3fArray positions, VtIntArray depIndices, VtVec3fArray depVertices, VtDictionary simParams)
+void OmniWarpPythonModule::InitParticles(const VtVec3fArray& positions,
+    const VtIntArray& depIndices, const VtVec3fArray& depVertices, const VtDictionary& simParams)
 {
+    if (_simCache)
+    {
+        return;
+    }
+
+    if (_isNative)
+    {
+        if (_nativeKernel)
+        {
+            _nativeKernel->InitParticles(positions, depIndices, depVertices, simParams);
+        }
+        return;
+    }
+
     TfPyLock pyLock;
     boost::python::object result;
     TfPyInvokeAndReturn(_moduleName.c_str(), "initialize_sim_particles", &result,
         _primPath, positions, depIndices, depVertices, simParams);
 }
 
-VtVec3fArray OmniWarpPythonModule::ExecSim(VtDictionary simParams)
+VtVec3fArray OmniWarpPythonModule::ExecSim(OmniWarpSimParamsConstPtr simParams)
 {
-    return ExecSim(simParams, VtVec3fArray());
+    return ExecSim(std::move(simParams), VtVec3fArray());
 }
 
-VtVec3fArray OmniWarpPythonModule::ExecSim(VtDictionary simParams, VtVec3fArray dependentVertices)
+VtVec3fArray OmniWarpPythonModule::ExecSim(OmniWarpSimParamsConstPtr simParams, VtVec3fArray dependentVertices)
 {
-    TfPyLock pyLock;
-    boost::python::object result;
+    // Concurrent queries for the same frame wait here for the first
+    // one to step rather than stepping the simulation again
+    std::unique_lock<std::mutex> execLock(_execMutex);
+    if (_terminated || _asyncStopping)
+    {
+        return _lastResult.points;
+    }
 
     float dt = 0.f;
     if (_usdImagingSi)
     {
         dt = _usdImagingSi->GetTime().GetValue();
+
+        // Playback reads the frame out of the mapped cache file, which
+        // doesn't depend on the inputs, only on the time
+        if (_simCache)
+        {
+            if (!_lastResult.valid || _lastResult.time != dt)
+            {
+                _simCache->GetFrame(dt, &_lastResult.points);
+                _lastResult.valid = true;
+                _lastResult.time = dt;
+            }
+            return _lastResult.points;
+        }
+
+        // Without the stage scene index every call is a step of
+        // emulated frame time, so only reuse results keyed on stage time
+        if (_IsResultFor(_lastResult, dt, simParams, dependentVertices))
+        {
+            return _lastResult.points;
+        }
+    }
+
+    if (_isAsync)
+    {
+        return _RequestAsyncStep(execLock, dt, std::move(simParams), std::move(dependentVertices));
     }
 
-    if (TfPyInvokeAndReturn(_moduleName.c_str(), "exec_sim", &result, _primPath, dt, dependentVertices, simParams))
+    if (_execFrameCallback && _scheduled)
+    {
+        // The frame steps the prims this one depends on first and then
+        // this one, the query finds the result unless inputs changed
+        // since or a frame for this time was already under way
+        execLock.unlock();
+        _execFrameCallback(dt);
+        execLock.lock();
+
+        if (_terminated)
+        {
+            return _lastResult.points;
+        }
+
+        if (_IsResultFor(_lastResult, dt, simParams, dependentVertices))
+        {
+            return _lastResult.points;
+        }
+    }
+    else if (_execBatchCallback && IsBatchable())
+    {
+        // The batch stores its results through SetResult, which needs the
+        // lock.  Should the batch not cover this prim, or the module has
+        // no exec_sim_batch, fall back to stepping on our own
+        execLock.unlock();
+        _execBatchCallback(_moduleName, dt);
+        execLock.lock();
+
+        if (_terminated)
+        {
+            return _lastResult.points;
+        }
+
+        if (_IsResultFor(_lastResult, dt, simParams, dependentVertices))
+        {
+            return _lastResult.points;
+        }
+    }
+
+    // A bake keeps the frames seeking steps through on the way to dt
+    VtVec3fArray points = _StepTo(dt, dependentVertices, simParams,
+        [this](float frameTime, const VtVec3fArray& framePoints)
+        {
+            if (_simCacheWriter)
+            {
+                _simCacheWriter->WriteFrame(frameTime, framePoints);
+            }
+        });
+
+    _lastResult.valid = true;
+    _lastResult.time = dt;
+    _lastResult.simParams = std::move(simParams);
+    _lastResult.dependentVertices = std::move(dependentVertices);
+    _lastResult.points = points;
+
+    if (_simCacheWriter)
+    {
+        _simCacheWriter->WriteFrame(dt, points);
+    }
+
+    return points;
+}
+
+bool OmniWarpPythonModule::IsBatchable() const
+{
+    // results of a batch are keyed on stage time, and
+    // steps of a batch don't go through the checkpoints
+    return !_isNative && !_isAsync && _usdImagingSi && !_scheduled && _checkpointInterval == 0 && !_simCache;
+}
+
+VtVec3fArray OmniWarpPythonModule::GetDependentVertices()
+{
+    if (!_dependentVerticesCallback)
+    {
+        return VtVec3fArray();
+    }
+
+    // Terminated modules may outlive the scene index the callback calls
+    {
+        std::lock_guard<std::mutex> execLock(_execMutex);
+        if (_terminated)
+        {
+            return VtVec3fArray();
+        }
+    }
+
+    return _dependentVerticesCallback(_primPath);
+}
+
+bool OmniWarpPythonModule::HasResult(float time, const OmniWarpSimParamsConstPtr& simParams,
+    const VtVec3fArray& dependentVertices)
+{
+    std::lock_guard<std::mutex> execLock(_execMutex);
+    if (_terminated || _asyncStopping)
+    {
+        return true;
+    }
+
+    return _IsResultFor(_lastResult, time, simParams, dependentVertices);
+}
+
+bool OmniWarpPythonModule::_IsResultFor(const _ExecResult& result, float time,
+    const OmniWarpSimParamsConstPtr& simParams, const VtVec3fArray& dependentVertices) const
+{
+    // Cached parameters are shared, so unchanged ones match without
+    // comparing dictionaries.  VtArray equality checks for shared storage
+    // before comparing elements, so an unchanged dependent mesh is cheap
+    // to match too
+    return result.valid && result.time == time &&
+        (result.simParams == simParams || (result.simParams && simParams && *result.simParams == *simParams)) &&
+        result.dependentVertices == dependentVertices;
+}
+
+OmniWarpSimParamsConstPtr OmniWarpPythonModule::GetSimulationParams(
+    const std::function<VtDictionary()>& resolveSimParams)
+{
+    size_t version;
+    {
+        std::lock_guard<std::mutex> simParamsLock(_simParamsMutex);
+        if (_simParams)
+        {
+            return _simParams;
+        }
+        version = _simParamsVersion;
+    }
+
+    // Resolve without the lock, concurrent first queries may resolve
+    // the same parameters more than once but only one set is kept
+    OmniWarpSimParamsConstPtr simParams = std::make_shared<const VtDictionary>(resolveSimParams());
+
+    std::lock_guard<std::mutex> simParamsLock(_simParamsMutex);
+    if (_simParamsVersion != version)
+    {
+        // invalidated meanwhile, what was resolved may be stale
+        return simParams;
+    }
+    if (!_simParams)
+    {
+        _simParams = simParams;
+    }
+    return _simParams;
+}
+
+void OmniWarpPythonModule::InvalidateSimulationParams()
+{
+    std::lock_guard<std::mutex> simParamsLock(_simParamsMutex);
+    _simParams.reset();
+    _simParamsVersion++;
+}
+
+boost::python::object OmniWarpPythonModule::_GetPySimParams(const OmniWarpSimParamsConstPtr& simParams)
+{
+    if (!simParams)
+    {
+        return boost::python::object(VtDictionary());
+    }
+
+    if (simParams != _pySimParamsSource)
+    {
+        _pySimParams = TfPyObjWrapper(boost::python::object(*simParams));
+        _pySimParamsSource = simParams;
+    }
+    return _pySimParams.Get();
+}
+
+void OmniWarpPythonModule::SetResult(float time, OmniWarpSimParamsConstPtr simParams,
+    VtVec3fArray dependentVertices, VtVec3fArray points)
+{
+    std::lock_guard<std::mutex> execLock(_execMutex);
+    if (_terminated)
+    {
+        return;
+    }
+
+    _lastResult.valid = true;
+    _lastResult.time = time;
+    _lastResult.simParams = std::move(simParams);
+    _lastResult.dependentVertices = std::move(dependentVertices);
+    _lastResult.points = std::move(points);
+
+    if (_simCacheWriter)
+    {
+        _simCacheWriter->WriteFrame(time, _lastResult.points);
+    }
+}
+
+// Returns true if the python module implements the optional function
+// functionName.  Must be called with the GIL held, which also guards
+// the lookup table
+static bool
+_HasModuleFunction(const std::string& moduleName, const char* functionName)
+{
+    static std::unordered_map<std::string, bool> hasModuleFunction;
+    const std::string key = moduleName + "." + functionName;
+    auto it = hasModuleFunction.find(key);
+    if (it != hasModuleFunction.end())
+    {
+        return it->second;
+    }
+
+    bool result = false;
+    try
+    {
+        boost::python::object module = boost::python::import(moduleName.c_str());
+        result = PyObject_HasAttrString(module.ptr(), functionName) != 0;
+    }
+    catch (const boost::python::error_already_set&)
+    {
+        // the module failed to import, exec_sim reports that
+        PyErr_Clear();
+    }
+
+    hasModuleFunction[key] = result;
+    return result;
+}
+
+bool OmniWarpPythonModule::ExecSimBatch(const std::string& moduleName, float time,
+    const std::vector<std::shared_ptr<OmniWarpPythonModule>>& pythonModules,
+    const std::vector<VtVec3fArray>& dependentVertices,
+    const std::vector<OmniWarpSimParamsConstPtr>& simParams,
+    std::vector<VtVec3fArray>* results,
+    std::vector<bool>* hasResult)
+{
+    TfPyLock pyLock;
+    if (!_HasModuleFunction(moduleName, "exec_sim_batch"))
+    {
+        return false;
+    }
+
+    boost::python::list pyPrimPaths;
+    boost::python::list pyDependentVertices;
+    boost::python::list pySimParams;
+    for (size_t i = 0; i < pythonModules.size(); i++)
+    {
+        pyPrimPaths.append(pythonModules[i]->GetPrimPath());
+        pyDependentVertices.append(dependentVertices[i]);
+        pySimParams.append(pythonModules[i]->_GetPySimParams(simParams[i]));
+    }
+
+    results->clear();
+    results->resize(pythonModules.size());
+    hasResult->assign(pythonModules.size(), false);
+
+    boost::python::object result;
+    if (!TfPyInvokeAndReturn(moduleName.c_str(), "exec_sim_batch", &result,
+        pyPrimPaths, time, pyDependentVertices, pySimParams))
+    {
+        return false;
+    }
+
+    boost::python::extract<boost::python::list> theResultList(result);
+    if (!theResultList.check() || boost::python::len(result) != static_cast<long>(pythonModules.size()))
+    {
+        TF_WARN("exec_sim_batch of '%s' did not return a list of points per prim", moduleName.c_str());
+        return false;
+    }
+
+    boost::python::list resultList = theResultList();
+    for (size_t i = 0; i < pythonModules.size(); i++)
+    {
+        boost::python::extract<VtVec3fArray> thePoints(resultList[i]);
+        if (thePoints.check())
+        {
+            (*results)[i] = thePoints();
+            (*hasResult)[i] = true;
+        }
+        else
+        {
+            TF_WARN("exec_sim_batch of '%s' did not return points for prim <%s>",
+                moduleName.c_str(), pythonModules[i]->GetPrimPath().GetText());
+        }
+    }
+
+    return true;
+}
+
+VtVec3fArray OmniWarpPythonModule::_Step(float dt, const VtVec3fArray& dependentVertices,
+    const OmniWarpSimParamsConstPtr& simParams)
+{
+    VtVec3fArray points;
+    if (_isNative)
+    {
+        if (_nativeKernel)
+        {
+            static const VtDictionary noSimParams;
+            points = _nativeKernel->ExecSim(dt, dependentVertices, simParams ? *simParams : noSimParams);
+        }
+
+        return points;
+    }
+
+    TfPyLock pyLock;
+    boost::python::object result;
+    if (_HasModuleFunction(_moduleName, "exec_sim_into"))
+    {
+        return _StepInto(dt, dependentVertices, simParams);
+    }
+
+    if (TfPyInvokeAndReturn(_moduleName.c_str(), "exec_sim", &result, _primPath, dt, dependentVertices,
+        _GetPySimParams(simParams)))
     {
         boost::python::extract<VtVec3fArray> theResults(result);
         if (theResults.check())
         {
-            return theResults();
+            points = theResults();
+        }
+    }
+
+    return points;
+}
+
+VtVec3fArray OmniWarpPythonModule::_StepTo(float time, const VtVec3fArray& dependentVertices,
+    const OmniWarpSimParamsConstPtr& simParams, const std::function<void(float, const VtVec3fArray&)>& onFrameStepped)
+{
+    if (_checkpointStride <= 0)
+    {
+        return _Step(time, dependentVertices, simParams);
+    }
+
+    if (_scheduled)
+    {
+        // The inputs of a scheduled prim are the results of other warp
+        // prims, which are only known for the frame being stepped and not
+        // for the frames in between that seeking would step through.
+        // Start over from the current state should it stop being scheduled
+        _ReleaseCheckpoints();
+        return _Step(time, dependentVertices, simParams);
+    }
+
+    if (!_checkpointsStarted)
+    {
+        _checkpointsStarted = true;
+        _initialTime = time - 1.f;
+        _stateTime = _initialTime;
+        _checkpointSimParams = simParams;
+        if (!_SaveCheckpoint(&_initialCheckpoint, _initialTime, VtVec3fArray()))
+        {
+            // the simulation can't save its state
+            _checkpointStride = 0;
+            return _Step(time, dependentVertices, simParams);
+        }
+    }
+    else if (simParams != _checkpointSimParams &&
+        !(simParams && _checkpointSimParams && *simParams == *_checkpointSimParams))
+    {
+        // States saved with other parameters don't lead to the states
+        // of the new ones, only the state before the first step does
+        _DropCheckpoints();
+        _checkpointSimParams = simParams;
+    }
+
+    // There is no state before the first frame stepped, whose state
+    // stands in for earlier times.  Stepping the initial state to such a
+    // time would label a state of the first frame with an earlier time
+    time = std::max(time, _initialTime + 1.f);
+
+    // Going back, or ahead past a checkpoint saved before going back,
+    // restores the latest checkpoint at or before time
+    const _Checkpoint* checkpoint = &_initialCheckpoint;
+    auto it = _checkpoints.upper_bound(time);
+    if (it != _checkpoints.begin())
+    {
+        checkpoint = &std::prev(it)->second;
+    }
+
+    if (time <= _stateTime || checkpoint->time > _stateTime)
+    {
+        _RestoreCheckpoint(*checkpoint);
+        _stateTime = checkpoint->time;
+        if (checkpoint != &_initialCheckpoint && checkpoint->time == time)
+        {
+            return checkpoint->points;
+        }
+    }
+
+    // Step every frame up to time so the state doesn't depend on which
+    // frames were asked for.  Inputs are taken to be those at time
+    VtVec3fArray points;
+    for (float frameTime = _stateTime + 1.f; frameTime < time; frameTime += 1.f)
+    {
+        points = _Step(frameTime, dependentVertices, simParams);
+        _OnCheckpointStep(frameTime, points);
+        if (onFrameStepped)
+        {
+            onFrameStepped(frameTime, points);
+        }
+    }
+
+    points = _Step(time, dependentVertices, simParams);
+    _OnCheckpointStep(time, points);
+    return points;
+}
+
+void OmniWarpPythonModule::_OnCheckpointStep(float time, const VtVec3fArray& points)
+{
+    _stateTime = time;
+
+    const float frames = time - _initialTime;
+    const long frame = std::lround(frames);
+    if (frame <= 0 || std::fabs(frames - static_cast<float>(frame)) > 1e-3f ||
+        frame % _checkpointStride != 0 || _checkpoints.count(time))
+    {
+        return;
+    }
+
+    _Checkpoint checkpoint;
+    if (_SaveCheckpoint(&checkpoint, time, points))
+    {
+        _checkpoints.emplace(time, std::move(checkpoint));
+    }
+}
+
+bool OmniWarpPythonModule::_SaveCheckpoint(_Checkpoint* checkpoint, float time, const VtVec3fArray& points)
+{
+    size_t stateSize = 0;
+    if (_isNative)
+    {
+        if (!_nativeKernel || !_nativeKernel->SaveState(&checkpoint->nativeState, &stateSize))
+        {
+            return false;
+        }
+    }
+    else
+    {
+        TfPyLock pyLock;
+        if (!_HasModuleFunction(_moduleName, "save_state") || !_HasModuleFunction(_moduleName, "restore_state"))
+        {
+            return false;
+        }
+
+        boost::python::object result;
+        if (!TfPyInvokeAndReturn(_moduleName.c_str(), "save_state", &result, _primPath))
+        {
+            return false;
+        }
+
+        boost::python::extract<boost::python::tuple> theResult(result);
+        if (!theResult.check() || boost::python::len(result) != 2)
+        {
+            TF_WARN("save_state of '%s' did not return a (state, size) tuple", _moduleName.c_str());
+            return false;
+        }
+
+        boost::python::tuple stateAndSize = theResult();
+        boost::python::extract<size_t> theSize(stateAndSize[1]);
+        checkpoint->pyState = TfPyObjWrapper(stateAndSize[0]);
+        stateSize = theSize.check() ? theSize() : 0;
+    }
+
+    checkpoint->time = time;
+    checkpoint->points = points;
+    checkpoint->size = stateSize + points.size() * sizeof(GfVec3f);
+
+    // Over budget, keep every other checkpoint and save half as often,
+    // so the checkpoints still cover everything simulated so far
+    const size_t budget = static_cast<size_t>(std::max(0, TfGetEnvSetting(OMNI_WARP_CHECKPOINT_BUDGET_MB))) << 20;
+    while (checkpointBytes + checkpoint->size > budget && checkpoint != &_initialCheckpoint)
+    {
+        if (!_ThinCheckpoints())
+        {
+            return false;
+        }
+
+        if (std::lround(time - _initialTime) % _checkpointStride != 0)
+        {
+            return false;
+        }
+    }
+
+    checkpointBytes += checkpoint->size;
+    return true;
+}
+
+void OmniWarpPythonModule::_RestoreCheckpoint(const _Checkpoint& checkpoint)
+{
+    if (_isNative)
+    {
+        if (_nativeKernel)
+        {
+            _nativeKernel->RestoreState(checkpoint.nativeState);
+        }
+        return;
+    }
+
+    TfPyLock pyLock;
+    boost::python::object result;
+    TfPyInvokeAndReturn(_moduleName.c_str(), "restore_state", &result, _primPath, checkpoint.pyState.Get());
+}
+
+bool OmniWarpPythonModule::_ThinCheckpoints()
+{
+    if (_checkpoints.empty())
+    {
+        return false;
+    }
+
+    _checkpointStride *= 2;
+    for (auto it = _checkpoints.begin(); it != _checkpoints.end();)
+    {
+        if (std::lround(it->first - _initialTime) % _checkpointStride != 0)
+        {
+            checkpointBytes -= it->second.size;
+            it = _checkpoints.erase(it);
+        }
+        else
+        {
+            it++;
+        }
+    }
+    return true;
+}
+
+void OmniWarpPythonModule::_ReleaseCheckpoints()
+{
+    _DropCheckpoints();
+    checkpointBytes -= _initialCheckpoint.size;
+    _initialCheckpoint = _Checkpoint();
+    _checkpointsStarted = false;
+}
+
+void OmniWarpPythonModule::_DropCheckpoints()
+{
+    for (const auto& entry : _checkpoints)
+    {
+        checkpointBytes -= entry.second.size;
+    }
+    _checkpoints.clear();
+    if (_checkpointStride > 0)
+    {
+        _checkpointStride = _checkpointInterval;
+    }
+}
+
+VtVec3fArray OmniWarpPythonModule::_StepInto(float dt, const VtVec3fArray& dependentVertices,
+    const OmniWarpSimParamsConstPtr& simParams)
+{
+    // The module writes the points straight into one of our buffers
+    // through a writable memoryview, sized for as many points as the
+    // last step returned.  The buffers alternate, so the one written
+    // isn't the one handed out for the last frame, and data() only has
+    // to detach it if someone still holds on to an older frame
+    VtVec3fArray& outputPoints = _outputBuffers[_nextOutputBuffer];
+    if (outputPoints.size() != _outputPointCount)
+    {
+        outputPoints = VtVec3fArray(_outputPointCount);
+    }
+
+    static char emptyBuffer;
+    char* outputData = outputPoints.empty() ? &emptyBuffer : reinterpret_cast<char*>(outputPoints.data());
+    boost::python::object pyOutputPoints(boost::python::handle<>(PyMemoryView_FromMemory(
+        outputData, static_cast<Py_ssize_t>(outputPoints.size() * sizeof(GfVec3f)), PyBUF_WRITE)));
+
+    VtVec3fArray points;
+    boost::python::object result;
+    if (TfPyInvokeAndReturn(_moduleName.c_str(), "exec_sim_into", &result,
+        _primPath, dt, dependentVertices, _GetPySimParams(simParams), pyOutputPoints))
+    {
+        if (result.is_none())
+        {
+            // written in place
+            points = outputPoints;
+            _nextOutputBuffer = 1 - _nextOutputBuffer;
+        }
+        else
+        {
+            // first step, or the number of points changed
+            boost::python::extract<VtVec3fArray> theResults(result);
+            if (theResults.check())
+            {
+                points = theResults();
+            }
+        }
+    }
+
+    // The memory belongs to the buffer, the module must not hold on to it
+    PyObject* released = PyObject_CallMethod(pyOutputPoints.ptr(), "release", nullptr);
+    if (released == nullptr)
+    {
+        PyErr_Clear();
+        TF_CODING_ERROR("exec_sim_into of '%s' kept a reference to out_points", _moduleName.c_str());
+        outputPoints = VtVec3fArray();
+    }
+    Py_XDECREF(released);
+
+    _outputPointCount = points.size();
+    return points;
+}
+
+VtVec3fArray OmniWarpPythonModule::_RequestAsyncStep(std::unique_lock<std::mutex>& execLock,
+    float dt, OmniWarpSimParamsConstPtr simParams, VtVec3fArray dependentVertices)
+{
+    if (!_asyncThread.joinable())
+    {
+        _asyncThread = std::thread(&OmniWarpPythonModule::_RunAsyncSteps, this);
+    }
+
+    // The time the frame after this one is stepped ahead for
+    const float previousTime = _lastResult.valid ? _lastResult.time : dt;
+    const float nextTime = dt + (dt > previousTime ? dt - previousTime : 1.f);
+
+    // A query for another time may replace the request for dt before the
+    // worker takes it up, its frame lands instead and dt is asked for again
+    do
+    {
+        // The frame for dt may already be under way, stepped ahead while
+        // the previous frame rendered
+        _frameLanded.wait(execLock, [this, dt]()
+        {
+            return !_asyncStepping || !_asyncSteppingPrefetch || _asyncSteppingTime != dt || _terminated;
+        });
+        if (_terminated || _asyncStopping)
+        {
+            return _lastResult.points;
+        }
+
+        if (_prefetchResult.valid && _prefetchResult.time == dt)
+        {
+            // The frame was stepped with the inputs of the previous query, it
+            // stands for this query's, so a later edit at dt steps again
+            _lastResult = std::move(_prefetchResult);
+            _lastResult.simParams = simParams;
+            _lastResult.dependentVertices = dependentVertices;
+            _prefetchResult = _ExecResult();
+            break;
+        }
+
+        // Step to dt and wait for it.  A step for dt another query
+        // requested is waited for rather than requested again
+        size_t requestId = 0;
+        if (_asyncRequest.valid && !_asyncRequest.prefetch && _asyncRequest.time == dt)
+        {
+            requestId = _asyncRequest.requestId;
+        }
+        else if (_asyncStepping && !_asyncSteppingPrefetch && _asyncSteppingTime == dt)
+        {
+            requestId = _asyncSteppingRequestId;
+        }
+        else
+        {
+            requestId = ++_asyncRequestId;
+            _asyncRequest = _ExecResult();
+            _asyncRequest.valid = true;
+            _asyncRequest.time = dt;
+            _asyncRequest.simParams = simParams;
+            _asyncRequest.dependentVertices = dependentVertices;
+            _asyncRequest.requestId = requestId;
+            _prefetchResult = _ExecResult();
+            _asyncRequested.notify_one();
+        }
+
+        _frameLanded.wait(execLock, [this, requestId]()
+        {
+            return _asyncLandedRequestId >= requestId || _terminated || _asyncStopping;
+        });
+        if (_terminated || _asyncStopping)
+        {
+            return _lastResult.points;
         }
     }
+    while (_lastResult.time != dt);
+
+    // Step the next frame while this one renders, unless
+    // another query already asked for a step
+    if (!_asyncRequest.valid)
+    {
+        _asyncRequest = _ExecResult();
+        _asyncRequest.valid = true;
+        _asyncRequest.time = nextTime;
+        _asyncRequest.simParams = std::move(simParams);
+        _asyncRequest.dependentVertices = std::move(dependentVertices);
+        _asyncRequest.prefetch = true;
+        _asyncRequested.notify_one();
+    }
+
+    return _lastResult.points;
+}
+
+void OmniWarpPythonModule::_RunAsyncSteps()
+{
+    std::unique_lock<std::mutex> execLock(_execMutex);
+    while (true)
+    {
+        _asyncRequested.wait(execLock, [this]() { return _asyncRequest.valid || _asyncStopping; });
+        if (_asyncStopping)
+        {
+            return;
+        }
+
+        _ExecResult request = std::move(_asyncRequest);
+        _asyncRequest = _ExecResult();
+        _asyncStepping = true;
+        _asyncSteppingTime = request.time;
+        _asyncSteppingPrefetch = request.prefetch;
+        _asyncSteppingRequestId = request.requestId;
 
-    return VtVec3fArray();
+        // The writer is guarded by the lock, which isn't held while stepping
+        execLock.unlock();
+        VtVec3fArray points = _StepTo(request.time, request.dependentVertices, request.simParams,
+            [this](float frameTime, const VtVec3fArray& framePoints)
+            {
+                std::lock_guard<std::mutex> writerLock(_execMutex);
+                if (_simCacheWriter)
+                {
+                    _simCacheWriter->WriteFrame(frameTime, framePoints);
+                }
+            });
+        execLock.lock();
+
+        _asyncStepping = false;
+        request.points = points;
+        if (_simCacheWriter)
+        {
+            _simCacheWriter->WriteFrame(request.time, points);
+        }
+        if (request.prefetch)
+        {
+            _prefetchResult = std::move(request);
+        }
+        else
+        {
+            _asyncLandedRequestId = request.requestId;
+            _lastResult = std::move(request);
+        }
+        _frameLanded.notify_all();
+
+        // The callback must not call back into the module
+        if (_frameLandedCallback)
+        {
+            execLock.unlock();
+            _frameLandedCallback(_primPath);
+            execLock.lock();
+        }
+    }
 }
 
 PXR_NAMESPACE_CLOSE_SCOPE
\ No newline at end of file
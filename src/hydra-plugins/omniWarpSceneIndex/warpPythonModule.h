@@ -16,46 +16,286 @@
 #ifndef OMNI_WARP_SCENE_INDEX_WARP_PYTHON_MODULE_H
 #define OMNI_WARP_SCENE_INDEX_WARP_PYTHON_MODULE_H
 
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
+#include <vector>
 
 #include <pxr/pxr.h>
 #include <pxr/base/tf/declarePtrs.h>
+#include <pxr/base/tf/pyObjWrapper.h>
 #include <pxr/base/vt/value.h>
 #include <pxr/imaging/hd/meshSchema.h>
 #include <pxr/usdImaging/usdImaging/stageSceneIndex.h>
 
 #include "api.h"
+#include "warpNativeKernel.h"
+#include "warpSimCache.h"
 
 PXR_NAMESPACE_OPEN_SCOPE
 
 TF_DECLARE_REF_PTRS(OmniWarpPythonModule);
 
+// Simulation parameters are shared rather than copied between the cache
+// of a prim, the results keyed on them and the python dict made from them
+using OmniWarpSimParamsConstPtr = std::shared_ptr<const VtDictionary>;
+
 ///
 /// \class OmniWarpPythonModule
 ///
+/// Drives the simulation of one prim through the warp python module named
+/// by warp:sourceFile, or through a native kernel if the name has the
+/// form "native:<kernel name>" (see OmniWarpNativeKernelRegistry).
+///
+/// With OMNI_WARP_ASYNC_SIM set, steps run on a worker thread of the
+/// module.  Once ExecSim has the frame for the current stage time, the
+/// worker steps the next frame while the current one renders, so during
+/// playback a query finds its frame stepped (or under way) already and a
+/// frame takes the longer of simulation and rendering rather than both.
+/// A query never returns the frame of another time, so a paused timeline
+/// shows the frame of its time without further notices.  The frame landed
+/// callback is invoked on the worker whenever a new frame is available.
+///
+/// Synchronous python modules step as part of a batch where the module
+/// implements exec_sim_batch: the first query for a new stage time calls
+/// the exec batch callback, which steps every prim using the same python
+/// module at once (see ExecSimBatch) and stores each prim's result with
+/// SetResult, where the query then finds it.
 ///
+/// Prims depending on other warp prims are scheduled instead: the first
+/// query for a new stage time calls the exec frame callback, which steps
+/// every scheduled prim in dependency order.  The points of the prims
+/// a module depends on come from the dependent vertices callback.
 ///
+/// With OMNI_WARP_CHECKPOINT_INTERVAL set, the state of simulations
+/// that can save it (save_state and restore_state in python, SaveState
+/// and RestoreState of native kernels) is saved every that many frames
+/// of stage time, within OMNI_WARP_CHECKPOINT_BUDGET_MB for all modules.
+/// Seeking to a time restores the latest checkpoint at or before it and
+/// steps forward frame by frame from there, see _StepTo.  Times before
+/// the first frame stepped show that frame.  Scheduled modules don't
+/// checkpoint, their inputs for the frames stepped through aren't known.
 ///
+/// With OMNI_WARP_SIM_CACHE set to "bake", every step is also written to
+/// a cache file of the prim in OMNI_WARP_SIM_CACHE_DIR, the frames a seek
+/// steps through included, which is finished when the module is
+/// terminated.  Set to "playback", the module doesn't
+/// simulate at all and serves each stage time from the prim's cache file
+/// instead (see OmniWarpSimCache).
+///
+/// The simulation parameters of the prim are resolved once and cached
+/// along with their python form, until InvalidateSimulationParams is
+/// called for a change of the simulationParams locator.
 ///
 class OmniWarpPythonModule
 {
 public:
+    typedef std::function<void(const SdfPath&)> FrameLandedCallback;
+    typedef std::function<void(const std::string&, float)> ExecBatchCallback;
+    typedef std::function<void(float)> ExecFrameCallback;
+    typedef std::function<VtVec3fArray(const SdfPath&)> DependentVerticesCallback;
+
     OmniWarpPythonModule(const SdfPath &primPath, const std::string& moduleName,
-        UsdImagingStageSceneIndexConstRefPtr usdImagingSi);
+        const SdfPath &simParamsPath,
+        UsdImagingStageSceneIndexConstRefPtr usdImagingSi,
+        const FrameLandedCallback& frameLandedCallback = FrameLandedCallback(),
+        const ExecBatchCallback& execBatchCallback = ExecBatchCallback(),
+        const ExecFrameCallback& execFrameCallback = ExecFrameCallback(),
+        const DependentVerticesCallback& dependentVerticesCallback = DependentVerticesCallback());
     ~OmniWarpPythonModule();
 
-    void InitMesh(VtIntArray indices, VtVec3fArray vertices,
-        VtIntArray depIndices, VtVec3fArray depVertices, VtDictionary simParams);
-    void InitParticles(VtVec3fArray positions,
-        VtIntArray depIndices, VtVec3fArray depVertices, VtDictionary simParams);
+    void InitMesh(const VtIntArray& indices, const VtVec3fArray& vertices,
+        const VtIntArray& depIndices, const VtVec3fArray& depVertices, const VtDictionary& simParams);
+    void InitParticles(const VtVec3fArray& positions,
+        const VtIntArray& depIndices, const VtVec3fArray& depVertices, const VtDictionary& simParams);
+
+    VtVec3fArray ExecSim(OmniWarpSimParamsConstPtr simParams);
+    VtVec3fArray ExecSim(OmniWarpSimParamsConstPtr simParams, VtVec3fArray dependentVertices);
+
+    // Returns the cached simulation parameters of the prim,
+    // calling resolveSimParams only if there are none yet
+    OmniWarpSimParamsConstPtr GetSimulationParams(const std::function<VtDictionary()>& resolveSimParams);
+
+    // Drops the cached simulation parameters, the next
+    // GetSimulationParams resolves them again
+    void InvalidateSimulationParams();
+
+    // Waits for an in-flight ExecSim and terminates the simulation.
+    // Data sources may still hold the module afterwards, further steps
+    // return the last points without calling into the simulation
+    void Terminate();
+
+    const std::string& GetModuleName() const { return _moduleName; }
+    const SdfPath& GetPrimPath() const { return _primPath; }
+
+    // The prim holding the simulation parameters, which for
+    // an instancer is its prototype with the WarpComputationAPI
+    const SdfPath& GetSimulationParamsPath() const { return _simParamsPath; }
+
+    // True if the module steps synchronously through python
+    // and so can take part in a batch
+    bool IsBatchable() const;
+
+    // True if steps are keyed on stage time rather than emulating
+    // frame time, which is needed to order them with other prims
+    bool StepsOnStageTime() const { return bool(_usdImagingSi); }
+
+    // Scheduled modules step in dependency order with the other
+    // scheduled modules instead of on their own or in a batch
+    void SetScheduled(bool scheduled) { _scheduled = scheduled; }
+    bool IsScheduled() const { return _scheduled; }
+
+    // Returns the current points of the prims the simulation depends on
+    VtVec3fArray GetDependentVertices();
+
+    // True if a step for time with the given inputs has already been
+    // done, or the module was terminated and won't step any more
+    bool HasResult(float time, const OmniWarpSimParamsConstPtr& simParams, const VtVec3fArray& dependentVertices);
+
+    // Stores the result of a step made on behalf of the module by a batch
+    void SetResult(float time, OmniWarpSimParamsConstPtr simParams, VtVec3fArray dependentVertices,
+        VtVec3fArray points);
 
-    VtVec3fArray ExecSim(VtDictionary simParams);
-    VtVec3fArray ExecSim(VtDictionary simParams, VtVec3fArray dependentVertices);
+    // Steps all the given modules, which must use the python module
+    // moduleName, in one call to its exec_sim_batch under a single GIL
+    // acquisition.  Returns false without stepping anything if the
+    // module doesn't implement it, and false if the call raised or didn't
+    // return a list with an element per module, in which case each module
+    // steps on its own.  Otherwise hasResult tells which elements of
+    // results held points, modules without one step on their own too
+    static bool ExecSimBatch(const std::string& moduleName, float time,
+        const std::vector<std::shared_ptr<OmniWarpPythonModule>>& pythonModules,
+        const std::vector<VtVec3fArray>& dependentVertices,
+        const std::vector<OmniWarpSimParamsConstPtr>& simParams,
+        std::vector<VtVec3fArray>* results,
+        std::vector<bool>* hasResult);
 
 private:
+    VtVec3fArray _Step(float dt, const VtVec3fArray& dependentVertices, const OmniWarpSimParamsConstPtr& simParams);
+    // Steps to time, seeking through the checkpoints if enabled.  Seeking
+    // steps the frames before time too, each is handed to onFrameStepped
+    VtVec3fArray _StepTo(float time, const VtVec3fArray& dependentVertices, const OmniWarpSimParamsConstPtr& simParams,
+        const std::function<void(float, const VtVec3fArray&)>& onFrameStepped);
+    VtVec3fArray _StepInto(float dt, const VtVec3fArray& dependentVertices, const OmniWarpSimParamsConstPtr& simParams);
+    VtVec3fArray _RequestAsyncStep(std::unique_lock<std::mutex>& execLock,
+        float dt, OmniWarpSimParamsConstPtr simParams, VtVec3fArray dependentVertices);
+    void _RunAsyncSteps();
+
+    // Returns the python dict for simParams, converted only when the
+    // parameters change.  Must be called with the GIL held
+    boost::python::object _GetPySimParams(const OmniWarpSimParamsConstPtr& simParams);
+
+    // The result of the last step, reused for any further query at the
+    // same stage time with the same inputs (extent computation, motion
+    // blur samples, a second render delegate) instead of stepping again
+    struct _ExecResult
+    {
+        bool valid = false;
+        float time = 0.f;
+        OmniWarpSimParamsConstPtr simParams;
+        VtVec3fArray dependentVertices;
+        VtVec3fArray points;
+
+        // asynchronous steps only: whether the step was asked for ahead
+        // of its query, and the id of the query's request otherwise
+        bool prefetch = false;
+        size_t requestId = 0;
+    };
+
+    bool _IsResultFor(const _ExecResult& result, float time, const OmniWarpSimParamsConstPtr& simParams,
+        const VtVec3fArray& dependentVertices) const;
+
+    // A saved simulation state and the points of the step it was saved after
+    struct _Checkpoint
+    {
+        float time = 0.f;
+        size_t size = 0;
+        VtValue nativeState;
+        TfPyObjWrapper pyState;
+        VtVec3fArray points;
+    };
+
+    bool _SaveCheckpoint(_Checkpoint* checkpoint, float time, const VtVec3fArray& points);
+    void _RestoreCheckpoint(const _Checkpoint& checkpoint);
+    void _OnCheckpointStep(float time, const VtVec3fArray& points);
+    bool _ThinCheckpoints();
+    void _DropCheckpoints();
+    void _ReleaseCheckpoints();
+
         std::string _moduleName;
         SdfPath _primPath;
+        SdfPath _simParamsPath;
         UsdImagingStageSceneIndexConstRefPtr _usdImagingSi;
+
+        // set for "native:" module names, the kernel is null
+        // if no kernel of that name was registered
+        bool _isNative;
+        OmniWarpNativeKernelUniquePtr _nativeKernel;
+
+        bool _terminated;
+
+        std::mutex _execMutex;
+        _ExecResult _lastResult;
+
+        // asynchronous stepping, the request holds the inputs of the
+        // next step for the worker and is guarded by _execMutex.  The
+        // frame after the last queried one lands in _prefetchResult
+        bool _isAsync;
+        FrameLandedCallback _frameLandedCallback;
+        _ExecResult _asyncRequest;
+        _ExecResult _prefetchResult;
+        bool _asyncStopping;
+        bool _asyncStepping;
+        float _asyncSteppingTime;
+        bool _asyncSteppingPrefetch;
+        size_t _asyncSteppingRequestId;
+        size_t _asyncRequestId;
+        size_t _asyncLandedRequestId;
+        std::condition_variable _asyncRequested;
+        std::condition_variable _frameLanded;
+        std::thread _asyncThread;
+
+        ExecBatchCallback _execBatchCallback;
+        ExecFrameCallback _execFrameCallback;
+        DependentVerticesCallback _dependentVerticesCallback;
+        std::atomic<bool> _scheduled;
+
+        // the version counts invalidations, so parameters resolved while
+        // an invalidation came in aren't cached over the newer ones
+        std::mutex _simParamsMutex;
+        OmniWarpSimParamsConstPtr _simParams;
+        size_t _simParamsVersion;
+
+        // python form of _pySimParamsSource, guarded by the GIL
+        OmniWarpSimParamsConstPtr _pySimParamsSource;
+        TfPyObjWrapper _pySimParams;
+
+        // checkpoints, only used by whichever thread steps the simulation.
+        // The initial checkpoint holds the state before the first step,
+        // as if it were the frame before, and is kept regardless of budget
+        int _checkpointInterval;
+        int _checkpointStride;
+        bool _checkpointsStarted;
+        float _initialTime;
+        float _stateTime;
+        OmniWarpSimParamsConstPtr _checkpointSimParams;
+        _Checkpoint _initialCheckpoint;
+        std::map<float, _Checkpoint> _checkpoints;
+
+        // simulation cache of the prim, guarded by _execMutex.  The module
+        // either plays back the cache or bakes its steps into the writer
+        std::unique_ptr<OmniWarpSimCache> _simCache;
+        std::unique_ptr<OmniWarpSimCacheWriter> _simCacheWriter;
+
+        // buffers modules implementing exec_sim_into write their points to
+        VtVec3fArray _outputBuffers[2];
+        size_t _nextOutputBuffer;
+        size_t _outputPointCount;
 };
 
 using OmniWarpPythonModuleSharedPtr = std::shared_ptr<class OmniWarpPythonModule>;
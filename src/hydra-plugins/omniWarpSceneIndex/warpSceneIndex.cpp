@@ -13,6 +13,8 @@
 // limitations under the License.
 //
 
+#include <algorithm>
+#include <functional>
 #include <string>
 
 #include <pxr/base/tf/pyInvoke.h>
@@ -25,6 +27,7 @@
 #include <pxr/imaging/hd/tokens.h>
 #include <pxr/imaging/hd/meshSchema.h>
 #include "pxr/imaging/hd/instancerTopologySchema.h"
+#include <pxr/base/work/loops.h>
 
 #include "warpSceneIndex.h"
 #include "tokens.h"
@@ -60,6 +63,35 @@ GetSimulationParams(HdContainerDataSourceHandle ds)
     return vtSimParams;
 }
 
+// Resolving the parameters walks the warp computation container and
+// copies its dictionary, so data sources go through the cache of the
+// module, which is only dropped when the parameters are dirtied
+static OmniWarpSimParamsConstPtr
+GetCachedSimulationParams(const OmniWarpPythonModuleSharedPtr& pythonModule, HdContainerDataSourceHandle ds)
+{
+    return pythonModule->GetSimulationParams([&ds]() { return GetSimulationParams(ds); });
+}
+
+// Returns the points primvar of a prim at the current frame of the input scene
+static VtVec3fArray
+GetPrimPoints(HdContainerDataSourceHandle ds)
+{
+    HdPrimvarsSchema primVarsSchema = HdPrimvarsSchema::GetFromParent(ds);
+    if (primVarsSchema)
+    {
+        HdPrimvarSchema primVar = primVarsSchema.GetPrimvar(HdTokens->points);
+        if (primVar)
+        {
+            VtValue pointsVt = primVar.GetPrimvarValue()->GetValue(0.f);
+            if (pointsVt.IsHolding<VtVec3fArray>())
+            {
+                return pointsVt.UncheckedGet<VtVec3fArray>();
+            }
+        }
+    }
+    return VtVec3fArray();
+}
+
 static UsdImagingStageSceneIndexRefPtr
 FindUsdImagingSceneIndex(const std::vector<HdSceneIndexBaseRefPtr>& inputScenes)
 {
@@ -96,10 +128,66 @@ OmniWarpSceneIndex::New(
 
 OmniWarpSceneIndex::OmniWarpSceneIndex(
     const HdSceneIndexBaseRefPtr &inputSceneIndex)
-  : HdSingleInputFilteringSceneIndexBase(inputSceneIndex)
+  : HdSingleInputFilteringSceneIndexBase(inputSceneIndex),
+    _warpFrameStarted(false),
+    _warpFrameTime(0.f),
+    _callbackGuard(std::make_shared<_CallbackGuard>(this))
 {
 }
 
+OmniWarpSceneIndex::~OmniWarpSceneIndex()
+{
+    // Data sources may outlive the scene index, make sure no module
+    // calls back into it after this.  Nothing is locked while waiting
+    // for the calls in flight, they take the locks of the scene index
+    _callbackGuard->Close();
+
+    std::lock_guard<std::mutex> mapLock(_pythonModuleMapMutex);
+    for (const SdfPath& modulePath : _pythonModulePaths)
+    {
+        OmniWarpPythonModuleSharedPtr pythonModule = GetWarpPythonModule(modulePath);
+        if (pythonModule)
+        {
+            pythonModule->Terminate();
+        }
+    }
+}
+
+OmniWarpSceneIndex::_CallbackGuard::_CallbackGuard(OmniWarpSceneIndex* sceneIndex)
+  : _sceneIndex(sceneIndex),
+    _callsInFlight(0)
+{
+}
+
+void
+OmniWarpSceneIndex::_CallbackGuard::Close()
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    _sceneIndex = nullptr;
+    _idle.wait(lock, [this]() { return _callsInFlight == 0; });
+}
+
+OmniWarpSceneIndex*
+OmniWarpSceneIndex::_CallbackGuard::_Enter()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_sceneIndex)
+    {
+        _callsInFlight++;
+    }
+    return _sceneIndex;
+}
+
+void
+OmniWarpSceneIndex::_CallbackGuard::_Exit()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (--_callsInFlight == 0)
+    {
+        _idle.notify_all();
+    }
+}
+
 /// A convenience data source implementing the primvar schema from
 /// a triple of primvar value, interpolation and role. The latter two
 /// are given as tokens. The value can be given either as data source
@@ -161,19 +249,8 @@ public:
 
     VtVec3fArray GetTypedValue(const Time shutterOffset) override
     {
-        HdPrimvarsSchema depPrimVarsSchema = HdPrimvarsSchema::GetFromParent(_depDs);
-        if (depPrimVarsSchema)
-        {
-            HdPrimvarSchema depPrimVar = depPrimVarsSchema.GetPrimvar(HdTokens->points);
-            if (depPrimVar)
-            {
-                HdSampledDataSourceHandle valueDataSource = depPrimVar.GetPrimvarValue();
-                auto pointsVt = valueDataSource->GetValue(0.f);
-                VtVec3fArray pointsArray =  pointsVt.UncheckedGet<VtArray<GfVec3f>>();
-                return _pythonModule->ExecSim(GetSimulationParams(_simParamsDs), pointsArray);
-            }
-        }
-        return _pythonModule->ExecSim(GetSimulationParams(_simParamsDs));
+        return _pythonModule->ExecSim(GetCachedSimulationParams(_pythonModule, _simParamsDs),
+            _pythonModule->GetDependentVertices());
     }
 
     bool GetContributingSampleTimesForInterval(
@@ -187,17 +264,14 @@ public:
 private:
 
     _PointsDataSource(HdPrimvarsSchema &primVarSchema, OmniWarpPythonModuleSharedPtr pythonModule,
-        const HdContainerDataSourceHandle &simParamsDataSource,
-        const HdContainerDataSourceHandle &depDataSource)
+        const HdContainerDataSourceHandle &simParamsDataSource)
         : _schema(primVarSchema),
           _pythonModule(pythonModule),
-          _simParamsDs(simParamsDataSource),
-          _depDs(depDataSource)
+          _simParamsDs(simParamsDataSource)
     {
     }
     HdPrimvarsSchema& _schema;
     OmniWarpPythonModuleSharedPtr _pythonModule;
-    HdContainerDataSourceHandle const _depDs;
     HdContainerDataSourceHandle const _simParamsDs;
 };
 
@@ -212,19 +286,8 @@ public:
 
     VtVec3fArray GetTypedValue(const Time shutterOffset) override
     {
-        HdPrimvarsSchema depPrimVarsSchema = HdPrimvarsSchema::GetFromParent(_depDs);
-        if (depPrimVarsSchema)
-        {
-            HdPrimvarSchema depPrimVar = depPrimVarsSchema.GetPrimvar(HdTokens->points);
-            if (depPrimVar)
-            {
-                HdSampledDataSourceHandle valueDataSource = depPrimVar.GetPrimvarValue();
-                auto pointsVt = valueDataSource->GetValue(0.f);
-                VtVec3fArray pointsArray =  pointsVt.UncheckedGet<VtArray<GfVec3f>>();
-                return _pythonModule->ExecSim(GetSimulationParams(_simParamsDs), pointsArray);
-            }
-        }
-        return _pythonModule->ExecSim(GetSimulationParams(_simParamsDs));
+        return _pythonModule->ExecSim(GetCachedSimulationParams(_pythonModule, _simParamsDs),
+            _pythonModule->GetDependentVertices());
     }
 
     bool GetContributingSampleTimesForInterval(
@@ -238,16 +301,13 @@ public:
 private:
 
     _InstancePositionsDataSource(HdPrimvarsSchema &primVarSchema, OmniWarpPythonModuleSharedPtr pythonModule,
-        const HdContainerDataSourceHandle &depDataSource,
         const HdContainerDataSourceHandle &simParamsDataSource)
         : _schema(primVarSchema),
           _pythonModule(pythonModule),
-          _depDs(depDataSource),
           _simParamsDs(simParamsDataSource)
     {
     }
     HdPrimvarsSchema& _schema;
-    HdContainerDataSourceHandle _depDs;
     HdContainerDataSourceHandle _simParamsDs;
     OmniWarpPythonModuleSharedPtr _pythonModule;
 };
@@ -270,7 +330,7 @@ public:
         if (name == HdTokens->points)
         {
             return _PrimvarDataSource::New(
-                _PointsDataSource::New(_schema, _pythonModule, _simParamsDs, _depDs),
+                _PointsDataSource::New(_schema, _pythonModule, _simParamsDs),
                 HdPrimvarSchemaTokens->vertex,
                 HdPrimvarSchemaTokens->point);
         }
@@ -281,19 +341,16 @@ public:
 private:
     _MeshPrimVarsOverrideDataSource(const HdContainerDataSourceHandle &primDataSource,
         HdPrimvarsSchema &primVarSchema, OmniWarpPythonModuleSharedPtr pythonModule,
-        const HdContainerDataSourceHandle &simParamsDataSource,
-        const HdContainerDataSourceHandle &depDataSource)
+        const HdContainerDataSourceHandle &simParamsDataSource)
       :  _schema(primVarSchema),
         _pythonModule(pythonModule),
         _inputDs(primDataSource),
-        _simParamsDs(simParamsDataSource),
-        _depDs(depDataSource)
+        _simParamsDs(simParamsDataSource)
     {
     }
 
     HdPrimvarsSchema _schema;
     OmniWarpPythonModuleSharedPtr _pythonModule;
-    HdContainerDataSourceHandle const _depDs;
     HdContainerDataSourceHandle const _inputDs;
     HdContainerDataSourceHandle const _simParamsDs;
 };
@@ -316,7 +373,7 @@ public:
         if (name == HdInstancerTokens->translate)
         {
             return _PrimvarDataSource::New(
-                _InstancePositionsDataSource::New(_schema, _pythonModule, _depDs, _simParamsDs),
+                _InstancePositionsDataSource::New(_schema, _pythonModule, _simParamsDs),
                  HdPrimvarSchemaTokens->instance,
                  HdPrimvarRoleTokens->vector);
         }
@@ -327,18 +384,15 @@ public:
 private:
     _InstancerPrimVarsOverrideDataSource(const HdContainerDataSourceHandle &primDataSource,
         HdPrimvarsSchema &primVarSchema, OmniWarpPythonModuleSharedPtr pythonModule,
-        const HdContainerDataSourceHandle &depDataSource,
         const HdContainerDataSourceHandle &simParamsDataSource)
       :  _schema(primVarSchema),
         _pythonModule(pythonModule),
         _inputDs(primDataSource),
-        _depDs(depDataSource),
         _simParamsDs(simParamsDataSource)
     {
     }
 
     HdPrimvarsSchema _schema;
-	HdContainerDataSourceHandle _depDs;
     OmniWarpPythonModuleSharedPtr _pythonModule;
     HdContainerDataSourceHandle const _inputDs;
     HdContainerDataSourceHandle const _simParamsDs;
@@ -368,7 +422,7 @@ public:
             auto primVarSchema = HdPrimvarsSchema::GetFromParent(_inputDs);
             if (auto primVarContainer = HdContainerDataSource::Cast(result))
             {
-                return _MeshPrimVarsOverrideDataSource::New(primVarContainer, primVarSchema, _pythonModule, _inputDs, _depDs);
+                return _MeshPrimVarsOverrideDataSource::New(primVarContainer, primVarSchema, _pythonModule, _inputDs);
             }
         }
         return result;
@@ -377,16 +431,13 @@ public:
 private:
     _WarpMeshDataSource(const SdfPath& primPath,
         const HdContainerDataSourceHandle &primDataSource,
-        OmniWarpPythonModuleSharedPtr pythonModule,
-        const HdContainerDataSourceHandle &depDataSource)
+        OmniWarpPythonModuleSharedPtr pythonModule)
       : _primPath(primPath),
         _inputDs(primDataSource),
-        _pythonModule(pythonModule),
-        _depDs(depDataSource)
+        _pythonModule(pythonModule)
     {
     }
 
-    HdContainerDataSourceHandle _depDs;
     HdContainerDataSourceHandle _inputDs;
     OmniWarpPythonModuleSharedPtr _pythonModule;
 
@@ -416,7 +467,7 @@ public:
             auto primVarSchema = HdPrimvarsSchema::GetFromParent(_inputDs);
             if (auto primVarContainer = HdContainerDataSource::Cast(result))
             {
-                return _InstancerPrimVarsOverrideDataSource::New(primVarContainer, primVarSchema, _pythonModule, _depDs, _simParamsDs);
+                return _InstancerPrimVarsOverrideDataSource::New(primVarContainer, primVarSchema, _pythonModule, _simParamsDs);
             }
         }
         return result;
@@ -426,18 +477,15 @@ private:
     _WarpInstancerDataSource(const SdfPath& primPath,
         const HdContainerDataSourceHandle &primDataSource,
         OmniWarpPythonModuleSharedPtr pythonModule,
-        const HdContainerDataSourceHandle &depDataSource,
         const HdContainerDataSourceHandle &simParamsDataSource)
       : _primPath(primPath),
         _inputDs(primDataSource),
         _pythonModule(pythonModule),
-        _depDs(depDataSource),
         _simParamsDs(simParamsDataSource)
     {
     }
 
     HdContainerDataSourceHandle _inputDs;
-	HdContainerDataSourceHandle _depDs;
     HdContainerDataSourceHandle _simParamsDs;
     OmniWarpPythonModuleSharedPtr _pythonModule;
 
@@ -453,21 +501,13 @@ OmniWarpSceneIndex::GetPrim(const SdfPath& primPath) const
     {
         if (OmniWarpComputationSchema warpSchema = OmniWarpComputationSchema::GetFromParent(prim.dataSource))
         {
-            HdContainerDataSourceHandle _depDs;
-            if (HdPathArrayDataSourceHandle dependentsDs = warpSchema.GetDependentPrims())
+            // The module may not exist yet, or was just removed by a notice
+            // processed on another thread, leave the prim as it is until then
+            if (OmniWarpPythonModuleSharedPtr pythonModule = GetWarpPythonModule(primPath))
             {
-                VtArray<SdfPath> dependentPrims = dependentsDs->GetTypedValue(0);
-                if (dependentPrims.size())
-                {
-                    auto depPrim = _GetInputSceneIndex()->GetPrim(dependentPrims[0]);
-                    if (depPrim.dataSource)
-                    {
-                        _depDs = depPrim.dataSource;
-                    }
-                }
+                prim.dataSource = _WarpMeshDataSource::New(
+                    primPath, prim.dataSource, pythonModule);
             }
-            prim.dataSource = _WarpMeshDataSource::New(
-                primPath, prim.dataSource, GetWarpPythonModule(primPath), _depDs);
         }
     }
     else if (prim.primType == HdPrimTypeTokens->instancer && prim.dataSource)
@@ -482,22 +522,11 @@ OmniWarpSceneIndex::GetPrim(const SdfPath& primPath) const
                 OmniWarpComputationSchema warpSchema = OmniWarpComputationSchema::GetFromParent(protoPrim.dataSource);
                 if (warpSchema)
                 {
-                    // Look for particles to be dependent on a mesh
-                    HdContainerDataSourceHandle _depDs;
-                    if (HdPathArrayDataSourceHandle dependentsDs = warpSchema.GetDependentPrims())
+                    if (OmniWarpPythonModuleSharedPtr pythonModule = GetWarpPythonModule(primPath))
                     {
-                        VtArray<SdfPath> dependentPrims = dependentsDs->GetTypedValue(0);
-                        if (dependentPrims.size())
-                        {
-                            auto depPrim = _GetInputSceneIndex()->GetPrim(dependentPrims[0]);
-                            if (depPrim.dataSource)
-                            {
-                                _depDs = depPrim.dataSource;
-                            }
-                        }
+                        prim.dataSource = _WarpInstancerDataSource::New(
+                            primPath, prim.dataSource, pythonModule, protoPrim.dataSource);
                     }
-                    prim.dataSource = _WarpInstancerDataSource::New(
-                        primPath, prim.dataSource, GetWarpPythonModule(primPath), _depDs, protoPrim.dataSource);
                 }
             }
         }
@@ -520,6 +549,7 @@ void OmniWarpSceneIndex::_PrimsAdded(
         return;
     }
 
+    std::unique_lock<std::mutex> mapLock(_pythonModuleMapMutex);
     for (const HdSceneIndexObserver::AddedPrimEntry& entry : entries)
     {
         if (entry.primType == HdPrimTypeTokens->mesh)
@@ -544,7 +574,8 @@ void OmniWarpSceneIndex::_PrimsAdded(
                 }
                 auto vtSimParams = GetSimulationParams(prim.dataSource);
                 HdPrimvarSchema origPoints = primVarsSchema.GetPrimvar(HdTokens->points);
-                CreateWarpPythonModule(entry.primPath, warpSchema, meshTopologySchema, origPoints, usdImagingSi, vtSimParams);
+                CreateWarpPythonModule(entry.primPath, warpSchema, meshTopologySchema, origPoints, usdImagingSi,
+                    entry.primPath, vtSimParams);
             }
         }
         else if (entry.primType == HdPrimTypeTokens->instancer)
@@ -579,13 +610,16 @@ void OmniWarpSceneIndex::_PrimsAdded(
                         }
                         auto vtSimParams = GetSimulationParams(protoPrim.dataSource);
                         HdPrimvarSchema positionsPos = primVarSchema.GetPrimvar(HdInstancerTokens->translate);
-                        CreateWarpPythonModule(entry.primPath, warpSchema, positionsPos, usdImagingSi, vtSimParams);
+                        CreateWarpPythonModule(entry.primPath, warpSchema, positionsPos, usdImagingSi,
+                            protoTypes[i], vtSimParams);
                         break;
                     }
                 }
             }
         }
     }
+    RebuildWarpDependencyGraph();
+    mapLock.unlock();
 
     _SendPrimsAdded(entries);
     return;
@@ -600,23 +634,29 @@ OmniWarpSceneIndex::_PrimsRemoved(
         return;
     }
 
-    _WarpPythonModuleMap::iterator it = _pythonModuleMap.begin();
-    while (it != _pythonModuleMap.end())
     {
-        bool bErased = false;
-        for (const HdSceneIndexObserver::RemovedPrimEntry& entry : entries)
+        std::lock_guard<std::mutex> mapLock(_pythonModuleMapMutex);
+
+        // Retiring a module erases its path from the paths
+        // iterated, so collect the modules to remove first
+        SdfPathVector removedPaths;
+        for (const SdfPath& modulePath : _pythonModulePaths)
         {
-            if (it->first.HasPrefix(entry.primPath))
+            for (const HdSceneIndexObserver::RemovedPrimEntry& entry : entries)
             {
-                bErased = true;
-                it = _pythonModuleMap.erase(it);
-                break;
+                if (modulePath.HasPrefix(entry.primPath))
+                {
+                    removedPaths.push_back(modulePath);
+                    break;
+                }
             }
         }
-        if (!bErased)
+
+        for (const SdfPath& removedPath : removedPaths)
         {
-            it++;
+            RetireWarpPythonModule(removedPath);
         }
+        RebuildWarpDependencyGraph();
     }
 
     _SendPrimsRemoved(entries);
@@ -644,42 +684,474 @@ OmniWarpSceneIndex::_PrimsDirtied(
     // remove our _pythonModule for this prim and allow
     // it to be re-created
 
-    //+++ Multithreaded access to _pythonModuleMap
-    _WarpPythonModuleMap::iterator it = _pythonModuleMap.begin();
-    while (it != _pythonModuleMap.end())
     {
-        bool bErased = false;
-        for (const HdSceneIndexObserver::DirtiedPrimEntry &entry : entries)
+        std::lock_guard<std::mutex> mapLock(_pythonModuleMapMutex);
+
+        SdfPathVector removedPaths;
+        for (const SdfPath& modulePath : _pythonModulePaths)
         {
-            if (it->first.HasPrefix(entry.primPath))
+            for (const HdSceneIndexObserver::DirtiedPrimEntry &entry : entries)
             {
-                if (pointDeformLocators.Intersects(entry.dirtyLocators))
+                if (modulePath.HasPrefix(entry.primPath) &&
+                    pointDeformLocators.Intersects(entry.dirtyLocators))
                 {
-                    bErased = true;
-                    it = _pythonModuleMap.erase(it);
+                    removedPaths.push_back(modulePath);
                     break;
                 }
             }
         }
-        if (!bErased)
+
+        for (const SdfPath& removedPath : removedPaths)
         {
-            it++;
+            RetireWarpPythonModule(removedPath);
+        }
+
+        // Parameters are cached per prim and only resolved again after a
+        // change, for an instancer they come from its prototype
+        for (const SdfPath& modulePath : _pythonModulePaths)
+        {
+            OmniWarpPythonModuleSharedPtr pythonModule = GetWarpPythonModule(modulePath);
+            for (const HdSceneIndexObserver::DirtiedPrimEntry &entry : entries)
+            {
+                if (pythonModule && pythonModule->GetSimulationParamsPath().HasPrefix(entry.primPath) &&
+                    entry.dirtyLocators.Intersects(OmniWarpComputationSchema::GetSimulationParamsLocator()))
+                {
+                    pythonModule->InvalidateSimulationParams();
+                    break;
+                }
+            }
+        }
+
+        bool dependenciesChanged = !removedPaths.empty();
+        for (const HdSceneIndexObserver::DirtiedPrimEntry &entry : entries)
+        {
+            if (entry.dirtyLocators.Intersects(OmniWarpComputationSchema::GetDependentPrimsLocator()))
+            {
+                dependenciesChanged = true;
+                break;
+            }
+        }
+        if (dependenciesChanged)
+        {
+            RebuildWarpDependencyGraph();
         }
     }
 
-    _SendPrimsDirtied(entries);
+    // Frames landed by asynchronous steps are announced along with
+    // the notices of the input scene (stage time changes during playback),
+    // observers don't expect notices from the simulation workers
+    HdSceneIndexObserver::DirtiedPrimEntries allEntries(entries);
+    _TakeLandedFrames(&allEntries);
+    _SendPrimsDirtied(allEntries);
+}
+
+void
+OmniWarpSceneIndex::_TakeLandedFrames(HdSceneIndexObserver::DirtiedPrimEntries* entries)
+{
+    SdfPathSet landedFramePaths;
+    {
+        std::lock_guard<std::mutex> landedFramesLock(_landedFramesMutex);
+        landedFramePaths.swap(_landedFramePaths);
+    }
+
+    static const HdDataSourceLocatorSet landedFrameLocators
+    {
+        HdPrimvarsSchema::GetDefaultLocator().Append(HdTokens->points),
+        HdPrimvarsSchema::GetDefaultLocator().Append(HdInstancerTokens->translate)
+    };
+
+    for (const SdfPath& landedFramePath : landedFramePaths)
+    {
+        entries->emplace_back(landedFramePath, landedFrameLocators);
+    }
 }
 
 OmniWarpPythonModuleSharedPtr
 OmniWarpSceneIndex::GetWarpPythonModule(const SdfPath &primPath) const
 {
-    //+++ Multithreaded access to _pythonModuleMap
-    auto pythonModule = _pythonModuleMap.find(primPath);
-    if (pythonModule == _pythonModuleMap.end())
+    _WarpPythonModuleMap::const_accessor accessor;
+    if (!_pythonModuleMap.find(accessor, primPath))
     {
         return OmniWarpPythonModuleSharedPtr(nullptr);
     }
-    return pythonModule->second;
+    return accessor->second;
+}
+
+void
+OmniWarpSceneIndex::OnWarpFrameLanded(const SdfPath &primPath)
+{
+    std::lock_guard<std::mutex> landedFramesLock(_landedFramesMutex);
+    _landedFramePaths.insert(primPath);
+}
+
+bool
+OmniWarpSceneIndex::GetWarpSimulationInputs(const OmniWarpPythonModuleSharedPtr &pythonModule,
+    OmniWarpSimParamsConstPtr* simParams, VtVec3fArray* dependentVertices) const
+{
+    // Resolves the inputs the same way GetPrim hands them to the data
+    // sources, so the results of a batch match the queries that follow
+    HdSceneIndexPrim prim = _GetInputSceneIndex()->GetPrim(pythonModule->GetPrimPath());
+    if (!prim.dataSource)
+    {
+        return false;
+    }
+
+    HdContainerDataSourceHandle simParamsDs;
+    if (prim.primType == HdPrimTypeTokens->mesh)
+    {
+        simParamsDs = prim.dataSource;
+    }
+    else if (prim.primType == HdPrimTypeTokens->instancer)
+    {
+        HdInstancerTopologySchema topologySchema = HdInstancerTopologySchema::GetFromParent(prim.dataSource);
+        if (HdPathArrayDataSourceHandle const ds = topologySchema.GetPrototypes())
+        {
+            auto protoTypes = ds->GetTypedValue(0.0f);
+            for (size_t i = 0; i < protoTypes.size(); ++i)
+            {
+                auto protoPrim = _GetInputSceneIndex()->GetPrim(protoTypes[i]);
+                if (OmniWarpComputationSchema::GetFromParent(protoPrim.dataSource))
+                {
+                    simParamsDs = protoPrim.dataSource;
+                }
+            }
+        }
+    }
+
+    OmniWarpComputationSchema warpSchema = OmniWarpComputationSchema::GetFromParent(simParamsDs);
+    if (!simParamsDs || !warpSchema)
+    {
+        return false;
+    }
+
+    *simParams = GetCachedSimulationParams(pythonModule, simParamsDs);
+    *dependentVertices = GetWarpDependentVertices(pythonModule->GetPrimPath());
+
+    return true;
+}
+
+VtVec3fArray
+OmniWarpSceneIndex::GetWarpDependentVertices(const SdfPath &primPath) const
+{
+    _WarpDependencies dependencies;
+    {
+        std::lock_guard<std::mutex> graphLock(_warpGraphMutex);
+        auto it = _warpDependencies.find(primPath);
+        if (it == _warpDependencies.end())
+        {
+            return VtVec3fArray();
+        }
+        dependencies = it->second;
+    }
+
+    std::vector<VtVec3fArray> dependentVertices;
+    dependentVertices.reserve(dependencies.dependentPrims.size());
+    size_t numVertices = 0;
+    for (const SdfPath& dependentPrim : dependencies.dependentPrims)
+    {
+        VtVec3fArray points;
+        OmniWarpPythonModuleSharedPtr producer;
+        if (dependencies.producers.count(dependentPrim) &&
+            (producer = GetWarpPythonModule(dependentPrim)))
+        {
+            // The result of the producer for the current frame, stepping it
+            // first if need be.  The graph is acyclic, so this terminates
+            OmniWarpSimParamsConstPtr producerSimParams;
+            VtVec3fArray producerDependentVertices;
+            if (GetWarpSimulationInputs(producer, &producerSimParams, &producerDependentVertices))
+            {
+                points = producer->ExecSim(std::move(producerSimParams), std::move(producerDependentVertices));
+            }
+        }
+        else
+        {
+            points = GetPrimPoints(_GetInputSceneIndex()->GetPrim(dependentPrim).dataSource);
+        }
+
+        numVertices += points.size();
+        dependentVertices.push_back(std::move(points));
+    }
+
+    // A single dependency is handed over as it is, sharing its storage
+    if (dependentVertices.size() == 1)
+    {
+        return dependentVertices[0];
+    }
+
+    VtVec3fArray allDependentVertices;
+    allDependentVertices.reserve(numVertices);
+    for (const VtVec3fArray& points : dependentVertices)
+    {
+        allDependentVertices.insert(allDependentVertices.end(), points.begin(), points.end());
+    }
+    return allDependentVertices;
+}
+
+void
+OmniWarpSceneIndex::RebuildWarpDependencyGraph()
+{
+    TfHashMap<SdfPath, _WarpDependencies, SdfPath::Hash> warpDependencies;
+    for (const SdfPath& modulePath : _pythonModulePaths)
+    {
+        OmniWarpPythonModuleSharedPtr pythonModule = GetWarpPythonModule(modulePath);
+        _WarpDependencies& dependencies = warpDependencies[modulePath];
+        if (!pythonModule)
+        {
+            continue;
+        }
+
+        HdSceneIndexPrim prim = _GetInputSceneIndex()->GetPrim(pythonModule->GetSimulationParamsPath());
+        OmniWarpComputationSchema warpSchema = OmniWarpComputationSchema::GetFromParent(prim.dataSource);
+        if (HdPathArrayDataSourceHandle dependentsDs = warpSchema ? warpSchema.GetDependentPrims() : nullptr)
+        {
+            VtArray<SdfPath> dependentPrims = dependentsDs->GetTypedValue(0);
+            dependencies.dependentPrims.assign(dependentPrims.begin(), dependentPrims.end());
+        }
+    }
+
+    // Without stage time there is no frame to order steps in,
+    // such prims see the points of the input scene
+    for (auto& entry : warpDependencies)
+    {
+        OmniWarpPythonModuleSharedPtr consumerModule = GetWarpPythonModule(entry.first);
+        if (!consumerModule || !consumerModule->StepsOnStageTime())
+        {
+            continue;
+        }
+
+        for (const SdfPath& dependentPrim : entry.second.dependentPrims)
+        {
+            OmniWarpPythonModuleSharedPtr producerModule = GetWarpPythonModule(dependentPrim);
+            if (dependentPrim != entry.first && producerModule && producerModule->StepsOnStageTime())
+            {
+                entry.second.producers.insert(dependentPrim);
+            }
+        }
+    }
+
+    // Depth first, a prim's level is one more than the highest level of
+    // its producers.  A producer still being visited closes a cycle
+    enum { Unvisited, Visiting, Visited };
+    TfHashMap<SdfPath, int, SdfPath::Hash> visitState;
+    TfHashMap<SdfPath, size_t, SdfPath::Hash> levels;
+    std::function<size_t(const SdfPath&)> visit = [&](const SdfPath& primPath) -> size_t
+    {
+        visitState[primPath] = Visiting;
+        _WarpDependencies& dependencies = warpDependencies[primPath];
+        size_t level = 0;
+        for (SdfPathSet::iterator it = dependencies.producers.begin(); it != dependencies.producers.end();)
+        {
+            int producerState = visitState[*it];
+            if (producerState == Visiting)
+            {
+                TF_WARN("Warp prim <%s> depends on <%s>, which depends on it in turn; "
+                    "it sees the points of <%s> before simulation",
+                    primPath.GetText(), it->GetText(), it->GetText());
+                it = dependencies.producers.erase(it);
+                continue;
+            }
+
+            size_t producerLevel = producerState == Visited ? levels[*it] : visit(*it);
+            level = std::max(level, producerLevel + 1);
+            it++;
+        }
+        visitState[primPath] = Visited;
+        levels[primPath] = level;
+        return level;
+    };
+
+    for (const auto& entry : warpDependencies)
+    {
+        if (visitState[entry.first] == Unvisited)
+        {
+            visit(entry.first);
+        }
+    }
+
+    SdfPathSet scheduledPrims;
+    for (const auto& entry : warpDependencies)
+    {
+        if (!entry.second.producers.empty())
+        {
+            scheduledPrims.insert(entry.first);
+            scheduledPrims.insert(entry.second.producers.begin(), entry.second.producers.end());
+        }
+    }
+
+    std::vector<SdfPathVector> warpLevels;
+    for (const SdfPath& primPath : scheduledPrims)
+    {
+        size_t level = levels[primPath];
+        if (warpLevels.size() <= level)
+        {
+            warpLevels.resize(level + 1);
+        }
+        warpLevels[level].push_back(primPath);
+    }
+
+    for (const SdfPath& modulePath : _pythonModulePaths)
+    {
+        OmniWarpPythonModuleSharedPtr pythonModule = GetWarpPythonModule(modulePath);
+        if (pythonModule)
+        {
+            pythonModule->SetScheduled(scheduledPrims.count(modulePath) != 0);
+        }
+    }
+
+    std::lock_guard<std::mutex> graphLock(_warpGraphMutex);
+    _warpDependencies.swap(warpDependencies);
+    _warpLevels.swap(warpLevels);
+    _warpFrameStarted = false;
+}
+
+void
+OmniWarpSceneIndex::ExecWarpFrame(float time)
+{
+    // Queries arriving while the frame is under way don't wait for it,
+    // they step their prim on their own.  The dependent vertices of a
+    // prim are the results of its producers for the same frame either
+    // way, as resolving them steps the producers first
+    std::vector<SdfPathVector> warpLevels;
+    {
+        std::lock_guard<std::mutex> graphLock(_warpGraphMutex);
+        if (_warpFrameStarted && _warpFrameTime == time)
+        {
+            return;
+        }
+        _warpFrameStarted = true;
+        _warpFrameTime = time;
+        warpLevels = _warpLevels;
+    }
+
+    for (const SdfPathVector& level : warpLevels)
+    {
+        WorkParallelForEach(level.begin(), level.end(), [this](const SdfPath& primPath)
+        {
+            OmniWarpPythonModuleSharedPtr pythonModule = GetWarpPythonModule(primPath);
+            OmniWarpSimParamsConstPtr simParams;
+            VtVec3fArray dependentVertices;
+            if (pythonModule && GetWarpSimulationInputs(pythonModule, &simParams, &dependentVertices))
+            {
+                pythonModule->ExecSim(std::move(simParams), std::move(dependentVertices));
+            }
+        });
+    }
+}
+
+void
+OmniWarpSceneIndex::ExecWarpPythonBatch(const std::string &moduleName, float time)
+{
+    // One batch at a time, queries for the same frame arriving meanwhile
+    // find their results already stored once this batch is done
+    std::lock_guard<std::mutex> batchLock(_batchMutex);
+
+    std::vector<OmniWarpPythonModuleSharedPtr> candidates;
+    {
+        std::lock_guard<std::mutex> mapLock(_pythonModuleMapMutex);
+        for (const SdfPath& modulePath : _pythonModulePaths)
+        {
+            OmniWarpPythonModuleSharedPtr pythonModule = GetWarpPythonModule(modulePath);
+            if (pythonModule && pythonModule->IsBatchable() && pythonModule->GetModuleName() == moduleName)
+            {
+                candidates.push_back(pythonModule);
+            }
+        }
+    }
+
+    std::vector<OmniWarpPythonModuleSharedPtr> pythonModules;
+    std::vector<VtVec3fArray> dependentVertices;
+    std::vector<OmniWarpSimParamsConstPtr> simParams;
+    for (const OmniWarpPythonModuleSharedPtr& pythonModule : candidates)
+    {
+        OmniWarpSimParamsConstPtr primSimParams;
+        VtVec3fArray primDependentVertices;
+        if (!GetWarpSimulationInputs(pythonModule, &primSimParams, &primDependentVertices) ||
+            pythonModule->HasResult(time, primSimParams, primDependentVertices))
+        {
+            continue;
+        }
+
+        pythonModules.push_back(pythonModule);
+        dependentVertices.push_back(std::move(primDependentVertices));
+        simParams.push_back(std::move(primSimParams));
+    }
+
+    std::vector<VtVec3fArray> results;
+    std::vector<bool> hasResult;
+    if (pythonModules.empty() ||
+        !OmniWarpPythonModule::ExecSimBatch(moduleName, time, pythonModules, dependentVertices, simParams,
+            &results, &hasResult))
+    {
+        return;
+    }
+
+    // Prims without a result find none when their query
+    // resumes and step on their own through exec_sim
+    for (size_t i = 0; i < pythonModules.size(); i++)
+    {
+        if (!hasResult[i])
+        {
+            continue;
+        }
+
+        pythonModules[i]->SetResult(time, std::move(simParams[i]), std::move(dependentVertices[i]), std::move(results[i]));
+    }
+}
+
+void
+OmniWarpSceneIndex::RetireWarpPythonModule(const SdfPath &primPath)
+{
+    OmniWarpPythonModuleSharedPtr pythonModule;
+    {
+        _WarpPythonModuleMap::accessor accessor;
+        if (!_pythonModuleMap.find(accessor, primPath))
+        {
+            return;
+        }
+        pythonModule = accessor->second;
+        _pythonModuleMap.erase(accessor);
+    }
+    _pythonModulePaths.erase(primPath);
+
+    // The python modules key their state by prim path, so terminate now
+    // rather than when the last data source lets go of the module, which
+    // could be after a new module for the same prim was initialized
+    if (pythonModule)
+    {
+        pythonModule->Terminate();
+    }
+}
+
+OmniWarpPythonModuleSharedPtr
+OmniWarpSceneIndex::NewWarpPythonModule(const SdfPath &primPath,
+    const std::string &moduleName,
+    const SdfPath &simParamsPath,
+    UsdImagingStageSceneIndexRefPtr usdImagingSi)
+{
+    // The module may outlive the scene index, see _CallbackGuard
+    std::shared_ptr<_CallbackGuard> guard = _callbackGuard;
+    return std::make_shared<OmniWarpPythonModule>(primPath, moduleName, simParamsPath, usdImagingSi,
+        [guard](const SdfPath& landedPrimPath)
+        {
+            guard->Call([&](OmniWarpSceneIndex* sceneIndex) { sceneIndex->OnWarpFrameLanded(landedPrimPath); });
+        },
+        [guard](const std::string& batchModuleName, float time)
+        {
+            guard->Call([&](OmniWarpSceneIndex* sceneIndex) { sceneIndex->ExecWarpPythonBatch(batchModuleName, time); });
+        },
+        [guard](float time)
+        {
+            guard->Call([&](OmniWarpSceneIndex* sceneIndex) { sceneIndex->ExecWarpFrame(time); });
+        },
+        [guard](const SdfPath& dependentPrimPath)
+        {
+            VtVec3fArray dependentVertices;
+            guard->Call([&](OmniWarpSceneIndex* sceneIndex)
+            {
+                dependentVertices = sceneIndex->GetWarpDependentVertices(dependentPrimPath);
+            });
+            return dependentVertices;
+        });
 }
 
 OmniWarpPythonModuleSharedPtr
@@ -688,9 +1160,9 @@ OmniWarpSceneIndex::CreateWarpPythonModule(const SdfPath &primPath,
     HdMeshTopologySchema& topologySchema,
     HdPrimvarSchema& primVarSchema,
     UsdImagingStageSceneIndexRefPtr usdImagingSi,
+    const SdfPath &simParamsPath,
     VtDictionary vtSimParams)
 {
-    //+++ Multithreaded access to _pythonModuleMap
     std::string moduleName = warpSchema.GetSourceFile()->GetTypedValue(0);
 
     HdIntArrayDataSourceHandle faceIndicesDs = topologySchema.GetFaceVertexIndices();
@@ -701,16 +1173,19 @@ OmniWarpSceneIndex::CreateWarpPythonModule(const SdfPath &primPath,
     VtVec3fArray pointsArray =  pointsVt.UncheckedGet<VtArray<GfVec3f>>();
 
     // Force terminate of old module
-    _pythonModuleMap[primPath] = nullptr;
+    RetireWarpPythonModule(primPath);
 
     OmniWarpPythonModuleSharedPtr pythonModule =
-        std::make_shared<OmniWarpPythonModule>(primPath, moduleName, usdImagingSi);
+        NewWarpPythonModule(primPath, moduleName, simParamsPath, usdImagingSi);
     VtIntArray depIndices;
     VtVec3fArray depPointsArray;
     GetDependentMeshData(warpSchema, depIndices, depPointsArray);
     pythonModule->InitMesh(indices, pointsArray, depIndices, depPointsArray, vtSimParams);
-    _pythonModuleMap[primPath] = pythonModule;
-    return _pythonModuleMap.find(primPath)->second;
+    _WarpPythonModuleMap::accessor accessor;
+    _pythonModuleMap.insert(accessor, primPath);
+    accessor->second = pythonModule;
+    _pythonModulePaths.insert(primPath);
+    return pythonModule;
 }
 
 OmniWarpPythonModuleSharedPtr
@@ -718,28 +1193,31 @@ OmniWarpSceneIndex::CreateWarpPythonModule(const SdfPath &primPath,
     OmniWarpComputationSchema& warpSchema,
     HdPrimvarSchema& primVarSchema,
     UsdImagingStageSceneIndexRefPtr usdImagingSi,
+    const SdfPath &simParamsPath,
     VtDictionary vtSimParams)
 {
-    //+++ Multithreaded access to _pythonModuleMap
     std::string moduleName = warpSchema.GetSourceFile()->GetTypedValue(0);
 
     // Force terminate of old module
-    _pythonModuleMap[primPath] = nullptr;
+    RetireWarpPythonModule(primPath);
 
     HdSampledDataSourceHandle valueDataSource = primVarSchema.GetPrimvarValue();
     auto positionsVt = valueDataSource->GetValue(0.f);
     VtVec3fArray positionsArray =  positionsVt.UncheckedGet<VtArray<GfVec3f>>();
 
     OmniWarpPythonModuleSharedPtr pythonModule =
-        std::make_shared<OmniWarpPythonModule>(primPath, moduleName, usdImagingSi);
+        NewWarpPythonModule(primPath, moduleName, simParamsPath, usdImagingSi);
     VtIntArray indices;
     VtVec3fArray pointsArray;
     GetDependentMeshData(warpSchema, indices, pointsArray);
 
     pythonModule->InitParticles(positionsArray, indices, pointsArray, vtSimParams);
 
-    _pythonModuleMap[primPath] = pythonModule;
-    return _pythonModuleMap.find(primPath)->second;
+    _WarpPythonModuleMap::accessor accessor;
+    _pythonModuleMap.insert(accessor, primPath);
+    accessor->second = pythonModule;
+    _pythonModulePaths.insert(primPath);
+    return pythonModule;
 }
 
 void
@@ -755,28 +1233,37 @@ OmniWarpSceneIndex::GetDependentMeshData(OmniWarpComputationSchema warpSchema, V
         return;
     }
 
-    //+++ Only support a single dependent prim
-    auto depPrim = _GetInputSceneIndex()->GetPrim(dependentPrims[0]);
-    if (depPrim.dataSource)
+    // Several dependent prims are handed to the simulation as one mesh,
+    // with the indices of each offset past the points of those before it
+    for (const SdfPath& dependentPrim : dependentPrims)
     {
-
-        HdPrimvarsSchema depPrimVarsSchema = HdPrimvarsSchema::GetFromParent(depPrim.dataSource);
-        if (depPrimVarsSchema)
+        auto depPrim = _GetInputSceneIndex()->GetPrim(dependentPrim);
+        if (!depPrim.dataSource)
         {
-            HdPrimvarSchema depPrimVar = depPrimVarsSchema.GetPrimvar(HdTokens->points);
-            if (depPrimVar)
-            {
-                HdSampledDataSourceHandle valueDataSource = depPrimVar.GetPrimvarValue();
-                auto pointsVt = valueDataSource->GetValue(0.f);
-                outVertices =  pointsVt.UncheckedGet<VtArray<GfVec3f>>();
-            }
+            continue;
         }
+
+        const int indexOffset = static_cast<int>(outVertices.size());
+        VtVec3fArray depVertices = GetPrimPoints(depPrim.dataSource);
         HdMeshSchema meshSchema = HdMeshSchema::GetFromParent(depPrim.dataSource);
         if (meshSchema)
         {
             HdMeshTopologySchema topologySchema = meshSchema.GetTopology();
             HdIntArrayDataSourceHandle faceIndicesDs = topologySchema.GetFaceVertexIndices();
-            outIndices = faceIndicesDs->GetTypedValue(0.f);
+            VtIntArray depIndices = faceIndicesDs->GetTypedValue(0.f);
+            for (int index : depIndices)
+            {
+                outIndices.push_back(index + indexOffset);
+            }
+        }
+
+        if (outVertices.empty())
+        {
+            outVertices = depVertices;
+        }
+        else
+        {
+            outVertices.insert(outVertices.end(), depVertices.begin(), depVertices.end());
         }
     }
 }
@@ -16,7 +16,14 @@
 #ifndef OMNI_WARP_SCENE_INDEX_WARP_SCENE_INDEX_H
 #define OMNI_WARP_SCENE_INDEX_WARP_SCENE_INDEX_H
 
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+
+#include <tbb/concurrent_hash_map.h>
+
 #include <pxr/pxr.h>
+#include <pxr/base/tf/hashmap.h>
 #include <pxr/imaging/hd/filteringSceneIndex.h>
 #include <pxr/usdImaging/usdImaging/stageSceneIndex.h>
 #include "pxr/imaging/hd/primvarSchema.h"
@@ -53,6 +60,9 @@ public:
     OMNIWARPSCENEINDEX_API
     SdfPathVector GetChildPrimPaths(const SdfPath &primPath) const override;
     
+    OMNIWARPSCENEINDEX_API
+    ~OmniWarpSceneIndex() override;
+
 protected:
     OmniWarpSceneIndex(
         const HdSceneIndexBaseRefPtr &inputSceneIndex);
@@ -76,22 +86,160 @@ private:
         HdMeshTopologySchema& topologySchema,
         HdPrimvarSchema& primVarSchema,
         UsdImagingStageSceneIndexRefPtr usdImagingSi,
+        const SdfPath &simParamsPath,
         VtDictionary vtSimParams);
 
     OmniWarpPythonModuleSharedPtr CreateWarpPythonModule(const SdfPath &primPath,
         OmniWarpComputationSchema& warpSchema,
         HdPrimvarSchema& primVarSchema,
         UsdImagingStageSceneIndexRefPtr usdImagingSi,
+        const SdfPath &simParamsPath,
         VtDictionary vtSimParams);
 
+    // Creates the module of primPath, its callbacks into the scene
+    // index go through _callbackGuard
+    OmniWarpPythonModuleSharedPtr NewWarpPythonModule(const SdfPath &primPath,
+        const std::string &moduleName,
+        const SdfPath &simParamsPath,
+        UsdImagingStageSceneIndexRefPtr usdImagingSi);
+
+    // Removes the module of primPath from the map and terminates it,
+    // called with _pythonModuleMapMutex held
+    void RetireWarpPythonModule(const SdfPath &primPath);
+
+    // Called on a simulation worker when an asynchronous step completes
+    void OnWarpFrameLanded(const SdfPath &primPath);
+
+    // Steps every prim of the python module moduleName that has no result
+    // for time yet in a single exec_sim_batch call, if the module has one
+    void ExecWarpPythonBatch(const std::string &moduleName, float time);
+
+    bool GetWarpSimulationInputs(const OmniWarpPythonModuleSharedPtr &pythonModule,
+        OmniWarpSimParamsConstPtr* simParams, VtVec3fArray* dependentVertices) const;
+
+    // Returns the current points of the dependent prims of primPath,
+    // taking those of warp prims from the result of their simulation
+    VtVec3fArray GetWarpDependentVertices(const SdfPath &primPath) const;
+
+    // Rebuilds the dependencies between warp prims from their
+    // dependentPrims, called with _pythonModuleMapMutex held
+    void RebuildWarpDependencyGraph();
+
+    // Steps the scheduled prims for time in dependency order, unless
+    // a frame for time was already started since the last rebuild
+    void ExecWarpFrame(float time);
+
     void GetDependentMeshData(OmniWarpComputationSchema warpSchema,
         VtIntArray& outIndices,
         VtVec3fArray& outVertices);
 
-    // Each prim with a WarpComputationAPI gets it's own Python Module instance
-    typedef std::unordered_map<SdfPath, OmniWarpPythonModuleSharedPtr, SdfPath::Hash> _WarpPythonModuleMap;
+    // Hash structure consistent with what TBB expects
+    // but forwarded to what's already in USD
+    struct SdfPathHash {
+        static size_t hash(const SdfPath& path)
+        {
+            return path.GetHash();
+        }
+
+        static bool equal(const SdfPath& path1, const SdfPath& path2)
+        {
+            return path1 == path2;
+        }
+    };
+
+    // Each prim with a WarpComputationAPI gets it's own Python Module instance.
+    // Hydra calls GetPrim from several threads during sync, so lookups
+    // go through a concurrent map.  Data sources share ownership of the
+    // module they were created with, so a module removed from the map
+    // lives on until the last in-flight ExecSim using it has returned
+    typedef tbb::concurrent_hash_map<SdfPath, OmniWarpPythonModuleSharedPtr, SdfPathHash> _WarpPythonModuleMap;
     mutable _WarpPythonModuleMap _pythonModuleMap;
 
+    // The prim paths of the modules in the map.  Lookups may rehash the
+    // buckets of the map, so it can't be iterated while GetPrim runs on
+    // other threads; iterating the paths and looking each module up can
+    SdfPathSet _pythonModulePaths;
+
+    // Serializes the notices adding and removing modules, and guards
+    // _pythonModulePaths, which they iterate and change
+    std::mutex _pythonModuleMapMutex;
+
+    // Serializes batches, see ExecWarpPythonBatch
+    std::mutex _batchMutex;
+
+    // Dependencies of a warp prim
+    struct _WarpDependencies
+    {
+        // all the prims it depends on, in order
+        SdfPathVector dependentPrims;
+
+        // those of them that are warp prims, their results are its
+        // inputs.  Dependencies closing a cycle aren't included, their
+        // points are taken from the input scene instead
+        SdfPathSet producers;
+    };
+
+    mutable std::mutex _warpGraphMutex;
+    TfHashMap<SdfPath, _WarpDependencies, SdfPath::Hash> _warpDependencies;
+
+    // The scheduled prims, those with warp producers or consumers, by
+    // level.  Prims of a level only depend on prims of earlier levels,
+    // so the prims of a level step in parallel
+    std::vector<SdfPathVector> _warpLevels;
+    bool _warpFrameStarted;
+    float _warpFrameTime;
+
+    // Data sources share ownership of the modules, so a module and its
+    // callbacks may outlive the scene index.  The callbacks hold the
+    // guard rather than the scene index, and the destructor closes it,
+    // waiting for the calls in flight, before the scene index goes away
+    class _CallbackGuard
+    {
+    public:
+        explicit _CallbackGuard(OmniWarpSceneIndex* sceneIndex);
+
+        // Calls fn with the scene index, unless the guard was closed.
+        // Returns whether fn was called
+        template <class Fn>
+        bool Call(const Fn& fn)
+        {
+            OmniWarpSceneIndex* sceneIndex = _Enter();
+            if (!sceneIndex)
+            {
+                return false;
+            }
+
+            struct _CallScope
+            {
+                _CallbackGuard* guard;
+                ~_CallScope() { guard->_Exit(); }
+            } scope{this};
+            fn(sceneIndex);
+            return true;
+        }
+
+        // Fails all further calls and waits for those in flight
+        void Close();
+
+    private:
+        OmniWarpSceneIndex* _Enter();
+        void _Exit();
+
+        std::mutex _mutex;
+        std::condition_variable _idle;
+        OmniWarpSceneIndex* _sceneIndex;
+        size_t _callsInFlight;
+    };
+
+    std::shared_ptr<_CallbackGuard> _callbackGuard;
+
+    // Adds the prims with landed frames to entries and clears them
+    void _TakeLandedFrames(HdSceneIndexObserver::DirtiedPrimEntries* entries);
+
+    // Prims with frames landed since the last dirtied notice was sent
+    std::mutex _landedFramesMutex;
+    SdfPathSet _landedFramePaths;
+
 };
 
 PXR_NAMESPACE_CLOSE_SCOPE
@@ -0,0 +1,423 @@
+// Copyright 2023 NVIDIA CORPORATION
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+#include <pxr/base/arch/hash.h>
+#include <pxr/base/tf/diagnostic.h>
+#include <pxr/base/tf/fileUtils.h>
+#include <pxr/base/tf/pathUtils.h>
+#include <pxr/base/tf/stringUtils.h>
+#include <pxr/base/work/loops.h>
+
+#include "warpSimCache.h"
+
+PXR_NAMESPACE_OPEN_SCOPE
+
+static const char CACHE_MAGIC[4] = { 'O', 'W', 'S', 'C' };
+static const uint32_t CACHE_VERSION = 1;
+static const uint32_t CACHE_FLAG_QUANTIZED = 1;
+static const uint64_t CACHE_ALIGNMENT = 8;
+static const float QUANTIZED_MAX = 65535.f;
+
+// cache file names keep at most this many characters of the prim path
+static const size_t CACHE_FILE_NAME_MAX_PREFIX = 96;
+
+struct _CacheHeader
+{
+    char magic[4];
+    uint32_t version;
+    uint32_t flags;
+    uint32_t frameCount;
+    uint64_t indexOffset;
+};
+
+struct _CacheIndexEntry
+{
+    float time;
+    uint32_t pointCount;
+    uint64_t offset;
+};
+
+// the bounds a quantized frame precedes its points with
+struct _QuantizedBounds
+{
+    float min[3];
+    float scale[3];
+};
+
+static_assert(sizeof(_CacheHeader) == 24, "cache header must not be padded");
+static_assert(sizeof(_CacheIndexEntry) == 16, "cache index entries must not be padded");
+static_assert(sizeof(GfVec3f) == 3 * sizeof(float), "points must be tightly packed");
+
+static uint64_t _GetFrameSize(uint32_t pointCount, bool quantized)
+{
+    return quantized ?
+        sizeof(_QuantizedBounds) + uint64_t(pointCount) * 3 * sizeof(uint16_t) :
+        uint64_t(pointCount) * sizeof(GfVec3f);
+}
+
+std::unique_ptr<OmniWarpSimCacheWriter> OmniWarpSimCacheWriter::Create(const std::string& filePath, bool quantize)
+{
+    std::unique_ptr<OmniWarpSimCacheWriter> writer(new OmniWarpSimCacheWriter(filePath, quantize));
+
+    std::string reason;
+    if (!writer->_wrapper.Open(&reason))
+    {
+        TF_WARN("Can't bake warp simulation cache '%s': %s", filePath.c_str(), reason.c_str());
+        return nullptr;
+    }
+
+    // the header is rewritten with the frame count and
+    // index offset once all frames have been baked
+    _CacheHeader header = {};
+    if (!writer->_Write(&header, sizeof(header)))
+    {
+        return nullptr;
+    }
+
+    return writer;
+}
+
+OmniWarpSimCacheWriter::OmniWarpSimCacheWriter(const std::string& filePath, bool quantize)
+    : _filePath(filePath),
+      _wrapper(filePath),
+      _quantize(quantize),
+      _failed(false),
+      _offset(0)
+{
+}
+
+OmniWarpSimCacheWriter::~OmniWarpSimCacheWriter()
+{
+    // Without frames or after a failed write the temporary
+    // file is removed by the wrapper and nothing is replaced
+    if (_failed || _frames.empty())
+    {
+        return;
+    }
+
+    if (!_Align())
+    {
+        return;
+    }
+
+    _CacheHeader header;
+    std::memcpy(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+    header.version = CACHE_VERSION;
+    header.flags = _quantize ? CACHE_FLAG_QUANTIZED : 0;
+    header.frameCount = static_cast<uint32_t>(_frames.size());
+    header.indexOffset = _offset;
+
+    for (const auto& frame : _frames)
+    {
+        _CacheIndexEntry entry;
+        entry.time = frame.first;
+        entry.pointCount = frame.second.first;
+        entry.offset = frame.second.second;
+        if (!_Write(&entry, sizeof(entry)))
+        {
+            return;
+        }
+    }
+
+    std::ofstream& stream = _wrapper.GetStream();
+    stream.seekp(0);
+    if (!_Write(&header, sizeof(header)))
+    {
+        return;
+    }
+
+    if (!_CoversExistingCache())
+    {
+        TF_WARN("Kept warp simulation cache '%s', it has frames the new bake lacks", _filePath.c_str());
+        return;
+    }
+
+    std::string reason;
+    if (!_wrapper.Commit(&reason))
+    {
+        TF_WARN("Can't bake warp simulation cache '%s': %s", _filePath.c_str(), reason.c_str());
+    }
+}
+
+void OmniWarpSimCacheWriter::WriteFrame(float time, const VtVec3fArray& points)
+{
+    if (_failed || !_Align())
+    {
+        return;
+    }
+
+    if (points.size() > std::numeric_limits<uint32_t>::max())
+    {
+        TF_WARN("Too many points to bake into warp simulation cache '%s'", _filePath.c_str());
+        _failed = true;
+        return;
+    }
+
+    // A frame baked again, as when playback loops during the bake,
+    // replaces its points in place rather than growing the file
+    auto it = _frames.find(time);
+    if (it != _frames.end() && it->second.first == points.size())
+    {
+        std::ofstream& stream = _wrapper.GetStream();
+        const uint64_t end = _offset;
+        stream.seekp(it->second.second);
+        _offset = it->second.second;
+        _WriteFrameData(points);
+        stream.seekp(end);
+        _offset = end;
+        return;
+    }
+
+    const uint64_t offset = _offset;
+    if (!_WriteFrameData(points))
+    {
+        return;
+    }
+
+    _frames[time] = std::make_pair(static_cast<uint32_t>(points.size()), offset);
+}
+
+bool OmniWarpSimCacheWriter::_WriteFrameData(const VtVec3fArray& points)
+{
+    const size_t numPoints = points.size();
+    const GfVec3f* const src = points.cdata();
+
+    if (!_quantize)
+    {
+        return _Write(src, numPoints * sizeof(GfVec3f));
+    }
+    else
+    {
+        GfVec3f minPoint(0.f);
+        GfVec3f maxPoint(0.f);
+        if (numPoints > 0)
+        {
+            minPoint = maxPoint = src[0];
+        }
+        for (size_t i = 1; i < numPoints; i++)
+        {
+            for (size_t c = 0; c < 3; c++)
+            {
+                minPoint[c] = std::min(minPoint[c], src[i][c]);
+                maxPoint[c] = std::max(maxPoint[c], src[i][c]);
+            }
+        }
+
+        _QuantizedBounds bounds;
+        for (size_t c = 0; c < 3; c++)
+        {
+            bounds.min[c] = minPoint[c];
+            bounds.scale[c] = (maxPoint[c] - minPoint[c]) / QUANTIZED_MAX;
+        }
+
+        std::vector<uint16_t> quantized(numPoints * 3);
+        uint16_t* const dst = quantized.data();
+        WorkParallelForN(numPoints, [src, dst, &bounds](size_t begin, size_t end)
+        {
+            for (size_t i = begin; i < end; i++)
+            {
+                for (size_t c = 0; c < 3; c++)
+                {
+                    const float q = bounds.scale[c] > 0.f ?
+                        std::round((src[i][c] - bounds.min[c]) / bounds.scale[c]) : 0.f;
+                    dst[3 * i + c] = static_cast<uint16_t>(std::min(std::max(q, 0.f), QUANTIZED_MAX));
+                }
+            }
+        });
+
+        return _Write(&bounds, sizeof(bounds)) &&
+            _Write(dst, quantized.size() * sizeof(uint16_t));
+    }
+}
+
+bool OmniWarpSimCacheWriter::_Write(const void* data, size_t size)
+{
+    std::ofstream& stream = _wrapper.GetStream();
+    stream.write(static_cast<const char*>(data), size);
+    if (!stream)
+    {
+        TF_WARN("Failed writing warp simulation cache '%s'", _filePath.c_str());
+        _failed = true;
+        return false;
+    }
+
+    _offset += size;
+    return true;
+}
+
+bool OmniWarpSimCacheWriter::_CoversExistingCache() const
+{
+    if (!TfIsFile(_filePath))
+    {
+        return true;
+    }
+
+    // an unreadable cache is as good as none
+    std::unique_ptr<OmniWarpSimCache> existing = OmniWarpSimCache::Open(_filePath);
+    if (!existing)
+    {
+        return true;
+    }
+
+    for (float time : existing->GetFrameTimes())
+    {
+        if (!_frames.count(time))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool OmniWarpSimCacheWriter::_Align()
+{
+    static const char padding[CACHE_ALIGNMENT] = {};
+    const uint64_t remainder = _offset % CACHE_ALIGNMENT;
+    return remainder == 0 || _Write(padding, CACHE_ALIGNMENT - remainder);
+}
+
+std::unique_ptr<OmniWarpSimCache> OmniWarpSimCache::Open(const std::string& filePath)
+{
+    std::string errMsg;
+    ArchConstFileMapping mapping = ArchMapFileReadOnly(filePath, &errMsg);
+    if (!mapping)
+    {
+        TF_WARN("Can't open warp simulation cache '%s': %s", filePath.c_str(), errMsg.c_str());
+        return nullptr;
+    }
+
+    const char* const data = mapping.get();
+    const uint64_t length = ArchGetFileMappingLength(mapping);
+
+    _CacheHeader header;
+    if (length < sizeof(header))
+    {
+        TF_WARN("Warp simulation cache '%s' is truncated", filePath.c_str());
+        return nullptr;
+    }
+    std::memcpy(&header, data, sizeof(header));
+
+    if (std::memcmp(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC)) != 0)
+    {
+        TF_WARN("'%s' is not a warp simulation cache", filePath.c_str());
+        return nullptr;
+    }
+    if (header.version != CACHE_VERSION)
+    {
+        TF_WARN("Warp simulation cache '%s' has unsupported version %u", filePath.c_str(), header.version);
+        return nullptr;
+    }
+
+    const bool quantized = (header.flags & CACHE_FLAG_QUANTIZED) != 0;
+    if (header.indexOffset > length ||
+        header.frameCount > (length - header.indexOffset) / sizeof(_CacheIndexEntry))
+    {
+        TF_WARN("Warp simulation cache '%s' is truncated", filePath.c_str());
+        return nullptr;
+    }
+
+    // validate every frame up front so GetFrame can read without checks
+    std::unique_ptr<OmniWarpSimCache> cache(new OmniWarpSimCache());
+    cache->_quantized = quantized;
+    cache->_frames.reserve(header.frameCount);
+    for (uint32_t i = 0; i < header.frameCount; i++)
+    {
+        _CacheIndexEntry entry;
+        std::memcpy(&entry, data + header.indexOffset + i * sizeof(entry), sizeof(entry));
+
+        const uint64_t frameSize = _GetFrameSize(entry.pointCount, quantized);
+        if (entry.offset % CACHE_ALIGNMENT != 0 || entry.offset < sizeof(header) ||
+            entry.offset > header.indexOffset || frameSize > header.indexOffset - entry.offset ||
+            (i > 0 && !(cache->_frames.back().time < entry.time)))
+        {
+            TF_WARN("Warp simulation cache '%s' has a corrupt index", filePath.c_str());
+            return nullptr;
+        }
+
+        cache->_frames.push_back({ entry.time, entry.pointCount, entry.offset });
+    }
+
+    cache->_mapping = std::move(mapping);
+    return cache;
+}
+
+std::string OmniWarpSimCache::GetCacheFilePath(const std::string& cacheDir, const SdfPath& primPath)
+{
+    // the readable part maps '/' and '_' alike, so /World/a_b and
+    // /World_a/b would share it, the hash of the path tells them apart
+    const std::string& path = primPath.GetString();
+    std::string name = TfMakeValidIdentifier(path.substr(0, CACHE_FILE_NAME_MAX_PREFIX)) +
+        TfStringPrintf("_%016llx.owsc", static_cast<unsigned long long>(ArchHash64(path.data(), path.size())));
+    return TfStringCatPaths(cacheDir.empty() ? "." : cacheDir, name);
+}
+
+bool OmniWarpSimCache::GetFrame(float time, VtVec3fArray* points) const
+{
+    if (_frames.empty())
+    {
+        return false;
+    }
+
+    // the latest frame at or before time, or the first one
+    auto it = std::upper_bound(_frames.begin(), _frames.end(), time,
+        [](float t, const _Frame& frame) { return t < frame.time; });
+    const _Frame& frame = it == _frames.begin() ? *it : *(it - 1);
+
+    const char* const data = _mapping.get() + frame.offset;
+    const size_t numPoints = frame.pointCount;
+    if (!_quantized)
+    {
+        const GfVec3f* const src = reinterpret_cast<const GfVec3f*>(data);
+        points->assign(src, src + numPoints);
+        return true;
+    }
+
+    _QuantizedBounds bounds;
+    std::memcpy(&bounds, data, sizeof(bounds));
+    const uint16_t* const src = reinterpret_cast<const uint16_t*>(data + sizeof(bounds));
+
+    points->resize(numPoints);
+    float* const dst = points->data()->data();
+    WorkParallelForN(numPoints, [src, dst, &bounds](size_t begin, size_t end)
+    {
+        for (size_t i = begin; i < end; i++)
+        {
+            for (size_t c = 0; c < 3; c++)
+            {
+                dst[3 * i + c] = bounds.min[c] + src[3 * i + c] * bounds.scale[c];
+            }
+        }
+    });
+
+    return true;
+}
+
+std::vector<float> OmniWarpSimCache::GetFrameTimes() const
+{
+    std::vector<float> times;
+    times.reserve(_frames.size());
+    for (const _Frame& frame : _frames)
+    {
+        times.push_back(frame.time);
+    }
+    return times;
+}
+
+PXR_NAMESPACE_CLOSE_SCOPE
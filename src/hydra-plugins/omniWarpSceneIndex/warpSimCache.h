@@ -0,0 +1,146 @@
+// Copyright 2023 NVIDIA CORPORATION
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#ifndef OMNI_WARP_SCENE_INDEX_WARP_SIM_CACHE_H
+#define OMNI_WARP_SCENE_INDEX_WARP_SIM_CACHE_H
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <pxr/pxr.h>
+#include <pxr/base/arch/fileSystem.h>
+#include <pxr/base/tf/atomicOfstreamWrapper.h>
+#include <pxr/base/vt/array.h>
+#include <pxr/base/gf/vec3f.h>
+#include <pxr/usd/sdf/path.h>
+
+#include "api.h"
+
+PXR_NAMESPACE_OPEN_SCOPE
+
+///
+/// A simulation cache file holds the baked frames of one warp prim:
+///
+///   header     magic "OWSC", version, flags, frame count, index offset
+///   frames     the points of each frame, each aligned to 8 bytes
+///   index      time, point count and offset of each frame, by time
+///
+/// A frame holds its points as floats, or with OMNI_WARP_SIM_CACHE_QUANTIZE
+/// as the bounds of the frame (6 floats) followed by 16 bit integers per
+/// component within them, which halves the size of the file and what
+/// playback reads, at an error of at most 1/131070 of the bounds.
+///
+
+///
+/// \class OmniWarpSimCacheWriter
+///
+/// Bakes the frames of a prim as they are simulated.  The file is written
+/// to a temporary file and moved into place when the writer is destroyed,
+/// so playback never sees a partially baked cache.  An existing cache is
+/// only replaced if the bake holds every frame it holds, so a module
+/// retired part way through a bake doesn't clobber a complete one.  A
+/// frame baked twice keeps its last points, overwritten in place.
+///
+class OmniWarpSimCacheWriter
+{
+public:
+    OMNIWARPSCENEINDEX_API
+    static std::unique_ptr<OmniWarpSimCacheWriter> Create(const std::string& filePath, bool quantize);
+
+    OMNIWARPSCENEINDEX_API
+    ~OmniWarpSimCacheWriter();
+
+    // prevent copying and assignment
+    OmniWarpSimCacheWriter(const OmniWarpSimCacheWriter&) = delete;
+    OmniWarpSimCacheWriter& operator=(const OmniWarpSimCacheWriter&) = delete;
+
+    OMNIWARPSCENEINDEX_API
+    void WriteFrame(float time, const VtVec3fArray& points);
+
+private:
+    OmniWarpSimCacheWriter(const std::string& filePath, bool quantize);
+
+    bool _Write(const void* data, size_t size);
+    bool _WriteFrameData(const VtVec3fArray& points);
+    bool _Align();
+    bool _CoversExistingCache() const;
+
+    std::string _filePath;
+    TfAtomicOfstreamWrapper _wrapper;
+    bool _quantize;
+    bool _failed;
+    uint64_t _offset;
+
+    // point count and offset of each frame by time
+    std::map<float, std::pair<uint32_t, uint64_t>> _frames;
+};
+
+///
+/// \class OmniWarpSimCache
+///
+/// Plays back a baked simulation cache file.  The file is memory mapped
+/// and frames are read at random, so playback and scrubbing cost a copy
+/// (or dequantization) of the frame's points and nothing else.  Open
+/// validates the whole index, after which GetFrame may be called from
+/// several threads.
+///
+class OmniWarpSimCache
+{
+public:
+    OMNIWARPSCENEINDEX_API
+    static std::unique_ptr<OmniWarpSimCache> Open(const std::string& filePath);
+
+    // The cache file of primPath in cacheDir, or in the current
+    // directory if cacheDir is empty: the prim path made a valid
+    // identifier, followed by a hash of the path so that paths
+    // mapping to the same identifier get files of their own
+    OMNIWARPSCENEINDEX_API
+    static std::string GetCacheFilePath(const std::string& cacheDir, const SdfPath& primPath);
+
+    // prevent copying and assignment
+    OmniWarpSimCache(const OmniWarpSimCache&) = delete;
+    OmniWarpSimCache& operator=(const OmniWarpSimCache&) = delete;
+
+    /// Sets points to the frame baked at time, or the latest one before
+    /// it (the first one for times before the bake started).  Returns
+    /// false if the cache holds no frames.
+    OMNIWARPSCENEINDEX_API
+    bool GetFrame(float time, VtVec3fArray* points) const;
+
+    /// Returns the times of the baked frames, in order.
+    OMNIWARPSCENEINDEX_API
+    std::vector<float> GetFrameTimes() const;
+
+private:
+    OmniWarpSimCache() = default;
+
+    struct _Frame
+    {
+        float time;
+        uint32_t pointCount;
+        uint64_t offset;
+    };
+
+    ArchConstFileMapping _mapping;
+    bool _quantized = false;
+    std::vector<_Frame> _frames;
+};
+
+PXR_NAMESPACE_CLOSE_SCOPE
+
+#endif // OMNI_WARP_SCENE_INDEX_WARP_SIM_CACHE_H
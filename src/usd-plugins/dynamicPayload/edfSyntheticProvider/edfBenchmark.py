@@ -0,0 +1,246 @@
+# Copyright 2023 NVIDIA CORPORATION
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#    http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+"""
+Stage-open benchmark for the EDF file format.
+
+Builds an in-memory stage with a dynamic payload backed by the
+`edfSynthetic` data provider and measures stage open, payload
+unload / reload, full traversal, attribute read throughput and
+peak resident memory for each requested thread count.
+
+Each thread count is measured in its own process so that the
+concurrency limit and the peak RSS numbers are not polluted by
+previous runs.  Results are emitted as JSON.
+
+Run from an environment set up by setenvlinux / setenvwindows, e.g.:
+
+    python edfBenchmark.py --fan-out 8 --depth 3 --threads 1,4,8 --output results.json
+"""
+
+import argparse
+import json
+import os
+import statistics
+import subprocess
+import sys
+import time
+
+DEFAULT_EDF_ASSET = os.path.normpath(os.path.join(os.path.dirname(os.path.abspath(__file__)),
+    "..", "..", "..", "..", "resources", "empty.edf"))
+
+STAGE_TEMPLATE = """#usda 1.0
+(
+    defaultPrim = "World"
+)
+
+def Xform "World"
+{{
+    def "Synthetic" (
+        EdfDataParameters = {{
+            string dataProviderId = "{data_provider_id}"
+            dictionary providerArgs = {{
+{provider_args}
+            }}
+        }}
+        payload = @{edf_asset}@
+    )
+    {{
+    }}
+}}
+"""
+
+
+def _synthetic_args(args):
+    return {
+        "fanOut": str(args.fan_out),
+        "depth": str(args.depth),
+        "attributeCount": str(args.attribute_count),
+        "attributeTypes": args.attribute_types,
+        "stringLength": str(args.string_length),
+        "latencyMs": str(args.latency_ms),
+        "seed": str(args.seed),
+        "deferredRead": "true" if args.deferred else "false",
+    }
+
+
+def _data_provider_id(args):
+    return "edfSharded" if args.shards > 1 else "edfSynthetic"
+
+
+def _provider_args(args):
+    if args.shards <= 1:
+        return _synthetic_args(args)
+
+    # split the hierarchy across synthetic shards with distinct prim names
+    # so the merged result is the union of all of them
+    provider_args = {
+        "shardCount": str(args.shards),
+        "shardTimeoutMs": str(args.shard_timeout_ms),
+    }
+    for shard in range(args.shards):
+        prefix = "shard{}:".format(shard)
+        provider_args[prefix + "dataProviderId"] = "edfSynthetic"
+        provider_args[prefix + "namePrefix"] = "Shard{}_".format(shard)
+        for key, value in _synthetic_args(args).items():
+            provider_args[prefix + key] = value
+
+    return provider_args
+
+
+def _peak_rss_bytes():
+    try:
+        import resource
+        peak = resource.getrusage(resource.RUSAGE_SELF).ru_maxrss
+        # ru_maxrss is reported in kilobytes on Linux and bytes on macOS
+        return peak if sys.platform == "darwin" else peak * 1024
+    except ImportError:
+        pass
+
+    try:
+        import psutil
+        info = psutil.Process().memory_info()
+        return getattr(info, "peak_wset", info.rss)
+    except ImportError:
+        return None
+
+
+def _summarize(samples):
+    return {
+        "min": min(samples),
+        "median": statistics.median(samples),
+        "max": max(samples),
+    }
+
+
+def _run_worker(args):
+    from pxr import Sdf, Usd, Work
+
+    Work.SetConcurrencyLimitArgument(args.threads)
+
+    # keys are quoted since sharded arguments are namespaced ("shard0:fanOut")
+    provider_args = "\n".join(
+        '                string "{}" = "{}"'.format(key, value) for key, value in _provider_args(args).items())
+    stage_text = STAGE_TEMPLATE.format(data_provider_id=_data_provider_id(args), provider_args=provider_args,
+        edf_asset=args.edf_asset.replace("\\", "/"))
+
+    payload_path = Sdf.Path("/World/Synthetic")
+    open_times = []
+    load_and_unload_times = []
+    traverse_times = []
+    get_rates = []
+    prim_count = 0
+    attribute_count = 0
+
+    for _ in range(args.iterations):
+        root_layer = Sdf.Layer.CreateAnonymous(".usda")
+        root_layer.ImportFromString(stage_text)
+
+        start = time.perf_counter()
+        stage = Usd.Stage.Open(root_layer, Usd.Stage.LoadAll)
+        open_times.append(time.perf_counter() - start)
+
+        start = time.perf_counter()
+        stage.LoadAndUnload(set(), {payload_path})
+        stage.LoadAndUnload({payload_path}, set())
+        load_and_unload_times.append(time.perf_counter() - start)
+
+        start = time.perf_counter()
+        prims = [prim for prim in stage.Traverse()]
+        traverse_times.append(time.perf_counter() - start)
+        prim_count = len(prims)
+
+        attributes = [attribute for prim in prims for attribute in prim.GetAttributes()]
+        attribute_count = len(attributes)
+        start = time.perf_counter()
+        for attribute in attributes:
+            attribute.Get()
+        elapsed = time.perf_counter() - start
+        get_rates.append(attribute_count / elapsed if elapsed > 0.0 else 0.0)
+
+        del attributes
+        del prims
+        del stage
+        del root_layer
+
+    return {
+        "threads": args.threads,
+        "prims": prim_count,
+        "attributes": attribute_count,
+        "stageOpenSeconds": _summarize(open_times),
+        "loadAndUnloadSeconds": _summarize(load_and_unload_times),
+        "traverseSeconds": _summarize(traverse_times),
+        "attributeGetsPerSecond": _summarize(get_rates),
+        "peakRssBytes": _peak_rss_bytes(),
+    }
+
+
+def _run_parent(args):
+    results = []
+    for threads in [int(t) for t in args.threads_list.split(",") if t.strip()]:
+        command = [sys.executable, os.path.abspath(__file__), "--worker", "--threads", str(threads)]
+        for key, value in vars(args).items():
+            if key in ("worker", "threads", "threads_list", "output", "deferred"):
+                continue
+            command += ["--" + key.replace("_", "-"), str(value)]
+        if args.deferred:
+            command.append("--deferred")
+
+        output = subprocess.run(command, check=True, stdout=subprocess.PIPE, universal_newlines=True).stdout
+        results.append(json.loads(output.strip().splitlines()[-1]))
+
+    report = {
+        "benchmark": "edfStageOpen",
+        "dataProviderId": _data_provider_id(args),
+        "providerArgs": _provider_args(args),
+        "iterations": args.iterations,
+        "results": results,
+    }
+
+    text = json.dumps(report, indent=4)
+    if args.output:
+        with open(args.output, "w") as f:
+            f.write(text)
+    else:
+        print(text)
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Benchmarks stage open / traversal over the edfSynthetic provider")
+    parser.add_argument("--fan-out", type=int, default=4, help="children per prim")
+    parser.add_argument("--depth", type=int, default=3, help="levels below /Data")
+    parser.add_argument("--attribute-count", type=int, default=8, help="attributes per prim")
+    parser.add_argument("--attribute-types", default="int,float,string", help="comma separated attribute type mix")
+    parser.add_argument("--string-length", type=int, default=16, help="length of generated string values")
+    parser.add_argument("--latency-ms", type=int, default=0, help="artificial latency per provider call")
+    parser.add_argument("--seed", type=int, default=0, help="seed for generated values")
+    parser.add_argument("--deferred", action="store_true", help="generate children on demand")
+    parser.add_argument("--shards", type=int, default=1, help="split the hierarchy across this many synthetic shards")
+    parser.add_argument("--shard-timeout-ms", type=int, default=0, help="per-shard timeout when using shards")
+    parser.add_argument("--iterations", type=int, default=3, help="repetitions per thread count")
+    parser.add_argument("--threads", dest="threads_list", default="1,2,4,8", help="comma separated thread counts")
+    parser.add_argument("--edf-asset", default=DEFAULT_EDF_ASSET, help="path to the .edf asset used by the payload")
+    parser.add_argument("--output", default=None, help="file to write JSON results to (default stdout)")
+    parser.add_argument("--worker", action="store_true", help=argparse.SUPPRESS)
+    args, _ = parser.parse_known_args()
+
+    if args.worker:
+        args.threads = int(args.threads_list)
+        print(json.dumps(_run_worker(args)))
+    else:
+        _run_parent(args)
+
+
+if __name__ == "__main__":
+    main()
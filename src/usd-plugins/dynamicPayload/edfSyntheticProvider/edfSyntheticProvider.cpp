@@ -0,0 +1,301 @@
+// Copyright 2023 NVIDIA CORPORATION
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <chrono>
+#include <cstdint>
+#include <thread>
+
+#include <pxr/base/tf/stringUtils.h>
+#include <pxr/base/tf/token.h>
+#include <pxr/base/vt/value.h>
+#include <pxr/usd/sdf/path.h>
+#include <pxr/usd/sdf/schema.h>
+#include <pxr/usd/sdf/types.h>
+
+#include <edfDataProviderFactory.h>
+
+#include "edfSyntheticProvider.h"
+
+PXR_NAMESPACE_OPEN_SCOPE
+
+EDF_DEFINE_DATAPROVIDER(EdfSyntheticProvider);
+
+TF_DEFINE_PUBLIC_TOKENS(
+    EdfSyntheticProviderProviderArgKeys,
+    (deferredRead)
+    (fanOut)
+    (depth)
+    (attributeCount)
+    (attributeTypes)
+    (stringLength)
+    (latencyMs)
+    (seed)
+    (namePrefix)
+);
+
+TF_DEFINE_PRIVATE_TOKENS(
+    EdfSyntheticProviderTypeNames,
+    (Scope)
+);
+
+static const SdfPath DATA_ROOT_PATH("/Data");
+static const std::string DEFAULT_ATTRIBUTE_TYPES = "int,float,string";
+
+// FNV-1a, used instead of std::hash / SdfPath::GetHash so that
+// generated values are identical across runs and platforms
+static uint64_t _HashString(const std::string& value, uint64_t seed)
+{
+    uint64_t hash = 14695981039346656037ULL ^ seed;
+    for (const char c : value)
+    {
+        hash ^= static_cast<unsigned char>(c);
+        hash *= 1099511628211ULL;
+    }
+
+    return hash;
+}
+
+// splitmix64 step, good enough to turn a hash into well distributed values
+static uint64_t _NextRandom(uint64_t& state)
+{
+    uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+
+    return z ^ (z >> 31);
+}
+
+EdfSyntheticProvider::EdfSyntheticProvider(const EdfDataParameters& parameters) : IEdfDataProvider(parameters)
+{
+    this->_deferredRead = false;
+    std::unordered_map<std::string, std::string>::const_iterator it = parameters.providerArgs.find(EdfSyntheticProviderProviderArgKeys->deferredRead);
+    if (it != parameters.providerArgs.end())
+    {
+        this->_deferredRead = TfUnstringify<bool>(it->second);
+    }
+
+    this->_fanOut = this->_GetSizeArg(EdfSyntheticProviderProviderArgKeys->fanOut, 4);
+    this->_depth = this->_GetSizeArg(EdfSyntheticProviderProviderArgKeys->depth, 3);
+    this->_attributeCount = this->_GetSizeArg(EdfSyntheticProviderProviderArgKeys->attributeCount, 8);
+    this->_stringLength = this->_GetSizeArg(EdfSyntheticProviderProviderArgKeys->stringLength, 16);
+    this->_latencyMs = this->_GetSizeArg(EdfSyntheticProviderProviderArgKeys->latencyMs, 0);
+    this->_seed = this->_GetSizeArg(EdfSyntheticProviderProviderArgKeys->seed, 0);
+
+    this->_namePrefix = "Node_";
+    it = parameters.providerArgs.find(EdfSyntheticProviderProviderArgKeys->namePrefix);
+    if (it != parameters.providerArgs.end())
+    {
+        this->_namePrefix = it->second;
+    }
+
+    this->_ParseAttributeTypes();
+}
+
+EdfSyntheticProvider::~EdfSyntheticProvider()
+{
+}
+
+bool EdfSyntheticProvider::Read(std::shared_ptr<IEdfSourceData> sourceData)
+{
+    // if we aren't deferring the read, generate the entire hierarchy now
+    // otherwise each level is generated when the children are first asked for
+    if (!this->_deferredRead)
+    {
+        this->_SimulateLatency();
+        this->_GenerateChildren(DATA_ROOT_PATH, 0, true, sourceData);
+    }
+
+    return true;
+}
+
+bool EdfSyntheticProvider::ReadChildren(const std::string& parentPath, std::shared_ptr<IEdfSourceData> sourceData)
+{
+    if (!this->_deferredRead)
+    {
+        return false;
+    }
+
+    // the level of the parent is its distance from the data root
+    // so we can tell whether the children should be leaves or not
+    SdfPath parentPrimPath = SdfPath(parentPath);
+    if (!parentPrimPath.HasPrefix(DATA_ROOT_PATH))
+    {
+        return false;
+    }
+
+    this->_SimulateLatency();
+
+    size_t level = parentPrimPath.GetPathElementCount() - DATA_ROOT_PATH.GetPathElementCount();
+    this->_GenerateChildren(parentPrimPath, level, false, sourceData);
+
+    return true;
+}
+
+bool EdfSyntheticProvider::IsDataCached() const
+{
+    return !this->_deferredRead;
+}
+
+size_t EdfSyntheticProvider::_GetSizeArg(const TfToken& key, size_t defaultValue) const
+{
+    // negative values don't make practical sense for any of the
+    // synthetic arguments so we clamp them to 0
+    const EdfDataParameters& parameters = this->GetParameters();
+    std::unordered_map<std::string, std::string>::const_iterator it = parameters.providerArgs.find(key);
+    if (it != parameters.providerArgs.end())
+    {
+        int value = TfUnstringify<int>(it->second);
+        return value < 0 ? 0 : static_cast<size_t>(value);
+    }
+
+    return defaultValue;
+}
+
+void EdfSyntheticProvider::_ParseAttributeTypes()
+{
+    std::string attributeTypes = DEFAULT_ATTRIBUTE_TYPES;
+    const EdfDataParameters& parameters = this->GetParameters();
+    std::unordered_map<std::string, std::string>::const_iterator it = parameters.providerArgs.find(EdfSyntheticProviderProviderArgKeys->attributeTypes);
+    if (it != parameters.providerArgs.end())
+    {
+        attributeTypes = it->second;
+    }
+
+    for (const std::string& typeString : TfStringSplit(attributeTypes, ","))
+    {
+        const std::string typeName = TfStringTrim(typeString);
+        if (typeName == "int")
+        {
+            this->_attributeTypes.push_back(SdfValueTypeNames->Int);
+        }
+        else if (typeName == "float")
+        {
+            this->_attributeTypes.push_back(SdfValueTypeNames->Float);
+        }
+        else if (typeName == "double")
+        {
+            this->_attributeTypes.push_back(SdfValueTypeNames->Double);
+        }
+        else if (typeName == "bool")
+        {
+            this->_attributeTypes.push_back(SdfValueTypeNames->Bool);
+        }
+        else if (typeName == "string")
+        {
+            this->_attributeTypes.push_back(SdfValueTypeNames->String);
+        }
+        else if (typeName == "token")
+        {
+            this->_attributeTypes.push_back(SdfValueTypeNames->Token);
+        }
+        else if (!typeName.empty())
+        {
+            TF_WARN("Unsupported synthetic attribute type '%s', ignoring", typeName.c_str());
+        }
+    }
+
+    if (this->_attributeTypes.empty())
+    {
+        this->_attributeTypes.push_back(SdfValueTypeNames->Int);
+    }
+}
+
+void EdfSyntheticProvider::_SimulateLatency() const
+{
+    if (this->_latencyMs > 0)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(this->_latencyMs));
+    }
+}
+
+void EdfSyntheticProvider::_GenerateChildren(const SdfPath& parentPath, size_t level, bool recursive,
+    std::shared_ptr<IEdfSourceData> sourceData) const
+{
+    if (level >= this->_depth)
+    {
+        return;
+    }
+
+    for (size_t i = 0; i < this->_fanOut; i++)
+    {
+        std::string primName = this->_namePrefix + TfStringify(i);
+        sourceData->CreatePrim(parentPath, primName, SdfSpecifier::SdfSpecifierDef,
+            EdfSyntheticProviderTypeNames->Scope);
+
+        SdfPath primPath = parentPath.AppendChild(TfToken(primName));
+        this->_GenerateAttributes(primPath, sourceData);
+
+        if (recursive)
+        {
+            this->_GenerateChildren(primPath, level + 1, true, sourceData);
+        }
+    }
+}
+
+void EdfSyntheticProvider::_GenerateAttributes(const SdfPath& primPath, std::shared_ptr<IEdfSourceData> sourceData) const
+{
+    // values are seeded from the prim path so that deferred and non-deferred
+    // reads (and reads in any order) produce exactly the same data
+    uint64_t primSeed = _HashString(primPath.GetAsString(), this->_seed);
+    for (size_t i = 0; i < this->_attributeCount; i++)
+    {
+        const SdfValueTypeName& typeName = this->_attributeTypes[i % this->_attributeTypes.size()];
+        sourceData->CreateAttribute(primPath, "attr" + TfStringify(i), typeName,
+            SdfVariability::SdfVariabilityUniform, this->_GenerateValue(typeName, primSeed + i));
+    }
+}
+
+VtValue EdfSyntheticProvider::_GenerateValue(const SdfValueTypeName& typeName, size_t seed) const
+{
+    uint64_t state = seed;
+    uint64_t random = _NextRandom(state);
+    if (typeName == SdfValueTypeNames->Int)
+    {
+        return VtValue(static_cast<int>(random & 0x7FFFFFFF));
+    }
+    else if (typeName == SdfValueTypeNames->Float)
+    {
+        return VtValue(static_cast<float>(random >> 40) / static_cast<float>(1ULL << 24));
+    }
+    else if (typeName == SdfValueTypeNames->Double)
+    {
+        return VtValue(static_cast<double>(random >> 11) / static_cast<double>(1ULL << 53));
+    }
+    else if (typeName == SdfValueTypeNames->Bool)
+    {
+        return VtValue((random & 1) != 0);
+    }
+
+    // string and token values
+    std::string value(this->_stringLength, 'a');
+    for (size_t i = 0; i < this->_stringLength; i++)
+    {
+        if (i % 8 == 0)
+        {
+            random = _NextRandom(state);
+        }
+
+        value[i] = static_cast<char>('a' + (random % 26));
+        random /= 26;
+    }
+
+    if (typeName == SdfValueTypeNames->Token)
+    {
+        return VtValue(TfToken(value));
+    }
+
+    return VtValue(value);
+}
+
+PXR_NAMESPACE_CLOSE_SCOPE
@@ -0,0 +1,105 @@
+// Copyright 2023 NVIDIA CORPORATION
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef OMNI_EDFSYNTHETICPROVIDER_EDFSYNTHETICPROVIDER_H_
+#define OMNI_EDFSYNTHETICPROVIDER_EDFSYNTHETICPROVIDER_H_
+
+#include <string>
+#include <vector>
+
+#include <pxr/pxr.h>
+#include <pxr/base/tf/token.h>
+#include <pxr/usd/sdf/path.h>
+#include <pxr/usd/sdf/valueTypeName.h>
+
+#include <iEdfDataProvider.h>
+
+PXR_NAMESPACE_OPEN_SCOPE
+
+TF_DECLARE_PUBLIC_TOKENS(
+    EdfSyntheticProviderProviderArgKeys,
+    (deferredRead)
+    (fanOut)
+    (depth)
+    (attributeCount)
+    (attributeTypes)
+    (stringLength)
+    (latencyMs)
+    (seed)
+    (namePrefix)
+);
+
+/// \class EdfSyntheticProvider
+///
+/// Defines an EDF back-end data provider that generates a deterministic
+/// hierarchy of prims and attributes from its provider arguments alone.
+/// It never touches the network, which makes it suitable for measuring
+/// the cost of the EDF layer itself (e.g. stage open, traversal and
+/// attribute reads) independently of any real back-end.
+///
+/// The shape of the generated data is controlled by the following
+/// provider arguments:
+///
+/// - fanOut: number of children generated for each prim (default 4)
+/// - depth: number of levels generated below /Data (default 3)
+/// - attributeCount: number of attributes on each prim (default 8)
+/// - attributeTypes: comma separated list of attribute types cycled
+///   through when creating attributes, any of int, float, double,
+///   bool, string and token (default "int,float,string")
+/// - stringLength: length of generated string / token values (default 16)
+/// - latencyMs: artificial delay applied to every Read / ReadChildren
+///   call to emulate a remote back-end (default 0)
+/// - seed: seed for the value generator (default 0)
+/// - namePrefix: prefix of generated prim names (default "Node_")
+/// - deferredRead: if true, each level is generated on demand through
+///   ReadChildren rather than all at once on Read (default false)
+///
+class EdfSyntheticProvider : public IEdfDataProvider
+{
+public:
+
+    EdfSyntheticProvider(const EdfDataParameters& parameters);
+    virtual ~EdfSyntheticProvider();
+
+    virtual bool Read(std::shared_ptr<IEdfSourceData> sourceData) override;
+    virtual bool ReadChildren(const std::string& parentPath, std::shared_ptr<IEdfSourceData> sourceData) override;
+    virtual bool IsDataCached() const override;
+
+private:
+
+    size_t _GetSizeArg(const TfToken& key, size_t defaultValue) const;
+    void _ParseAttributeTypes();
+    void _SimulateLatency() const;
+
+    void _GenerateChildren(const SdfPath& parentPath, size_t level, bool recursive,
+        std::shared_ptr<IEdfSourceData> sourceData) const;
+    void _GenerateAttributes(const SdfPath& primPath, std::shared_ptr<IEdfSourceData> sourceData) const;
+    VtValue _GenerateValue(const SdfValueTypeName& typeName, size_t seed) const;
+
+private:
+
+    bool _deferredRead;
+    size_t _fanOut;
+    size_t _depth;
+    size_t _attributeCount;
+    size_t _stringLength;
+    size_t _latencyMs;
+    size_t _seed;
+    std::string _namePrefix;
+    std::vector<SdfValueTypeName> _attributeTypes;
+};
+
+PXR_NAMESPACE_CLOSE_SCOPE
+
+#endif
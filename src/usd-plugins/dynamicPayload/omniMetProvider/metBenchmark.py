@@ -0,0 +1,251 @@
+# Copyright 2023 NVIDIA CORPORATION
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#    http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+"""
+Stage-open benchmark for the omniMet provider against the local stand-in.
+
+Serves a directory of responses recorded with transport = "record" through
+metStandInServer.py and opens a stage over the omniMet provider pointed at
+it with the curl transport, so the whole HTTP path is exercised without
+the network.  For every open it reports the time to open and traverse
+the stage, and from the stand-in the connections the provider opened,
+the requests it sent and the body bytes it downloaded.
+
+Each open runs in its own process, so the process-wide object store and
+connection pools of one open don't serve the next.  With --http-cache the
+opens share an HTTP cache directory instead: the first open is cold,
+the following ones revalidate the cached responses and, with --offline,
+a last one is served from the cache alone.  Further provider arguments,
+such as the isHighlight / hasImages selection, are added with
+--provider-arg.  Results are emitted as JSON.
+
+Run from an environment set up by setenvlinux / setenvwindows, e.g.:
+
+    python metBenchmark.py --recordings recordings --lod1-count 53 --latency-ms 20 --output results.json
+"""
+
+import argparse
+import json
+import os
+import shutil
+import socket
+import statistics
+import subprocess
+import sys
+import tempfile
+import time
+import urllib.request
+
+STAND_IN_SERVER = os.path.join(os.path.dirname(os.path.abspath(__file__)), "metStandInServer.py")
+
+DEFAULT_EDF_ASSET = os.path.normpath(os.path.join(os.path.dirname(os.path.abspath(__file__)),
+    "..", "..", "..", "..", "resources", "empty.edf"))
+
+STAGE_TEMPLATE = """#usda 1.0
+(
+    defaultPrim = "World"
+)
+
+def Xform "World"
+{{
+    def "MetropolitanMuseumOfArt" (
+        EdfDataParameters = {{
+            string dataProviderId = "omniMet"
+            dictionary providerArgs = {{
+{provider_args}
+            }}
+        }}
+        payload = @{edf_asset}@
+    )
+    {{
+    }}
+}}
+"""
+
+
+def _provider_args(args, base_url, offline=False):
+    provider_args = {
+        "dataLodLevel": "1",
+        "lod1Count": str(args.lod1_count),
+        "deferredRead": "false",
+        "maxInFlightRequests": str(args.max_in_flight_requests),
+        "baseUrl": base_url,
+        "transport": "curl",
+    }
+    for provider_arg in args.provider_arg:
+        key, _, value = provider_arg.partition("=")
+        provider_args[key] = value
+    if offline:
+        provider_args["offline"] = "true"
+    return provider_args
+
+
+def _free_port():
+    with socket.socket(socket.AF_INET, socket.SOCK_STREAM) as s:
+        s.bind(("127.0.0.1", 0))
+        return s.getsockname()[1]
+
+
+def _get_stats(base_url, reset):
+    url = base_url + "__stats" + ("?reset=1" if reset else "")
+    with urllib.request.urlopen(url) as response:
+        return json.loads(response.read().decode("utf-8"))
+
+
+def _start_stand_in(args, port):
+    command = [sys.executable, STAND_IN_SERVER, "--directory", args.recordings, "--port", str(port),
+        "--latency-ms", str(args.latency_ms), "--jitter-ms", str(args.jitter_ms)]
+    server = subprocess.Popen(command, stdout=subprocess.DEVNULL)
+
+    base_url = "http://127.0.0.1:{}/".format(port)
+    deadline = time.time() + 10.0
+    while True:
+        try:
+            _get_stats(base_url, True)
+            return server, base_url
+        except OSError:
+            if time.time() > deadline or server.poll() is not None:
+                server.kill()
+                sys.exit("The stand-in server didn't start")
+            time.sleep(0.1)
+
+
+def _run_worker(args):
+    from pxr import Sdf, Usd
+
+    provider_args = "\n".join(
+        '                string "{}" = "{}"'.format(key, value)
+        for key, value in _provider_args(args, args.base_url, args.offline).items())
+    stage_text = STAGE_TEMPLATE.format(provider_args=provider_args, edf_asset=args.edf_asset.replace("\\", "/"))
+
+    root_layer = Sdf.Layer.CreateAnonymous(".usda")
+    root_layer.ImportFromString(stage_text)
+
+    start = time.perf_counter()
+    stage = Usd.Stage.Open(root_layer, Usd.Stage.LoadAll)
+    prim_count = len([prim for prim in stage.Traverse()])
+    elapsed = time.perf_counter() - start
+
+    return {
+        "prims": prim_count,
+        "openSeconds": elapsed,
+    }
+
+
+def _run_open(args, base_url, phase, cache_dir=None, offline=False):
+    command = [sys.executable, os.path.abspath(__file__), "--worker", "--base-url", base_url,
+        "--lod1-count", str(args.lod1_count), "--max-in-flight-requests", str(args.max_in_flight_requests),
+        "--edf-asset", args.edf_asset]
+    for provider_arg in args.provider_arg:
+        command += ["--provider-arg", provider_arg]
+    if offline:
+        command.append("--offline")
+
+    env = dict(os.environ)
+    env.pop("OMNI_MET_HTTP_CACHE_DIR", None)
+    if cache_dir is not None:
+        env["OMNI_MET_HTTP_CACHE_DIR"] = cache_dir
+
+    _get_stats(base_url, True)
+    output = subprocess.run(command, check=True, stdout=subprocess.PIPE, universal_newlines=True, env=env).stdout
+    result = {"phase": phase}
+    result.update(json.loads(output.strip().splitlines()[-1]))
+    result.update(_get_stats(base_url, True))
+    return result
+
+
+def _run_opens(args, base_url):
+    if not args.http_cache:
+        return [_run_open(args, base_url, "uncached") for _ in range(args.iterations)]
+
+    cache_dir = tempfile.mkdtemp(prefix="omniMetHttpCache")
+    try:
+        opens = [_run_open(args, base_url, "cold", cache_dir)]
+        opens += [_run_open(args, base_url, "warm", cache_dir) for _ in range(args.iterations)]
+        if args.offline:
+            opens.append(_run_open(args, base_url, "offline", cache_dir, offline=True))
+        return opens
+    finally:
+        shutil.rmtree(cache_dir, ignore_errors=True)
+
+
+def _summarize(samples):
+    return {
+        "min": min(samples),
+        "median": statistics.median(samples),
+        "max": max(samples),
+    }
+
+
+def _run_parent(args):
+    server, base_url = _start_stand_in(args, args.port or _free_port())
+    try:
+        opens = _run_opens(args, base_url)
+    finally:
+        server.kill()
+        server.wait()
+
+    report = {
+        "benchmark": "omniMetStageOpen",
+        "providerArgs": _provider_args(args, base_url),
+        "latencyMs": args.latency_ms,
+        "jitterMs": args.jitter_ms,
+        "iterations": args.iterations,
+        "openSeconds": {phase: _summarize([result["openSeconds"] for result in opens if result["phase"] == phase])
+            for phase in sorted(set(result["phase"] for result in opens))},
+        "opens": opens,
+    }
+
+    text = json.dumps(report, indent=4)
+    if args.output:
+        with open(args.output, "w") as f:
+            f.write(text)
+    else:
+        print(text)
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Benchmarks stage open over the omniMet provider and the stand-in")
+    parser.add_argument("--recordings", help="directory of responses recorded with transport = \"record\"")
+    parser.add_argument("--lod1-count", type=int, default=20, help="objects loaded per department")
+    parser.add_argument("--max-in-flight-requests", type=int, default=16, help="concurrent requests per fetch")
+    parser.add_argument("--latency-ms", type=float, default=0.0, help="delay the stand-in adds to every response")
+    parser.add_argument("--jitter-ms", type=float, default=0.0, help="random variation of the delay")
+    parser.add_argument("--port", type=int, default=0, help="port of the stand-in (default any free port)")
+    parser.add_argument("--iterations", type=int, default=3, help="number of (warm) stage opens")
+    parser.add_argument("--http-cache", action="store_true", help="share an HTTP cache, measuring cold and warm opens")
+    parser.add_argument("--offline", action="store_true", help="with --http-cache, finish with an offline open")
+    parser.add_argument("--provider-arg", action="append", default=[], metavar="KEY=VALUE",
+        help="additional provider argument, may be repeated")
+    parser.add_argument("--edf-asset", default=DEFAULT_EDF_ASSET, help="path to the .edf asset used by the payload")
+    parser.add_argument("--output", default=None, help="file to write JSON results to (default stdout)")
+    parser.add_argument("--worker", action="store_true", help=argparse.SUPPRESS)
+    parser.add_argument("--base-url", help=argparse.SUPPRESS)
+    args = parser.parse_args()
+
+    if args.worker:
+        print(json.dumps(_run_worker(args)))
+        return
+
+    for provider_arg in args.provider_arg:
+        if "=" not in provider_arg:
+            sys.exit("--provider-arg must be of the form key=value: " + provider_arg)
+
+    if not args.recordings or not os.path.isdir(args.recordings):
+        sys.exit("--recordings must name a directory of recorded responses")
+    _run_parent(args)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,185 @@
+# Copyright 2023 NVIDIA CORPORATION
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#    http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+"""
+Local stand-in for the Met collection API.
+
+Serves responses recorded by the omniMet provider (transport = "record")
+over HTTP, so the provider can be run end to end with the curl transport
+without access to collectionapi.metmuseum.org:
+
+    python metStandInServer.py --directory recordings --port 8000 --latency-ms 50 --jitter-ms 20
+
+and point the provider at it with
+
+    string baseUrl = "http://127.0.0.1:8000/"
+
+Responses carry an ETag computed from their content and requests with a
+matching If-None-Match are answered with 304, so the provider's HTTP
+cache revalidation can be exercised as well.
+
+GET /__stats returns the connections accepted, requests served (by
+status) and body bytes sent so far as JSON, /__stats?reset=1 also
+resets them.  metBenchmark.py uses these to report what a stage open
+cost on the wire.
+"""
+
+import argparse
+import hashlib
+import os
+import random
+import json
+import re
+import sys
+import threading
+import time
+from http.server import BaseHTTPRequestHandler, ThreadingHTTPServer
+
+
+RECORDING_NAME_MAX_PREFIX = 96
+
+
+def _hash_recording_url(relative_url):
+    # 64 bit FNV-1a of the url's bytes
+    hash = 14695981039346656037
+    for byte in relative_url.encode("utf-8"):
+        hash ^= byte
+        hash = (hash * 1099511628211) & 0xFFFFFFFFFFFFFFFF
+    return hash
+
+
+def recording_name(relative_url):
+    # must match OmniMetGetRecordingName
+    prefix = re.sub(r"[^A-Za-z0-9]", "_", relative_url.encode("utf-8")[:RECORDING_NAME_MAX_PREFIX].decode("latin-1"))
+    return "{}_{:016x}.json".format(prefix, _hash_recording_url(relative_url))
+
+
+class Stats:
+    def __init__(self):
+        self._lock = threading.Lock()
+        self.reset()
+
+    def reset(self):
+        with self._lock:
+            self.connections = 0
+            self.requests = 0
+            self.statuses = {}
+            self.body_bytes = 0
+
+    def count_connection(self):
+        with self._lock:
+            self.connections += 1
+
+    def count_response(self, status, body_bytes):
+        with self._lock:
+            self.requests += 1
+            self.statuses[str(status)] = self.statuses.get(str(status), 0) + 1
+            self.body_bytes += body_bytes
+
+    def to_json(self):
+        with self._lock:
+            return {
+                "connections": self.connections,
+                "requests": self.requests,
+                "statuses": dict(self.statuses),
+                "bodyBytes": self.body_bytes,
+            }
+
+
+class StandInHandler(BaseHTTPRequestHandler):
+    protocol_version = "HTTP/1.1"
+
+    def setup(self):
+        # one handler per connection, kept alive across its requests.
+        # The connection is counted with its first request other than
+        # /__stats, so reading the stats doesn't show up in them
+        super().setup()
+        self.counted = False
+
+    def do_GET(self):
+        server = self.server
+        if self.path.startswith("/__stats"):
+            stats = server.stats.to_json()
+            if "reset=1" in self.path:
+                server.stats.reset()
+            self._send(200, json.dumps(stats).encode("utf-8"), count=False)
+            return
+
+        if server.latency_ms > 0 or server.jitter_ms > 0:
+            delay = server.latency_ms + random.uniform(-server.jitter_ms, server.jitter_ms)
+            time.sleep(max(delay, 0.0) / 1000.0)
+
+        path = os.path.join(server.directory, recording_name(self.path.lstrip("/")))
+        if not os.path.isfile(path):
+            self._send(404, b'{"message": "Not Found"}')
+            return
+
+        with open(path, "rb") as f:
+            body = f.read()
+
+        etag = '"{}"'.format(hashlib.sha1(body).hexdigest())
+        if self.headers.get("If-None-Match") == etag:
+            self._send(304, b"", etag)
+        else:
+            self._send(200, body, etag)
+
+    def _send(self, status, body, etag=None, count=True):
+        if count:
+            if not self.counted:
+                self.counted = True
+                self.server.stats.count_connection()
+            self.server.stats.count_response(status, len(body))
+        self.send_response(status)
+        self.send_header("Content-Type", "application/json")
+        self.send_header("Content-Length", str(len(body)))
+        if etag is not None:
+            self.send_header("ETag", etag)
+        self.end_headers()
+        self.wfile.write(body)
+
+    def log_message(self, format, *args):
+        if self.server.verbose:
+            super().log_message(format, *args)
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Serves recorded Met collection API responses")
+    parser.add_argument("--directory", required=True, help="directory holding the recorded responses")
+    parser.add_argument("--host", default="127.0.0.1", help="address to listen on")
+    parser.add_argument("--port", type=int, default=8000, help="port to listen on")
+    parser.add_argument("--latency-ms", type=float, default=0.0, help="delay added to every response")
+    parser.add_argument("--jitter-ms", type=float, default=0.0, help="random variation of the delay")
+    parser.add_argument("--verbose", action="store_true", help="log every request")
+    args = parser.parse_args()
+
+    if not os.path.isdir(args.directory):
+        sys.exit("'{}' is not a directory".format(args.directory))
+
+    server = ThreadingHTTPServer((args.host, args.port), StandInHandler)
+    server.daemon_threads = True
+    server.directory = args.directory
+    server.latency_ms = args.latency_ms
+    server.jitter_ms = args.jitter_ms
+    server.verbose = args.verbose
+    server.stats = Stats()
+
+    print("Serving '{}' on http://{}:{}/".format(args.directory, args.host, args.port))
+    try:
+        server.serve_forever()
+    except KeyboardInterrupt:
+        pass
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,157 @@
+// Copyright 2023 NVIDIA CORPORATION
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <vector>
+
+#include <pxr/base/tf/diagnostic.h>
+#include <pxr/base/tf/instantiateSingleton.h>
+
+#include "omniMetConnectionPool.h"
+
+PXR_NAMESPACE_OPEN_SCOPE
+
+TF_INSTANTIATE_SINGLETON(OmniMetConnectionPool);
+
+namespace {
+
+// handles owned by a single thread, cleaned up when the thread exits
+struct _ThreadHandles
+{
+    std::vector<CURL*> easyHandles;
+    CURLM* multiHandle = nullptr;
+
+    ~_ThreadHandles()
+    {
+        for (CURL* handle : this->easyHandles)
+        {
+            curl_easy_cleanup(handle);
+        }
+
+        if (this->multiHandle != nullptr)
+        {
+            curl_multi_cleanup(this->multiHandle);
+        }
+    }
+};
+
+thread_local _ThreadHandles _threadHandles;
+
+}
+
+OmniMetConnectionPool::OmniMetConnectionPool()
+{
+    // NOTE: curl_global_init is not thread-safe in older libcurl versions,
+    // constructing the singleton is, so this is the one place it's called
+    curl_global_init(CURL_GLOBAL_DEFAULT);
+
+    this->_share = curl_share_init();
+    if (this->_share != nullptr)
+    {
+        curl_share_setopt(this->_share, CURLSHOPT_LOCKFUNC, OmniMetConnectionPool::_LockShare);
+        curl_share_setopt(this->_share, CURLSHOPT_UNLOCKFUNC, OmniMetConnectionPool::_UnlockShare);
+        curl_share_setopt(this->_share, CURLSHOPT_USERDATA, reinterpret_cast<void*>(this));
+        curl_share_setopt(this->_share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+        curl_share_setopt(this->_share, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+    }
+    else
+    {
+        TF_WARN("Unable to create a curl share handle, DNS and TLS sessions won't be shared");
+    }
+}
+
+OmniMetConnectionPool::~OmniMetConnectionPool()
+{
+    if (this->_share != nullptr)
+    {
+        curl_share_cleanup(this->_share);
+    }
+
+    curl_global_cleanup();
+}
+
+CURL* OmniMetConnectionPool::AcquireEasyHandle()
+{
+    if (!_threadHandles.easyHandles.empty())
+    {
+        CURL* handle = _threadHandles.easyHandles.back();
+        _threadHandles.easyHandles.pop_back();
+
+        return handle;
+    }
+
+    CURL* handle = curl_easy_init();
+    if (handle != nullptr)
+    {
+        this->_ApplyDefaults(handle);
+    }
+
+    return handle;
+}
+
+void OmniMetConnectionPool::ReleaseEasyHandle(CURL* handle)
+{
+    if (handle == nullptr)
+    {
+        return;
+    }
+
+    // resetting keeps the handle's open connections and caches
+    // but drops whatever the last user configured
+    curl_easy_reset(handle);
+    this->_ApplyDefaults(handle);
+    _threadHandles.easyHandles.push_back(handle);
+}
+
+CURLM* OmniMetConnectionPool::GetMultiHandle()
+{
+    if (_threadHandles.multiHandle == nullptr)
+    {
+        _threadHandles.multiHandle = curl_multi_init();
+        if (_threadHandles.multiHandle != nullptr)
+        {
+            curl_multi_setopt(_threadHandles.multiHandle, CURLMOPT_PIPELINING, CURLPIPE_MULTIPLEX);
+        }
+    }
+
+    return _threadHandles.multiHandle;
+}
+
+void OmniMetConnectionPool::_ApplyDefaults(CURL* handle) const
+{
+    if (this->_share != nullptr)
+    {
+        curl_easy_setopt(handle, CURLOPT_SHARE, this->_share);
+    }
+
+    // use HTTP/2 when the server negotiates it over TLS and wait for
+    // an existing connection to multiplex on rather than opening more
+    curl_easy_setopt(handle, CURLOPT_HTTP_VERSION, CURL_HTTP_VERSION_2TLS);
+    curl_easy_setopt(handle, CURLOPT_PIPEWAIT, 1L);
+    curl_easy_setopt(handle, CURLOPT_TCP_KEEPALIVE, 1L);
+    curl_easy_setopt(handle, CURLOPT_HTTPGET, 1L);
+}
+
+void OmniMetConnectionPool::_LockShare(CURL* handle, curl_lock_data data, curl_lock_access access, void* userp)
+{
+    OmniMetConnectionPool* pool = reinterpret_cast<OmniMetConnectionPool*>(userp);
+    pool->_shareMutexes[data].lock();
+}
+
+void OmniMetConnectionPool::_UnlockShare(CURL* handle, curl_lock_data data, void* userp)
+{
+    OmniMetConnectionPool* pool = reinterpret_cast<OmniMetConnectionPool*>(userp);
+    pool->_shareMutexes[data].unlock();
+}
+
+PXR_NAMESPACE_CLOSE_SCOPE
@@ -0,0 +1,89 @@
+// Copyright 2023 NVIDIA CORPORATION
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef OMNI_OMNIMETPROVIDER_OMNIMETCONNECTIONPOOL_H_
+#define OMNI_OMNIMETPROVIDER_OMNIMETCONNECTIONPOOL_H_
+
+#include <mutex>
+
+#include <pxr/pxr.h>
+#include <pxr/base/tf/singleton.h>
+
+#include <curl/curl.h>
+
+PXR_NAMESPACE_OPEN_SCOPE
+
+/// \class OmniMetConnectionPool
+///
+/// Owns the process-wide libcurl state used to talk to the Met
+/// collection API.  libcurl is globally initialized exactly once, when
+/// the pool is first used, and all handles handed out share one DNS and
+/// TLS session cache.
+///
+/// Easy handles and multi handles are pooled per thread (libcurl handles
+/// can't be used from several threads at once) and are kept alive between
+/// requests, so connections to the server are reused rather than set up
+/// again for every request.  Handles prefer HTTP/2 over TLS, so
+/// concurrent transfers on a multi handle are multiplexed over a single
+/// connection where the server supports it.
+///
+class OmniMetConnectionPool
+{
+public:
+    static OmniMetConnectionPool& GetInstance()
+    {
+        return TfSingleton<OmniMetConnectionPool>::GetInstance();
+    }
+
+    // prevent copying and assignment
+    OmniMetConnectionPool(const OmniMetConnectionPool&) = delete;
+    OmniMetConnectionPool& operator=(const OmniMetConnectionPool&) = delete;
+
+    /// Returns an easy handle from the calling thread's pool, configured
+    /// with the shared defaults.  The handle must be given back with
+    /// ReleaseEasyHandle on the same thread.
+    CURL* AcquireEasyHandle();
+
+    /// Returns handle to the calling thread's pool.  Options set by the
+    /// caller are reset, open connections are kept.
+    void ReleaseEasyHandle(CURL* handle);
+
+    /// Returns the calling thread's multi handle.  Connections opened by
+    /// transfers run on it are kept open for later transfers.  Callers must
+    /// remove all easy handles they add before returning.
+    CURLM* GetMultiHandle();
+
+private:
+
+    OmniMetConnectionPool();
+    ~OmniMetConnectionPool();
+
+    void _ApplyDefaults(CURL* handle) const;
+
+    static void _LockShare(CURL* handle, curl_lock_data data, curl_lock_access access, void* userp);
+    static void _UnlockShare(CURL* handle, curl_lock_data data, void* userp);
+
+    friend class TfSingleton<OmniMetConnectionPool>;
+
+private:
+
+    CURLSH* _share;
+
+    // one mutex per kind of data the share handle protects
+    std::mutex _shareMutexes[CURL_LOCK_DATA_LAST];
+};
+
+PXR_NAMESPACE_CLOSE_SCOPE
+
+#endif
@@ -0,0 +1,256 @@
+// Copyright 2023 NVIDIA CORPORATION
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdlib>
+#include <ctime>
+#include <thread>
+
+#include <pxr/base/tf/stringUtils.h>
+
+#include "omniMetCurlTransport.h"
+#include "omniMetConnectionPool.h"
+#include "omniMetRateLimiter.h"
+
+PXR_NAMESPACE_OPEN_SCOPE
+
+// upper bound on how long we sit in curl_multi_wait, so that
+// transfers waiting on the rate limiter are started promptly
+static const int MAX_WAIT_MS = 100;
+
+// the most we reserve for a body based on its Content-Length
+static const long long MAX_RESERVED_BODY_SIZE = 64 * 1024 * 1024;
+
+namespace {
+
+// state of one transfer slot, the easy handle is reused
+// for every request that goes through the slot
+struct _Transfer
+{
+    CURL* handle = nullptr;
+    struct curl_slist* headers = nullptr;
+    const OmniMetHttpRequest* request = nullptr;
+    OmniMetHttpResponse response;
+};
+
+}
+
+OmniMetCurlTransport::OmniMetCurlTransport()
+{
+}
+
+OmniMetCurlTransport::~OmniMetCurlTransport()
+{
+}
+
+void OmniMetCurlTransport::Fetch(const std::vector<OmniMetHttpRequest>& requests, size_t maxInFlightRequests,
+    const CompletionCallback& onComplete)
+{
+    if (requests.empty())
+    {
+        return;
+    }
+
+    // the handles come from the thread's pool, so connections opened by
+    // earlier fetches on this thread are reused
+    OmniMetConnectionPool& connectionPool = OmniMetConnectionPool::GetInstance();
+    CURLM* multiHandle = connectionPool.GetMultiHandle();
+
+    // one slot per concurrent transfer, never more than we have requests for
+    std::vector<_Transfer> transfers(std::min(std::max<size_t>(maxInFlightRequests, 1), requests.size()));
+    std::vector<_Transfer*> freeTransfers;
+    for (_Transfer& transfer : transfers)
+    {
+        transfer.handle = (multiHandle != nullptr) ? connectionPool.AcquireEasyHandle() : nullptr;
+        if (transfer.handle == nullptr)
+        {
+            continue;
+        }
+
+        curl_easy_setopt(transfer.handle, CURLOPT_WRITEFUNCTION, OmniMetCurlTransport::_CurlWriteCallback);
+        curl_easy_setopt(transfer.handle, CURLOPT_WRITEDATA, reinterpret_cast<void*>(&transfer.response.body));
+        curl_easy_setopt(transfer.handle, CURLOPT_HEADERFUNCTION, OmniMetCurlTransport::_CurlHeaderCallback);
+        curl_easy_setopt(transfer.handle, CURLOPT_HEADERDATA, reinterpret_cast<void*>(&transfer.response));
+        curl_easy_setopt(transfer.handle, CURLOPT_PRIVATE, reinterpret_cast<void*>(&transfer));
+        freeTransfers.push_back(&transfer);
+    }
+
+    if (freeTransfers.empty())
+    {
+        OmniMetHttpResponse response;
+        response.error = "unable to create curl handles";
+        for (const OmniMetHttpRequest& request : requests)
+        {
+            onComplete(request, response);
+        }
+
+        return;
+    }
+
+    OmniMetRateLimiter& rateLimiter = OmniMetRateLimiter::GetInstance();
+    size_t nextRequest = 0;
+    size_t inFlight = 0;
+    while (nextRequest < requests.size() || inFlight > 0)
+    {
+        // start as many transfers as we have free slots and tokens for
+        OmniMetRateLimiter::Clock::duration tokenWait = OmniMetRateLimiter::Clock::duration::zero();
+        while (nextRequest < requests.size() && !freeTransfers.empty() && rateLimiter.TryAcquire(&tokenWait))
+        {
+            _Transfer* transfer = freeTransfers.back();
+            freeTransfers.pop_back();
+
+            transfer->request = &requests[nextRequest++];
+            transfer->response = OmniMetHttpResponse();
+
+            // conditional requests let the server answer 304
+            // instead of sending a response we already have
+            curl_slist_free_all(transfer->headers);
+            transfer->headers = nullptr;
+            const OmniMetHttpValidators& validators = transfer->request->validators;
+            if (!validators.etag.empty())
+            {
+                transfer->headers = curl_slist_append(transfer->headers, ("If-None-Match: " + validators.etag).c_str());
+            }
+            if (!validators.lastModified.empty())
+            {
+                transfer->headers = curl_slist_append(transfer->headers, ("If-Modified-Since: " + validators.lastModified).c_str());
+            }
+
+            curl_easy_setopt(transfer->handle, CURLOPT_HTTPHEADER, transfer->headers);
+            curl_easy_setopt(transfer->handle, CURLOPT_URL, transfer->request->url.c_str());
+            curl_multi_add_handle(multiHandle, transfer->handle);
+            inFlight++;
+        }
+
+        if (inFlight == 0)
+        {
+            // nothing to wait on but the rate limiter
+            std::this_thread::sleep_for(tokenWait);
+            continue;
+        }
+
+        int running = 0;
+        curl_multi_perform(multiHandle, &running);
+
+        // hand over everything that finished
+        int messagesLeft = 0;
+        CURLMsg* message = nullptr;
+        while ((message = curl_multi_info_read(multiHandle, &messagesLeft)) != nullptr)
+        {
+            if (message->msg != CURLMSG_DONE)
+            {
+                continue;
+            }
+
+            _Transfer* transfer = nullptr;
+            curl_easy_getinfo(message->easy_handle, CURLINFO_PRIVATE, reinterpret_cast<char**>(&transfer));
+            if (message->data.result == CURLE_OK)
+            {
+                curl_easy_getinfo(message->easy_handle, CURLINFO_RESPONSE_CODE, &transfer->response.statusCode);
+            }
+            else
+            {
+                transfer->response.error = curl_easy_strerror(message->data.result);
+            }
+
+            curl_multi_remove_handle(multiHandle, message->easy_handle);
+            onComplete(*transfer->request, transfer->response);
+
+            freeTransfers.push_back(transfer);
+            inFlight--;
+        }
+
+        // wait for socket activity, but not longer than it takes
+        // for the next token if there is still work to start
+        if (running > 0)
+        {
+            int waitMs = MAX_WAIT_MS;
+            if (nextRequest < requests.size() && !freeTransfers.empty())
+            {
+                waitMs = std::min(waitMs, static_cast<int>(
+                    std::chrono::duration_cast<std::chrono::milliseconds>(tokenWait).count()));
+            }
+
+            curl_multi_wait(multiHandle, nullptr, 0, waitMs, nullptr);
+        }
+    }
+
+    for (_Transfer& transfer : transfers)
+    {
+        connectionPool.ReleaseEasyHandle(transfer.handle);
+        curl_slist_free_all(transfer.headers);
+    }
+}
+
+size_t OmniMetCurlTransport::_CurlWriteCallback(void* data, size_t size, size_t nmemb, void* userp)
+{
+    std::string* result = reinterpret_cast<std::string*>(userp);
+    result->append(reinterpret_cast<const char*>(data), size * nmemb);
+
+    return size * nmemb;
+}
+
+size_t OmniMetCurlTransport::_CurlHeaderCallback(char* buffer, size_t size, size_t nitems, void* userp)
+{
+    // headers arrive one line at a time, including the trailing CRLF
+    OmniMetHttpResponse* response = reinterpret_cast<OmniMetHttpResponse*>(userp);
+    std::string header(buffer, size * nitems);
+    size_t separator = header.find(':');
+    if (separator != std::string::npos)
+    {
+        std::string name = TfStringToLower(header.substr(0, separator));
+        if (name == "etag")
+        {
+            response->validators.etag = TfStringTrim(header.substr(separator + 1));
+        }
+        else if (name == "last-modified")
+        {
+            response->validators.lastModified = TfStringTrim(header.substr(separator + 1));
+        }
+        else if (name == "content-length")
+        {
+            // size the body up front rather than growing it as the data
+            // arrives, the length is only a hint so it is capped in case
+            // the server claims something absurd
+            long long contentLength = std::strtoll(header.c_str() + separator + 1, nullptr, 10);
+            if (contentLength > 0)
+            {
+                response->body.reserve(static_cast<size_t>(std::min<long long>(contentLength, MAX_RESERVED_BODY_SIZE)));
+            }
+        }
+        else if (name == "retry-after")
+        {
+            // either a number of seconds or an HTTP date
+            std::string value = TfStringTrim(header.substr(separator + 1));
+            if (!value.empty() && std::all_of(value.begin(), value.end(), ::isdigit))
+            {
+                response->retryAfterSeconds = std::strtol(value.c_str(), nullptr, 10);
+            }
+            else
+            {
+                time_t retryTime = curl_getdate(value.c_str(), nullptr);
+                if (retryTime != -1)
+                {
+                    response->retryAfterSeconds = std::max<long>(static_cast<long>(retryTime - time(nullptr)), 0);
+                }
+            }
+        }
+    }
+
+    return size * nitems;
+}
+
+PXR_NAMESPACE_CLOSE_SCOPE
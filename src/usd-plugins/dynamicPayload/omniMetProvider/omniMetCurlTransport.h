@@ -0,0 +1,49 @@
+// Copyright 2023 NVIDIA CORPORATION
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef OMNI_OMNIMETPROVIDER_OMNIMETCURLTRANSPORT_H_
+#define OMNI_OMNIMETPROVIDER_OMNIMETCURLTRANSPORT_H_
+
+#include <pxr/pxr.h>
+
+#include "omniMetTransport.h"
+
+PXR_NAMESPACE_OPEN_SCOPE
+
+/// \class OmniMetCurlTransport
+///
+/// Transport performing requests with libcurl.  Requests run concurrently
+/// over the calling thread's pooled multi handle (see OmniMetConnectionPool)
+/// and each one is started only once the process-wide OmniMetRateLimiter
+/// allows it.
+///
+class OmniMetCurlTransport : public OmniMetTransport
+{
+public:
+
+    OmniMetCurlTransport();
+    virtual ~OmniMetCurlTransport();
+
+    virtual void Fetch(const std::vector<OmniMetHttpRequest>& requests, size_t maxInFlightRequests,
+        const CompletionCallback& onComplete) override;
+
+private:
+
+    static size_t _CurlWriteCallback(void* data, size_t size, size_t nmemb, void* userp);
+    static size_t _CurlHeaderCallback(char* buffer, size_t size, size_t nitems, void* userp);
+};
+
+PXR_NAMESPACE_CLOSE_SCOPE
+
+#endif
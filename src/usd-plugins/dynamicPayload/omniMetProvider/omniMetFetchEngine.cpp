@@ -0,0 +1,267 @@
+// Copyright 2023 NVIDIA CORPORATION
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <memory>
+#include <random>
+#include <thread>
+#include <utility>
+
+#include <pxr/base/tf/diagnostic.h>
+#include <pxr/base/tf/envSetting.h>
+
+#include "omniMetFetchEngine.h"
+#include "omniMetHttpCache.h"
+
+PXR_NAMESPACE_OPEN_SCOPE
+
+TF_DEFINE_ENV_SETTING(OMNI_MET_MAX_RETRIES, 4,
+    "Number of times the Met provider retries a request that failed with a transient error");
+
+TF_DEFINE_ENV_SETTING(OMNI_MET_RETRY_BASE_DELAY_MS, 250,
+    "Delay before the first retry of a failed Met request, doubled for every further retry");
+
+// the response code of a successful conditional request
+static const long HTTP_NOT_MODIFIED = 304;
+static const long HTTP_TOO_MANY_REQUESTS = 429;
+
+// upper bounds on how long we back off, whatever the server asks for
+static const double MAX_RETRY_DELAY_SECONDS = 30.0;
+static const double MAX_RETRY_AFTER_SECONDS = 60.0;
+
+// connection failures, rate limiting and server errors may go away
+// if we ask again, anything else will get the same answer
+static bool _IsTransientFailure(const OmniMetHttpResponse& response)
+{
+    return response.statusCode == 0 ||
+        response.statusCode == HTTP_TOO_MANY_REQUESTS ||
+        response.statusCode >= 500;
+}
+
+// exponential backoff with jitter, so that the requests that failed
+// together don't all retry at the same moment
+static double _GetRetryDelaySeconds(size_t attempt, const OmniMetHttpResponse& response)
+{
+    static thread_local std::mt19937 generator(std::random_device{}());
+    std::uniform_real_distribution<double> jitter(0.5, 1.0);
+
+    double baseDelay = std::max(TfGetEnvSetting(OMNI_MET_RETRY_BASE_DELAY_MS), 0) / 1000.0;
+    double delay = std::min(baseDelay * std::pow(2.0, static_cast<double>(attempt)), MAX_RETRY_DELAY_SECONDS);
+    delay *= jitter(generator);
+
+    if (response.retryAfterSeconds >= 0)
+    {
+        delay = std::max(delay, std::min(static_cast<double>(response.retryAfterSeconds), MAX_RETRY_AFTER_SECONDS));
+    }
+
+    return delay;
+}
+
+OmniMetFetchEngine::OmniMetFetchEngine(OmniMetTransportPtr transport, size_t maxInFlightRequests, bool offline) :
+    _transport(transport),
+    _maxInFlightRequests(std::max<size_t>(maxInFlightRequests, 1)),
+    _offline(offline)
+{
+}
+
+OmniMetFetchEngine::~OmniMetFetchEngine()
+{
+}
+
+OmniMetRequestStatistics OmniMetFetchEngine::GetStatistics()
+{
+    return OmniMetRequestTable::GetInstance().GetStatistics();
+}
+
+void OmniMetFetchEngine::Fetch(const std::vector<std::string>& urls, const CompletionCallback& onComplete) const
+{
+    if (urls.empty())
+    {
+        return;
+    }
+
+    if (this->_offline || this->_transport == nullptr)
+    {
+        this->_FetchOffline(urls, onComplete);
+        return;
+    }
+
+    // urls someone else is already fetching are waited on rather than
+    // requested again, we only transfer the ones we claim
+    OmniMetRequestTable& requestTable = OmniMetRequestTable::GetInstance();
+    std::vector<std::string> claimedUrls;
+    std::vector<std::pair<std::string, OmniMetRequestTable::Waiter>> waiters;
+    claimedUrls.reserve(urls.size());
+    for (const std::string& url : urls)
+    {
+        OmniMetRequestTable::Waiter waiter;
+        if (requestTable.Claim(url, &waiter))
+        {
+            claimedUrls.push_back(url);
+        }
+        else
+        {
+            waiters.push_back(std::make_pair(url, waiter));
+        }
+    }
+
+    requestTable.CountCoalesced(waiters.size());
+
+    // if we have a cached response the server can tell us it is
+    // still current rather than sending the whole thing again
+    OmniMetHttpCache& httpCache = OmniMetHttpCache::GetInstance();
+    std::vector<OmniMetHttpRequest> requests(claimedUrls.size());
+    for (size_t i = 0; i < claimedUrls.size(); i++)
+    {
+        requests[i].url = claimedUrls[i];
+        httpCache.FindValidators(claimedUrls[i], &requests[i].validators);
+    }
+
+    // every claimed url is completed exactly once, here, so that
+    // fetches waiting on it see the same outcome we do
+    auto complete = [&requestTable, &onComplete](const std::string& url, const OmniMetDocumentPtr& response)
+    {
+        if (response == nullptr)
+        {
+            requestTable.CountFailed(1);
+        }
+
+        requestTable.Complete(url, response);
+        if (response != nullptr)
+        {
+            onComplete(url, response);
+        }
+    };
+
+    // responses are written to the cache once the transfers are done,
+    // the transfer loop mustn't wait on disk
+    struct _PendingStore
+    {
+        std::string url;
+        OmniMetDocumentPtr document;
+        OmniMetHttpValidators validators;
+    };
+    std::vector<_PendingStore> pendingStores;
+
+    size_t maxRetries = static_cast<size_t>(std::max(TfGetEnvSetting(OMNI_MET_MAX_RETRIES), 0));
+    for (size_t attempt = 0; !requests.empty(); attempt++)
+    {
+        std::vector<OmniMetHttpRequest> retryRequests;
+        std::vector<OmniMetHttpRequest> refetchRequests;
+        double retryDelay = 0.0;
+        requestTable.CountSent(requests.size());
+        this->_transport->Fetch(requests, this->_maxInFlightRequests,
+            [&](const OmniMetHttpRequest& request, OmniMetHttpResponse& response)
+        {
+            if (_IsTransientFailure(response) && attempt < maxRetries)
+            {
+                retryRequests.push_back(request);
+                retryDelay = std::max(retryDelay, _GetRetryDelaySeconds(attempt, response));
+            }
+            else if (response.statusCode == 0)
+            {
+                TF_WARN("Unable to load '%s': %s", request.url.c_str(), response.error.c_str());
+                complete(request.url, nullptr);
+            }
+            else if (response.statusCode == HTTP_NOT_MODIFIED)
+            {
+                std::string cachedResponse;
+                if (httpCache.Load(request.url, &cachedResponse))
+                {
+                    complete(request.url, std::make_shared<const std::string>(std::move(cachedResponse)));
+                }
+                else if (!request.validators.etag.empty() || !request.validators.lastModified.empty())
+                {
+                    // evicted since we sent its validators, ask for the whole response
+                    OmniMetHttpRequest refetchRequest;
+                    refetchRequest.url = request.url;
+                    refetchRequests.push_back(std::move(refetchRequest));
+                }
+                else
+                {
+                    TF_WARN("Unable to load '%s': not modified without a cached response", request.url.c_str());
+                    complete(request.url, nullptr);
+                }
+            }
+            else if (response.statusCode < 200 || response.statusCode >= 300)
+            {
+                TF_WARN("Unable to load '%s': HTTP status %ld", request.url.c_str(), response.statusCode);
+                complete(request.url, nullptr);
+            }
+            else
+            {
+                // the body is moved into a shared document, from here on
+                // it is shared rather than copied
+                OmniMetDocumentPtr document = std::make_shared<const std::string>(std::move(response.body));
+                if (httpCache.IsEnabled())
+                {
+                    pendingStores.push_back({ request.url, document, response.validators });
+                }
+                complete(request.url, document);
+            }
+        });
+
+        if (!retryRequests.empty())
+        {
+            requestTable.CountRetried(retryRequests.size());
+            std::this_thread::sleep_for(std::chrono::duration<double>(retryDelay));
+        }
+
+        requests = std::move(retryRequests);
+        requests.insert(requests.end(), refetchRequests.begin(), refetchRequests.end());
+    }
+
+    for (const _PendingStore& pendingStore : pendingStores)
+    {
+        httpCache.Store(pendingStore.url, *pendingStore.document, pendingStore.validators);
+    }
+
+    // everything we claimed has been completed, so waiting on the
+    // other fetches can't wait on us in turn
+    for (const std::pair<std::string, OmniMetRequestTable::Waiter>& waiter : waiters)
+    {
+        OmniMetDocumentPtr response = waiter.second.get();
+        if (response != nullptr)
+        {
+            onComplete(waiter.first, response);
+        }
+    }
+}
+
+void OmniMetFetchEngine::_FetchOffline(const std::vector<std::string>& urls, const CompletionCallback& onComplete) const
+{
+    OmniMetHttpCache& httpCache = OmniMetHttpCache::GetInstance();
+    if (!httpCache.IsEnabled())
+    {
+        TF_WARN("The Met provider is offline but has no HTTP cache, set OMNI_MET_HTTP_CACHE_DIR to enable it");
+        return;
+    }
+
+    for (const std::string& url : urls)
+    {
+        std::string response;
+        if (httpCache.Load(url, &response))
+        {
+            onComplete(url, std::make_shared<const std::string>(std::move(response)));
+        }
+        else
+        {
+            TF_WARN("No cached response for '%s' and the provider is offline", url.c_str());
+        }
+    }
+}
+
+PXR_NAMESPACE_CLOSE_SCOPE
@@ -0,0 +1,79 @@
+// Copyright 2023 NVIDIA CORPORATION
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef OMNI_OMNIMETPROVIDER_OMNIMETFETCHENGINE_H_
+#define OMNI_OMNIMETPROVIDER_OMNIMETFETCHENGINE_H_
+
+#include <functional>
+#include <string>
+#include <vector>
+
+#include <pxr/pxr.h>
+
+#include "omniMetRequestTable.h"
+#include "omniMetTransport.h"
+
+PXR_NAMESPACE_OPEN_SCOPE
+
+/// \class OmniMetFetchEngine
+///
+/// Fetches a set of URLs concurrently through an OmniMetTransport, with
+/// at most maxInFlightRequests requests in flight at any time.  Responses
+/// are handed to the completion callback as soon as they arrive, in
+/// completion order, on the thread that called Fetch.
+///
+/// Responses go through the OmniMetHttpCache: cached responses that carry
+/// validators are revalidated with a conditional request and served from
+/// the cache if the server reports them unchanged.  An offline engine
+/// serves responses from the cache only and never uses the transport.
+///
+/// A URL that another fetch in the process is already transferring isn't
+/// requested again, the fetch waits for that transfer's result instead
+/// (see OmniMetRequestTable).  Requests failing with a transient error
+/// (no response, 429 or 5xx) are retried up to OMNI_MET_MAX_RETRIES times
+/// with exponential backoff and jitter, waiting at least as long as the
+/// server asks for with Retry-After.
+///
+class OmniMetFetchEngine
+{
+public:
+
+    typedef std::function<void(const std::string& url, const OmniMetDocumentPtr& response)> CompletionCallback;
+
+    OmniMetFetchEngine(OmniMetTransportPtr transport, size_t maxInFlightRequests, bool offline);
+    ~OmniMetFetchEngine();
+
+    /// Fetches all of urls, returning once every transfer has completed
+    /// or failed.  Failed transfers are reported as warnings and are not
+    /// passed to onComplete.
+    void Fetch(const std::vector<std::string>& urls, const CompletionCallback& onComplete) const;
+
+    /// Returns the counts of requests sent, coalesced, retried
+    /// and failed by all fetch engines in the process.
+    static OmniMetRequestStatistics GetStatistics();
+
+private:
+
+    void _FetchOffline(const std::vector<std::string>& urls, const CompletionCallback& onComplete) const;
+
+private:
+
+    OmniMetTransportPtr _transport;
+    size_t _maxInFlightRequests;
+    bool _offline;
+};
+
+PXR_NAMESPACE_CLOSE_SCOPE
+
+#endif
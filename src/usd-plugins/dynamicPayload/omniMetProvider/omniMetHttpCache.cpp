@@ -0,0 +1,253 @@
+// Copyright 2023 NVIDIA CORPORATION
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+#include <limits>
+#include <utility>
+#include <vector>
+
+#include <pxr/base/arch/fileSystem.h>
+#include <pxr/base/arch/hash.h>
+#include <pxr/base/tf/atomicOfstreamWrapper.h>
+#include <pxr/base/tf/diagnostic.h>
+#include <pxr/base/tf/envSetting.h>
+#include <pxr/base/tf/fileUtils.h>
+#include <pxr/base/tf/instantiateSingleton.h>
+#include <pxr/base/tf/pathUtils.h>
+#include <pxr/base/tf/stringUtils.h>
+
+#include "omniMetHttpCache.h"
+
+PXR_NAMESPACE_OPEN_SCOPE
+
+TF_INSTANTIATE_SINGLETON(OmniMetHttpCache);
+
+TF_DEFINE_ENV_SETTING(OMNI_MET_HTTP_CACHE_DIR, "",
+    "Directory the Met provider caches HTTP responses in (responses aren't cached if empty)");
+
+// a string rather than an int so that sizes of 2 GB and more can be set
+TF_DEFINE_ENV_SETTING(OMNI_MET_HTTP_CACHE_MAX_BYTES, "1073741824",
+    "Maximum number of bytes of HTTP responses kept on disk by the Met provider (0 disables the cache)");
+
+static const std::string CACHE_FILE_EXTENSION = ".cache";
+
+// when the cache overflows we evict down to this fraction of the maximum
+// so that the directory isn't rescanned on every subsequent store
+static const double EVICTION_TARGET = 0.9;
+
+OmniMetHttpCache::OmniMetHttpCache() : _sizeKnown(false), _size(0)
+{
+    // the cache is opt-in, every response is written to disk
+    this->_directory = TfGetEnvSetting(OMNI_MET_HTTP_CACHE_DIR);
+    this->_maxSize = 0;
+    if (this->_directory.empty())
+    {
+        return;
+    }
+
+    const std::string maxSize = TfStringTrim(TfGetEnvSetting(OMNI_MET_HTTP_CACHE_MAX_BYTES));
+    bool outOfRange = false;
+    uint64_t maxSizeValue = 0;
+    if (!maxSize.empty() && maxSize.find_first_not_of("0123456789") == std::string::npos)
+    {
+        maxSizeValue = TfStringToUInt64(maxSize, &outOfRange);
+    }
+    else
+    {
+        outOfRange = true;
+    }
+
+    if (outOfRange)
+    {
+        TF_WARN("Invalid OMNI_MET_HTTP_CACHE_MAX_BYTES '%s', responses won't be cached", maxSize.c_str());
+        return;
+    }
+    this->_maxSize = static_cast<size_t>(std::min<uint64_t>(maxSizeValue, std::numeric_limits<size_t>::max()));
+
+    if (this->_maxSize > 0 && !TfIsDir(this->_directory) && !TfMakeDirs(this->_directory, -1, true))
+    {
+        TF_WARN("Unable to create HTTP cache directory '%s', responses won't be cached", this->_directory.c_str());
+        this->_maxSize = 0;
+    }
+}
+
+OmniMetHttpCache::~OmniMetHttpCache()
+{
+}
+
+bool OmniMetHttpCache::IsEnabled() const
+{
+    return this->_maxSize > 0;
+}
+
+bool OmniMetHttpCache::FindValidators(const std::string& url, OmniMetHttpValidators* validators)
+{
+    if (!this->IsEnabled())
+    {
+        return false;
+    }
+
+    return this->_ReadEntry(url, validators, nullptr);
+}
+
+bool OmniMetHttpCache::Load(const std::string& url, std::string* body)
+{
+    if (!this->IsEnabled())
+    {
+        return false;
+    }
+
+    if (!this->_ReadEntry(url, nullptr, body))
+    {
+        return false;
+    }
+
+    // the modification time doubles as the last use time for eviction
+    TfTouchFile(this->_GetEntryPath(url), false);
+
+    return true;
+}
+
+void OmniMetHttpCache::Store(const std::string& url, const std::string& body, const OmniMetHttpValidators& validators)
+{
+    if (!this->IsEnabled())
+    {
+        return;
+    }
+
+    // entries are written to a temporary file and renamed into place
+    // so readers (in this or another process) never see a partial entry
+    std::string path = this->_GetEntryPath(url);
+    int64_t previousSize = ArchGetFileLength(path.c_str());
+
+    std::string reason;
+    TfAtomicOfstreamWrapper wrapper(path);
+    if (!wrapper.Open(&reason))
+    {
+        TF_WARN("Unable to cache response for '%s': %s", url.c_str(), reason.c_str());
+        return;
+    }
+
+    std::ofstream& stream = wrapper.GetStream();
+    stream << url << '\n' << validators.etag << '\n' << validators.lastModified << '\n';
+    stream.write(body.data(), body.size());
+    if (!stream || !wrapper.Commit(&reason))
+    {
+        TF_WARN("Unable to cache response for '%s': %s", url.c_str(), reason.c_str());
+        wrapper.Cancel();
+        return;
+    }
+
+    int64_t size = ArchGetFileLength(path.c_str());
+
+    std::lock_guard<std::mutex> lock(this->_mutex);
+    if (!this->_sizeKnown)
+    {
+        this->_ComputeSize();
+    }
+    else
+    {
+        this->_size -= std::min(this->_size, static_cast<size_t>(std::max<int64_t>(previousSize, 0)));
+        this->_size += static_cast<size_t>(std::max<int64_t>(size, 0));
+    }
+
+    if (this->_size > this->_maxSize)
+    {
+        this->_EvictToSize(static_cast<size_t>(this->_maxSize * EVICTION_TARGET));
+    }
+}
+
+std::string OmniMetHttpCache::_GetEntryPath(const std::string& url) const
+{
+    return TfStringCatPaths(this->_directory,
+        TfStringPrintf("%016llx", static_cast<unsigned long long>(ArchHash64(url.data(), url.size()))) +
+        CACHE_FILE_EXTENSION);
+}
+
+bool OmniMetHttpCache::_ReadEntry(const std::string& url, OmniMetHttpValidators* validators, std::string* body) const
+{
+    std::ifstream stream(this->_GetEntryPath(url), std::ios::in | std::ios::binary);
+    if (!stream)
+    {
+        return false;
+    }
+
+    // the url is stored in the entry so a hash collision reads as a miss
+    std::string entryUrl;
+    OmniMetHttpValidators entryValidators;
+    if (!std::getline(stream, entryUrl) || entryUrl != url ||
+        !std::getline(stream, entryValidators.etag) ||
+        !std::getline(stream, entryValidators.lastModified))
+    {
+        return false;
+    }
+
+    if (validators != nullptr)
+    {
+        *validators = std::move(entryValidators);
+    }
+
+    if (body != nullptr)
+    {
+        body->assign(std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>());
+    }
+
+    return true;
+}
+
+void OmniMetHttpCache::_ComputeSize()
+{
+    this->_size = 0;
+    for (const std::string& path : TfListDir(this->_directory, false))
+    {
+        if (TfStringEndsWith(path, CACHE_FILE_EXTENSION))
+        {
+            this->_size += static_cast<size_t>(std::max<int64_t>(ArchGetFileLength(path.c_str()), 0));
+        }
+    }
+
+    this->_sizeKnown = true;
+}
+
+void OmniMetHttpCache::_EvictToSize(size_t maxSize)
+{
+    // oldest modification time first, which is the least recently used entry
+    std::vector<std::pair<double, std::string>> entries;
+    for (const std::string& path : TfListDir(this->_directory, false))
+    {
+        double modificationTime = 0.0;
+        if (TfStringEndsWith(path, CACHE_FILE_EXTENSION) && ArchGetModificationTime(path.c_str(), &modificationTime))
+        {
+            entries.push_back(std::make_pair(modificationTime, path));
+        }
+    }
+
+    std::sort(entries.begin(), entries.end());
+
+    // recompute the size while we're at it, other processes
+    // sharing the directory may have added or removed entries
+    this->_ComputeSize();
+    for (auto it = entries.begin(); it != entries.end() && this->_size > maxSize; it++)
+    {
+        int64_t size = ArchGetFileLength(it->second.c_str());
+        if (TfDeleteFile(it->second))
+        {
+            this->_size -= std::min(this->_size, static_cast<size_t>(std::max<int64_t>(size, 0)));
+        }
+    }
+}
+
+PXR_NAMESPACE_CLOSE_SCOPE
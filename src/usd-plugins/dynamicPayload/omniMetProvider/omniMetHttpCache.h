@@ -0,0 +1,93 @@
+// Copyright 2023 NVIDIA CORPORATION
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef OMNI_OMNIMETPROVIDER_OMNIMETHTTPCACHE_H_
+#define OMNI_OMNIMETPROVIDER_OMNIMETHTTPCACHE_H_
+
+#include <mutex>
+#include <string>
+
+#include <pxr/pxr.h>
+#include <pxr/base/tf/singleton.h>
+
+#include "omniMetTransport.h"
+
+PXR_NAMESPACE_OPEN_SCOPE
+
+/// \class OmniMetHttpCache
+///
+/// On-disk cache of responses from the Met collection API, shared by all
+/// providers (and processes) using the same cache directory.  Each response
+/// is stored in its own file named after a hash of its URL, together with
+/// the ETag / Last-Modified validators the server sent, so that it can be
+/// revalidated with a conditional request rather than downloaded again.
+///
+/// The cache is only enabled when the OMNI_MET_HTTP_CACHE_DIR environment
+/// setting names its directory.  The least recently used responses are
+/// evicted once the files exceed OMNI_MET_HTTP_CACHE_MAX_BYTES (1 GB by
+/// default, 0 disables the cache).
+///
+class OmniMetHttpCache
+{
+public:
+    static OmniMetHttpCache& GetInstance()
+    {
+        return TfSingleton<OmniMetHttpCache>::GetInstance();
+    }
+
+    // prevent copying and assignment
+    OmniMetHttpCache(const OmniMetHttpCache&) = delete;
+    OmniMetHttpCache& operator=(const OmniMetHttpCache&) = delete;
+
+    bool IsEnabled() const;
+
+    /// Returns true and fills validators if a response for url is cached.
+    /// Only the head of the file is read.
+    bool FindValidators(const std::string& url, OmniMetHttpValidators* validators);
+
+    /// Returns true and fills body if a response for url is cached,
+    /// marking it as recently used.
+    bool Load(const std::string& url, std::string* body);
+
+    /// Stores body and its validators as the response for url,
+    /// evicting the least recently used responses as needed.
+    void Store(const std::string& url, const std::string& body, const OmniMetHttpValidators& validators);
+
+private:
+
+    OmniMetHttpCache();
+    ~OmniMetHttpCache();
+
+    std::string _GetEntryPath(const std::string& url) const;
+    bool _ReadEntry(const std::string& url, OmniMetHttpValidators* validators, std::string* body) const;
+    void _ComputeSize();
+    void _EvictToSize(size_t maxSize);
+
+    friend class TfSingleton<OmniMetHttpCache>;
+
+private:
+
+    std::mutex _mutex;
+    std::string _directory;
+    size_t _maxSize;
+
+    // bytes in the cache directory, computed on first store since
+    // other processes may share the directory
+    bool _sizeKnown;
+    size_t _size;
+};
+
+PXR_NAMESPACE_CLOSE_SCOPE
+
+#endif
@@ -0,0 +1,482 @@
+// Copyright 2023 NVIDIA CORPORATION
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <limits>
+
+#include "omniMetJsonReader.h"
+
+PXR_NAMESPACE_OPEN_SCOPE
+
+static int _HexDigit(char c)
+{
+    if (c >= '0' && c <= '9')
+    {
+        return c - '0';
+    }
+    if (c >= 'a' && c <= 'f')
+    {
+        return c - 'a' + 10;
+    }
+    if (c >= 'A' && c <= 'F')
+    {
+        return c - 'A' + 10;
+    }
+
+    return -1;
+}
+
+static bool _ReadHex4(const char* data, const char* end, uint32_t* value)
+{
+    if (end - data < 4)
+    {
+        return false;
+    }
+
+    *value = 0;
+    for (int i = 0; i < 4; i++)
+    {
+        int digit = _HexDigit(data[i]);
+        if (digit < 0)
+        {
+            return false;
+        }
+
+        *value = (*value << 4) | static_cast<uint32_t>(digit);
+    }
+
+    return true;
+}
+
+static void _AppendUtf8(uint32_t codePoint, std::string* result)
+{
+    if (codePoint < 0x80)
+    {
+        result->push_back(static_cast<char>(codePoint));
+    }
+    else if (codePoint < 0x800)
+    {
+        result->push_back(static_cast<char>(0xC0 | (codePoint >> 6)));
+        result->push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+    }
+    else if (codePoint < 0x10000)
+    {
+        result->push_back(static_cast<char>(0xE0 | (codePoint >> 12)));
+        result->push_back(static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F)));
+        result->push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+    }
+    else
+    {
+        result->push_back(static_cast<char>(0xF0 | (codePoint >> 18)));
+        result->push_back(static_cast<char>(0x80 | ((codePoint >> 12) & 0x3F)));
+        result->push_back(static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F)));
+        result->push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+    }
+}
+
+std::string OmniMetJsonString::GetString() const
+{
+    if (!this->hasEscapes)
+    {
+        return std::string(this->data, this->size);
+    }
+
+    std::string result;
+    result.reserve(this->size);
+    const char* end = this->data + this->size;
+    for (const char* c = this->data; c < end; c++)
+    {
+        if (*c != '\\' || c + 1 >= end)
+        {
+            result.push_back(*c);
+            continue;
+        }
+
+        c++;
+        switch (*c)
+        {
+            case 'b': result.push_back('\b'); break;
+            case 'f': result.push_back('\f'); break;
+            case 'n': result.push_back('\n'); break;
+            case 'r': result.push_back('\r'); break;
+            case 't': result.push_back('\t'); break;
+            case 'u':
+            {
+                uint32_t codePoint = 0;
+                if (!_ReadHex4(c + 1, end, &codePoint))
+                {
+                    result.push_back('u');
+                    break;
+                }
+                c += 4;
+
+                // combine surrogate pairs into a single code point
+                uint32_t lowSurrogate = 0;
+                if (codePoint >= 0xD800 && codePoint < 0xDC00 && end - c > 2 && c[1] == '\\' && c[2] == 'u' &&
+                    _ReadHex4(c + 3, end, &lowSurrogate) && lowSurrogate >= 0xDC00 && lowSurrogate < 0xE000)
+                {
+                    codePoint = 0x10000 + ((codePoint - 0xD800) << 10) + (lowSurrogate - 0xDC00);
+                    c += 6;
+                }
+
+                _AppendUtf8(codePoint, &result);
+                break;
+            }
+            default:
+                // covers \" \\ and \/
+                result.push_back(*c);
+                break;
+        }
+    }
+
+    return result;
+}
+
+bool OmniMetJsonValue::GetBool(bool defaultValue) const
+{
+    return this->type == Type::Bool ? this->boolValue : defaultValue;
+}
+
+// whether number truncates to a value an int can hold, converting
+// anything else (including infinities and NaN) to int is undefined
+static bool _IsIntNumber(double number)
+{
+    double truncated = std::trunc(number);
+    return std::isfinite(truncated) &&
+        truncated >= static_cast<double>(std::numeric_limits<int>::min()) &&
+        truncated <= static_cast<double>(std::numeric_limits<int>::max());
+}
+
+int OmniMetJsonValue::GetInt(int defaultValue) const
+{
+    return this->type == Type::Number && _IsIntNumber(this->numberValue) ?
+        static_cast<int>(this->numberValue) : defaultValue;
+}
+
+std::string OmniMetJsonValue::GetString(const std::string& defaultValue) const
+{
+    return this->type == Type::String ? this->stringValue.GetString() : defaultValue;
+}
+
+OmniMetJsonReader::OmniMetJsonReader(const char* data, size_t size) :
+    _current(data),
+    _end(data + size),
+    _failed(data == nullptr)
+{
+}
+
+OmniMetJsonReader::OmniMetJsonReader(const std::string& json) : OmniMetJsonReader(json.data(), json.size())
+{
+}
+
+OmniMetJsonValue::Type OmniMetJsonReader::PeekType()
+{
+    this->_SkipWhitespace();
+    if (this->_failed || this->_current >= this->_end)
+    {
+        return OmniMetJsonValue::Type::Missing;
+    }
+
+    switch (*this->_current)
+    {
+        case '{': return OmniMetJsonValue::Type::Object;
+        case '[': return OmniMetJsonValue::Type::Array;
+        case '"': return OmniMetJsonValue::Type::String;
+        case 't':
+        case 'f': return OmniMetJsonValue::Type::Bool;
+        case 'n': return OmniMetJsonValue::Type::Null;
+        default: return OmniMetJsonValue::Type::Number;
+    }
+}
+
+bool OmniMetJsonReader::ReadInt(int* value)
+{
+    this->_SkipWhitespace();
+    if (this->_failed || this->_current >= this->_end)
+    {
+        return this->_Fail();
+    }
+
+    // fast path for plain integers, which is what object ids are
+    const char* c = this->_current;
+    bool negative = false;
+    if (*c == '-')
+    {
+        negative = true;
+        c++;
+    }
+
+    int64_t result = 0;
+    const char* digitsStart = c;
+    while (c < this->_end && *c >= '0' && *c <= '9' && c - digitsStart < 18)
+    {
+        result = result * 10 + (*c - '0');
+        c++;
+    }
+
+    if (c > digitsStart && (c >= this->_end || (*c != '.' && *c != 'e' && *c != 'E' && (*c < '0' || *c > '9'))))
+    {
+        this->_current = c;
+        result = negative ? -result : result;
+        if (result < std::numeric_limits<int>::min() || result > std::numeric_limits<int>::max())
+        {
+            return false;
+        }
+
+        *value = static_cast<int>(result);
+        return true;
+    }
+
+    double number = 0.0;
+    if (!this->_ReadNumberToken(&number) || !_IsIntNumber(number))
+    {
+        return false;
+    }
+
+    *value = static_cast<int>(number);
+    return true;
+}
+
+bool OmniMetJsonReader::ReadString(OmniMetJsonString* value)
+{
+    this->_SkipWhitespace();
+    return this->_ReadStringToken(value);
+}
+
+bool OmniMetJsonReader::ReadValue(OmniMetJsonValue* value)
+{
+    value->type = this->PeekType();
+    switch (value->type)
+    {
+        case OmniMetJsonValue::Type::String:
+            return this->_ReadStringToken(&value->stringValue);
+        case OmniMetJsonValue::Type::Number:
+            return this->_ReadNumberToken(&value->numberValue);
+        case OmniMetJsonValue::Type::Bool:
+            value->boolValue = (*this->_current == 't');
+            return value->boolValue ? this->_ReadLiteral("true", 4) : this->_ReadLiteral("false", 5);
+        case OmniMetJsonValue::Type::Null:
+            return this->_ReadLiteral("null", 4);
+        case OmniMetJsonValue::Type::Array:
+        case OmniMetJsonValue::Type::Object:
+            return this->Skip();
+        default:
+            return this->_Fail();
+    }
+}
+
+bool OmniMetJsonReader::ReadMembers(const char* const* keys, const size_t* keyLengths, size_t keyCount,
+    OmniMetJsonValue* values)
+{
+    for (size_t i = 0; i < keyCount; i++)
+    {
+        values[i] = OmniMetJsonValue();
+    }
+
+    return this->ReadObject([this, keys, keyLengths, keyCount, values](const OmniMetJsonString& key)
+    {
+        for (size_t i = 0; i < keyCount; i++)
+        {
+            if (key.Equals(keys[i], keyLengths[i]))
+            {
+                this->ReadValue(&values[i]);
+                return;
+            }
+        }
+    });
+}
+
+bool OmniMetJsonReader::Skip()
+{
+    // skips one complete value, containers are skipped by tracking
+    // their depth rather than recursing into them
+    size_t depth = 0;
+    do
+    {
+        this->_SkipWhitespace();
+        if (this->_failed || this->_current >= this->_end)
+        {
+            return this->_Fail();
+        }
+
+        char c = *this->_current;
+        if (c == '{' || c == '[')
+        {
+            depth++;
+            this->_current++;
+        }
+        else if (c == '}' || c == ']')
+        {
+            if (depth == 0)
+            {
+                return this->_Fail();
+            }
+
+            depth--;
+            this->_current++;
+        }
+        else if (c == ',' || c == ':')
+        {
+            if (depth == 0)
+            {
+                return this->_Fail();
+            }
+
+            this->_current++;
+        }
+        else
+        {
+            OmniMetJsonValue value;
+            if (!this->ReadValue(&value))
+            {
+                return false;
+            }
+        }
+    } while (depth > 0);
+
+    return true;
+}
+
+void OmniMetJsonReader::_SkipWhitespace()
+{
+    while (this->_current < this->_end &&
+        (*this->_current == ' ' || *this->_current == '\n' || *this->_current == '\r' || *this->_current == '\t'))
+    {
+        this->_current++;
+    }
+}
+
+bool OmniMetJsonReader::_Expect(char c)
+{
+    this->_SkipWhitespace();
+    if (this->_failed || this->_current >= this->_end || *this->_current != c)
+    {
+        return false;
+    }
+
+    this->_current++;
+    return true;
+}
+
+bool OmniMetJsonReader::_Fail()
+{
+    this->_failed = true;
+    return false;
+}
+
+bool OmniMetJsonReader::_ReadStringToken(OmniMetJsonString* value)
+{
+    if (this->_failed || this->_current >= this->_end || *this->_current != '"')
+    {
+        return this->_Fail();
+    }
+
+    const char* start = ++this->_current;
+    bool hasEscapes = false;
+    while (this->_current < this->_end && *this->_current != '"')
+    {
+        if (*this->_current == '\\')
+        {
+            hasEscapes = true;
+            this->_current++;
+        }
+
+        this->_current++;
+    }
+
+    if (this->_current >= this->_end)
+    {
+        return this->_Fail();
+    }
+
+    value->data = start;
+    value->size = static_cast<size_t>(this->_current - start);
+    value->hasEscapes = hasEscapes;
+    this->_current++;
+
+    return true;
+}
+
+bool OmniMetJsonReader::_ReadNumberToken(double* value)
+{
+    if (this->_failed)
+    {
+        return false;
+    }
+
+    // strtod needs a terminated string and the buffer may not be,
+    // numbers are short so copying the token is cheap
+    const char* start = this->_current;
+    while (this->_current < this->_end && (*this->_current == '-' || *this->_current == '+' || *this->_current == '.' ||
+        *this->_current == 'e' || *this->_current == 'E' || (*this->_current >= '0' && *this->_current <= '9')))
+    {
+        this->_current++;
+    }
+
+    if (this->_current == start)
+    {
+        return this->_Fail();
+    }
+
+    std::string token(start, this->_current);
+    char* tokenEnd = nullptr;
+    *value = std::strtod(token.c_str(), &tokenEnd);
+    if (tokenEnd != token.c_str() + token.size() || !std::isfinite(*value))
+    {
+        return this->_Fail();
+    }
+
+    return true;
+}
+
+bool OmniMetJsonReader::_ReadLiteral(const char* literal, size_t length)
+{
+    if (this->_failed || static_cast<size_t>(this->_end - this->_current) < length ||
+        std::memcmp(this->_current, literal, length) != 0)
+    {
+        return this->_Fail();
+    }
+
+    this->_current += length;
+    return true;
+}
+
+bool OmniMetJsonReader::_ReadSeparator(char closing, bool* hasMore)
+{
+    this->_SkipWhitespace();
+    if (this->_failed || this->_current >= this->_end)
+    {
+        return this->_Fail();
+    }
+
+    if (*this->_current == ',')
+    {
+        this->_current++;
+        *hasMore = true;
+        return true;
+    }
+
+    if (*this->_current == closing)
+    {
+        this->_current++;
+        *hasMore = false;
+        return true;
+    }
+
+    return this->_Fail();
+}
+
+PXR_NAMESPACE_CLOSE_SCOPE
@@ -0,0 +1,236 @@
+// Copyright 2023 NVIDIA CORPORATION
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef OMNI_OMNIMETPROVIDER_OMNIMETJSONREADER_H_
+#define OMNI_OMNIMETPROVIDER_OMNIMETJSONREADER_H_
+
+#include <cstring>
+#include <string>
+
+#include <pxr/pxr.h>
+
+PXR_NAMESPACE_OPEN_SCOPE
+
+/// \struct OmniMetJsonString
+///
+/// A string value read from a JSON document.  It points into the buffer
+/// the document was read from, so it is only valid for as long as that
+/// buffer is; escape sequences are only decoded by GetString.
+///
+struct OmniMetJsonString
+{
+    const char* data = nullptr;
+    size_t size = 0;
+    bool hasEscapes = false;
+
+    /// Returns the decoded string.
+    std::string GetString() const;
+
+    /// Compares the raw (undecoded) characters against value, which is
+    /// what we want for keys since none of the keys we look for need escaping.
+    bool Equals(const char* value, size_t length) const
+    {
+        return this->size == length && std::memcmp(this->data, value, length) == 0;
+    }
+};
+
+/// \struct OmniMetJsonValue
+///
+/// A scalar value read from a JSON document.  Arrays and objects are
+/// only reported by type, their content is skipped.
+///
+struct OmniMetJsonValue
+{
+    enum class Type
+    {
+        Missing,
+        Null,
+        Bool,
+        Number,
+        String,
+        Array,
+        Object
+    };
+
+    Type type = Type::Missing;
+    bool boolValue = false;
+    double numberValue = 0.0;
+    OmniMetJsonString stringValue;
+
+    bool IsPresent() const
+    {
+        return this->type != Type::Missing;
+    }
+
+    /// Returns the value as the given type, or defaultValue if it holds
+    /// something else.  GetInt truncates numbers and returns defaultValue
+    /// for those out of the range of int.
+    bool GetBool(bool defaultValue = false) const;
+    int GetInt(int defaultValue = 0) const;
+    std::string GetString(const std::string& defaultValue = std::string()) const;
+};
+
+/// \class OmniMetJsonReader
+///
+/// A forward-only pull parser over a JSON document held in memory.
+/// Unlike JsParseString it never builds a DOM: the caller walks the
+/// document with ReadObject / ReadArray and reads the values it is
+/// interested in straight from the buffer, everything else is skipped
+/// without allocating.  Each byte of the document is visited once.
+///
+/// Errors put the reader into a failed state in which all reads fail,
+/// so callers only need to check IsValid once they are done.
+///
+class OmniMetJsonReader
+{
+public:
+
+    OmniMetJsonReader(const char* data, size_t size);
+    OmniMetJsonReader(const std::string& json);
+
+    bool IsValid() const
+    {
+        return !this->_failed;
+    }
+
+    /// Returns the type of the next value without consuming it.
+    OmniMetJsonValue::Type PeekType();
+
+    /// Reads an object, calling onMember(const OmniMetJsonString& key)
+    /// for each member.  onMember may read the member's value with any
+    /// of the Read methods, if it doesn't the value is skipped.
+    template <typename MemberFn>
+    bool ReadObject(MemberFn&& onMember);
+
+    /// Reads an array, calling onElement() for each element.  onElement
+    /// may read the element, if it doesn't the element is skipped.
+    template <typename ElementFn>
+    bool ReadArray(ElementFn&& onElement);
+
+    /// Reads a number, truncated to an int.  A number out of the range
+    /// of int is consumed and false returned, without failing the reader.
+    bool ReadInt(int* value);
+    bool ReadString(OmniMetJsonString* value);
+
+    /// Reads any value, scalars are returned in full,
+    /// arrays and objects are skipped and only typed.
+    bool ReadValue(OmniMetJsonValue* value);
+
+    /// Reads the given keys of an object in a single pass.  values must
+    /// hold keyCount entries, keys that are not in the object are
+    /// reported as Missing.
+    bool ReadMembers(const char* const* keys, const size_t* keyLengths, size_t keyCount, OmniMetJsonValue* values);
+
+    bool Skip();
+
+private:
+
+    void _SkipWhitespace();
+    bool _Expect(char c);
+    bool _Fail();
+    bool _ReadStringToken(OmniMetJsonString* value);
+    bool _ReadNumberToken(double* value);
+    bool _ReadLiteral(const char* literal, size_t length);
+
+    // reads the separator after a member / element, returning
+    // true if another member / element follows
+    bool _ReadSeparator(char closing, bool* hasMore);
+
+private:
+
+    const char* _current;
+    const char* _end;
+    bool _failed;
+};
+
+template <typename MemberFn>
+bool OmniMetJsonReader::ReadObject(MemberFn&& onMember)
+{
+    if (!this->_Expect('{'))
+    {
+        return this->_Fail();
+    }
+
+    this->_SkipWhitespace();
+    if (this->_current < this->_end && *this->_current == '}')
+    {
+        this->_current++;
+        return true;
+    }
+
+    bool hasMore = true;
+    while (hasMore && !this->_failed)
+    {
+        OmniMetJsonString key;
+        this->_SkipWhitespace();
+        if (!this->_ReadStringToken(&key) || !this->_Expect(':'))
+        {
+            return this->_Fail();
+        }
+
+        this->_SkipWhitespace();
+        const char* valueStart = this->_current;
+        onMember(static_cast<const OmniMetJsonString&>(key));
+        if (this->_current == valueStart)
+        {
+            this->Skip();
+        }
+
+        if (!this->_ReadSeparator('}', &hasMore))
+        {
+            return false;
+        }
+    }
+
+    return !this->_failed;
+}
+
+template <typename ElementFn>
+bool OmniMetJsonReader::ReadArray(ElementFn&& onElement)
+{
+    if (!this->_Expect('['))
+    {
+        return this->_Fail();
+    }
+
+    this->_SkipWhitespace();
+    if (this->_current < this->_end && *this->_current == ']')
+    {
+        this->_current++;
+        return true;
+    }
+
+    bool hasMore = true;
+    while (hasMore && !this->_failed)
+    {
+        this->_SkipWhitespace();
+        const char* elementStart = this->_current;
+        onElement();
+        if (this->_current == elementStart)
+        {
+            this->Skip();
+        }
+
+        if (!this->_ReadSeparator(']', &hasMore))
+        {
+            return false;
+        }
+    }
+
+    return !this->_failed;
+}
+
+PXR_NAMESPACE_CLOSE_SCOPE
+
+#endif
@@ -0,0 +1,140 @@
+// Copyright 2023 NVIDIA CORPORATION
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef OMNI_OMNIMETPROVIDER_OMNIMETOBJECTFIELDS_H_
+#define OMNI_OMNIMETPROVIDER_OMNIMETOBJECTFIELDS_H_
+
+#include <cstddef>
+
+#include <pxr/pxr.h>
+
+PXR_NAMESPACE_OPEN_SCOPE
+
+/// The value type of the attribute a field is authored as.
+enum class OmniMetFieldType
+{
+    String,
+    Int,
+    Bool
+};
+
+/// Whether a field is authored when an object document lacks it.
+enum class OmniMetFieldPresence
+{
+    // always authored, with the type's default value if missing
+    Required,
+
+    // only authored if the document has it
+    Optional,
+
+    // read from the document but not authored as an attribute
+    Unauthored
+};
+
+/// \struct OmniMetFieldDescriptor
+///
+/// Describes how one member of a Met object document maps onto an
+/// attribute of the AmaObject prim created for it.  The attribute
+/// is named namespacePrefix + jsonKey.
+///
+struct OmniMetFieldDescriptor
+{
+    const char* jsonKey;
+    size_t jsonKeyLength;
+    const char* namespacePrefix;
+    OmniMetFieldType type;
+    OmniMetFieldPresence presence;
+};
+
+template <size_t N>
+constexpr OmniMetFieldDescriptor OmniMetMakeField(const char (&jsonKey)[N], const char* namespacePrefix,
+    OmniMetFieldType type, OmniMetFieldPresence presence)
+{
+    return OmniMetFieldDescriptor{ jsonKey, N - 1, namespacePrefix, type, presence };
+}
+
+constexpr const char OMNI_MET_NO_PREFIX[] = "";
+constexpr const char OMNI_MET_ARTIST_PREFIX[] = "omni:met:artist:";
+
+/// The fields of an object document that _ParseObject reads, in the
+/// order the Met API sends them so that the lookup of the next member
+/// usually succeeds on its first comparison.  Members that aren't in
+/// the table are skipped, to author another field of the document
+/// add its row here (and its attribute to the schema).
+constexpr OmniMetFieldDescriptor OMNI_MET_OBJECT_FIELDS[] = {
+    OmniMetMakeField("objectID", OMNI_MET_NO_PREFIX, OmniMetFieldType::Int, OmniMetFieldPresence::Required),
+    OmniMetMakeField("isHighlight", OMNI_MET_NO_PREFIX, OmniMetFieldType::Bool, OmniMetFieldPresence::Required),
+    OmniMetMakeField("accessionNumber", OMNI_MET_NO_PREFIX, OmniMetFieldType::String, OmniMetFieldPresence::Required),
+    OmniMetMakeField("accessionYear", OMNI_MET_NO_PREFIX, OmniMetFieldType::String, OmniMetFieldPresence::Required),
+    OmniMetMakeField("isPublicDomain", OMNI_MET_NO_PREFIX, OmniMetFieldType::Bool, OmniMetFieldPresence::Required),
+    OmniMetMakeField("primaryImage", OMNI_MET_NO_PREFIX, OmniMetFieldType::String, OmniMetFieldPresence::Required),
+    OmniMetMakeField("primaryImageSmall", OMNI_MET_NO_PREFIX, OmniMetFieldType::String, OmniMetFieldPresence::Required),
+    OmniMetMakeField("department", OMNI_MET_NO_PREFIX, OmniMetFieldType::String, OmniMetFieldPresence::Required),
+    OmniMetMakeField("objectName", OMNI_MET_NO_PREFIX, OmniMetFieldType::String, OmniMetFieldPresence::Unauthored),
+    OmniMetMakeField("title", OMNI_MET_NO_PREFIX, OmniMetFieldType::String, OmniMetFieldPresence::Required),
+    OmniMetMakeField("culture", OMNI_MET_NO_PREFIX, OmniMetFieldType::String, OmniMetFieldPresence::Required),
+    OmniMetMakeField("period", OMNI_MET_NO_PREFIX, OmniMetFieldType::String, OmniMetFieldPresence::Required),
+    OmniMetMakeField("dynasty", OMNI_MET_NO_PREFIX, OmniMetFieldType::String, OmniMetFieldPresence::Required),
+    OmniMetMakeField("reign", OMNI_MET_NO_PREFIX, OmniMetFieldType::String, OmniMetFieldPresence::Required),
+    OmniMetMakeField("portfolio", OMNI_MET_NO_PREFIX, OmniMetFieldType::String, OmniMetFieldPresence::Required),
+    OmniMetMakeField("artistRole", OMNI_MET_ARTIST_PREFIX, OmniMetFieldType::String, OmniMetFieldPresence::Optional),
+    OmniMetMakeField("artistPrefix", OMNI_MET_ARTIST_PREFIX, OmniMetFieldType::String, OmniMetFieldPresence::Optional),
+    OmniMetMakeField("artistDisplayName", OMNI_MET_ARTIST_PREFIX, OmniMetFieldType::String, OmniMetFieldPresence::Optional),
+    OmniMetMakeField("artistDisplayBio", OMNI_MET_ARTIST_PREFIX, OmniMetFieldType::String, OmniMetFieldPresence::Optional),
+    OmniMetMakeField("artistSuffix", OMNI_MET_ARTIST_PREFIX, OmniMetFieldType::String, OmniMetFieldPresence::Optional),
+    OmniMetMakeField("artistAlphaSort", OMNI_MET_ARTIST_PREFIX, OmniMetFieldType::String, OmniMetFieldPresence::Optional),
+    OmniMetMakeField("artistNationality", OMNI_MET_ARTIST_PREFIX, OmniMetFieldType::String, OmniMetFieldPresence::Optional),
+    OmniMetMakeField("artistGender", OMNI_MET_ARTIST_PREFIX, OmniMetFieldType::String, OmniMetFieldPresence::Optional),
+    OmniMetMakeField("artistWikidata_URL", OMNI_MET_ARTIST_PREFIX, OmniMetFieldType::String, OmniMetFieldPresence::Optional),
+    OmniMetMakeField("artistULAN_URL", OMNI_MET_ARTIST_PREFIX, OmniMetFieldType::String, OmniMetFieldPresence::Optional)
+};
+
+constexpr size_t OMNI_MET_OBJECT_FIELD_COUNT = sizeof(OMNI_MET_OBJECT_FIELDS) / sizeof(OMNI_MET_OBJECT_FIELDS[0]);
+
+constexpr bool OmniMetFieldKeyEquals(const char* left, const char* right)
+{
+    while (*left != '\0' && *left == *right)
+    {
+        left++;
+        right++;
+    }
+
+    return *left == *right;
+}
+
+/// Returns the index of the field with the given key,
+/// or OMNI_MET_OBJECT_FIELD_COUNT if there isn't one.
+constexpr size_t OmniMetFindObjectField(const char* jsonKey)
+{
+    for (size_t i = 0; i < OMNI_MET_OBJECT_FIELD_COUNT; i++)
+    {
+        if (OmniMetFieldKeyEquals(OMNI_MET_OBJECT_FIELDS[i].jsonKey, jsonKey))
+        {
+            return i;
+        }
+    }
+
+    return OMNI_MET_OBJECT_FIELD_COUNT;
+}
+
+// the fields the prim name is made from
+constexpr size_t OMNI_MET_OBJECT_ID_FIELD = OmniMetFindObjectField("objectID");
+constexpr size_t OMNI_MET_OBJECT_NAME_FIELD = OmniMetFindObjectField("objectName");
+
+static_assert(OMNI_MET_OBJECT_ID_FIELD < OMNI_MET_OBJECT_FIELD_COUNT, "objectID must be in the field table");
+static_assert(OMNI_MET_OBJECT_NAME_FIELD < OMNI_MET_OBJECT_FIELD_COUNT, "objectName must be in the field table");
+
+PXR_NAMESPACE_CLOSE_SCOPE
+
+#endif
@@ -0,0 +1,151 @@
+// Copyright 2023 NVIDIA CORPORATION
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <pxr/base/tf/envSetting.h>
+#include <pxr/base/tf/instantiateSingleton.h>
+
+#include "omniMetObjectStore.h"
+
+PXR_NAMESPACE_OPEN_SCOPE
+
+TF_INSTANTIATE_SINGLETON(OmniMetObjectStore);
+
+TF_DEFINE_ENV_SETTING(OMNI_MET_OBJECT_STORE_MAX_BYTES, 256 * 1024 * 1024,
+    "Maximum number of bytes of object documents the Met provider keeps in memory (0 disables the store)");
+
+OmniMetObjectStore::OmniMetObjectStore() : _size(0)
+{
+    int maxSize = TfGetEnvSetting(OMNI_MET_OBJECT_STORE_MAX_BYTES);
+    this->_maxSize = maxSize < 0 ? 0 : static_cast<size_t>(maxSize);
+}
+
+OmniMetObjectStore::~OmniMetObjectStore()
+{
+}
+
+bool OmniMetObjectStore::IsEnabled() const
+{
+    return this->_maxSize > 0;
+}
+
+OmniMetDocumentPtr OmniMetObjectStore::FindDepartments(const std::string& baseUrl)
+{
+    std::lock_guard<std::mutex> lock(this->_mutex);
+    auto it = this->_collections.find(baseUrl);
+    return it != this->_collections.end() ? it->second.departments : OmniMetDocumentPtr();
+}
+
+void OmniMetObjectStore::StoreDepartments(const std::string& baseUrl, const std::string& document)
+{
+    if (!this->IsEnabled())
+    {
+        return;
+    }
+
+    OmniMetDocumentPtr storedDocument = std::make_shared<const std::string>(document);
+    std::lock_guard<std::mutex> lock(this->_mutex);
+    this->_collections[baseUrl].departments = storedDocument;
+}
+
+OmniMetObjectIdsPtr OmniMetObjectStore::FindObjectIds(const std::string& baseUrl, const std::string& query)
+{
+    std::lock_guard<std::mutex> lock(this->_mutex);
+    auto it = this->_collections.find(baseUrl);
+    if (it == this->_collections.end())
+    {
+        return OmniMetObjectIdsPtr();
+    }
+
+    auto objectIdsIt = it->second.objectIds.find(query);
+    return objectIdsIt != it->second.objectIds.end() ? objectIdsIt->second : OmniMetObjectIdsPtr();
+}
+
+void OmniMetObjectStore::StoreObjectIds(const std::string& baseUrl, const std::string& query,
+    OmniMetObjectIdsPtr objectIds)
+{
+    if (!this->IsEnabled())
+    {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(this->_mutex);
+    this->_collections[baseUrl].objectIds[query] = objectIds;
+}
+
+OmniMetDocumentPtr OmniMetObjectStore::FindObject(const std::string& baseUrl, int objectId)
+{
+    std::lock_guard<std::mutex> lock(this->_mutex);
+    auto it = this->_collections.find(baseUrl);
+    if (it == this->_collections.end())
+    {
+        return OmniMetDocumentPtr();
+    }
+
+    auto objectIt = it->second.objects.find(objectId);
+    if (objectIt == it->second.objects.end())
+    {
+        return OmniMetDocumentPtr();
+    }
+
+    this->_objectLru.splice(this->_objectLru.begin(), this->_objectLru, objectIt->second.lruPosition);
+    return objectIt->second.document;
+}
+
+void OmniMetObjectStore::StoreObject(const std::string& baseUrl, int objectId, OmniMetDocumentPtr document)
+{
+    if (!this->IsEnabled() || document == nullptr || document->size() > this->_maxSize)
+    {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(this->_mutex);
+    _Collection& collection = this->_collections[baseUrl];
+    auto result = collection.objects.emplace(objectId, _ObjectEntry());
+    _ObjectEntry& entry = result.first->second;
+    if (result.second)
+    {
+        this->_objectLru.push_front(std::make_pair(baseUrl, objectId));
+    }
+    else
+    {
+        // another provider fetched it at the same time, keep the latest
+        this->_size -= entry.document->size();
+        this->_objectLru.erase(entry.lruPosition);
+        this->_objectLru.push_front(std::make_pair(baseUrl, objectId));
+    }
+
+    entry.document = document;
+    entry.lruPosition = this->_objectLru.begin();
+    this->_size += document->size();
+
+    if (this->_size > this->_maxSize)
+    {
+        this->_EvictToSize(this->_maxSize);
+    }
+}
+
+void OmniMetObjectStore::_EvictToSize(size_t maxSize)
+{
+    while (this->_size > maxSize && !this->_objectLru.empty())
+    {
+        const _ObjectKey& key = this->_objectLru.back();
+        _Collection& collection = this->_collections[key.first];
+        auto it = collection.objects.find(key.second);
+        this->_size -= it->second.document->size();
+        collection.objects.erase(it);
+        this->_objectLru.pop_back();
+    }
+}
+
+PXR_NAMESPACE_CLOSE_SCOPE
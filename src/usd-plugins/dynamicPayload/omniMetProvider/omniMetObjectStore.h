@@ -0,0 +1,116 @@
+// Copyright 2023 NVIDIA CORPORATION
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef OMNI_OMNIMETPROVIDER_OMNIMETOBJECTSTORE_H_
+#define OMNI_OMNIMETPROVIDER_OMNIMETOBJECTSTORE_H_
+
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <pxr/pxr.h>
+#include <pxr/base/tf/singleton.h>
+
+#include "omniMetTransport.h"
+
+PXR_NAMESPACE_OPEN_SCOPE
+
+typedef std::shared_ptr<const std::vector<int>> OmniMetObjectIdsPtr;
+
+/// \class OmniMetObjectStore
+///
+/// In-memory store of the documents fetched from the Met collection API,
+/// shared by all providers in the process.  Changing the LOD parameters of
+/// a layer creates a new layer and provider, which would otherwise fetch
+/// every object again; with the store it only fetches the objects the
+/// previous layers didn't have.
+///
+/// Documents are kept per base URL, so providers pointed at different
+/// servers don't see each other's data.  Within the process documents are
+/// treated as current for as long as they are stored.  Object documents
+/// are evicted least recently used first once they exceed
+/// OMNI_MET_OBJECT_STORE_MAX_BYTES (0 disables the store).
+///
+class OmniMetObjectStore
+{
+public:
+    static OmniMetObjectStore& GetInstance()
+    {
+        return TfSingleton<OmniMetObjectStore>::GetInstance();
+    }
+
+    // prevent copying and assignment
+    OmniMetObjectStore(const OmniMetObjectStore&) = delete;
+    OmniMetObjectStore& operator=(const OmniMetObjectStore&) = delete;
+
+    bool IsEnabled() const;
+
+    /// Returns the departments document, or null if it isn't stored.
+    OmniMetDocumentPtr FindDepartments(const std::string& baseUrl);
+    void StoreDepartments(const std::string& baseUrl, const std::string& document);
+
+    /// Returns the object ids listed by a query (the department's object
+    /// list or a search, relative to baseUrl), or null if they aren't stored.
+    OmniMetObjectIdsPtr FindObjectIds(const std::string& baseUrl, const std::string& query);
+    void StoreObjectIds(const std::string& baseUrl, const std::string& query, OmniMetObjectIdsPtr objectIds);
+
+    /// Returns the document of an object, or null if it isn't stored,
+    /// marking it as recently used.
+    OmniMetDocumentPtr FindObject(const std::string& baseUrl, int objectId);
+    void StoreObject(const std::string& baseUrl, int objectId, OmniMetDocumentPtr document);
+
+private:
+
+    OmniMetObjectStore();
+    ~OmniMetObjectStore();
+
+    // an object document is identified by its base url and object id
+    typedef std::pair<std::string, int> _ObjectKey;
+    typedef std::list<_ObjectKey> _ObjectLruList;
+
+    struct _ObjectEntry
+    {
+        OmniMetDocumentPtr document;
+        _ObjectLruList::iterator lruPosition;
+    };
+
+    struct _Collection
+    {
+        OmniMetDocumentPtr departments;
+        std::unordered_map<std::string, OmniMetObjectIdsPtr> objectIds;
+        std::unordered_map<int, _ObjectEntry> objects;
+    };
+
+    void _EvictToSize(size_t maxSize);
+
+    friend class TfSingleton<OmniMetObjectStore>;
+
+private:
+
+    std::mutex _mutex;
+    size_t _maxSize;
+    size_t _size;
+    std::unordered_map<std::string, _Collection> _collections;
+
+    // most recently used objects at the front
+    _ObjectLruList _objectLru;
+};
+
+PXR_NAMESPACE_CLOSE_SCOPE
+
+#endif
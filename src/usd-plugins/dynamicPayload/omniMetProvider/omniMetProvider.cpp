@@ -12,9 +12,9 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <pxr/base/tf/stringUtils.h>
 #include <pxr/base/tf/token.h>
 #include <pxr/base/vt/value.h>
-#include <pxr/base/js/json.h>
 #include <pxr/usd/sdf/path.h>
 #include <pxr/usd/sdf/schema.h>
 #include <pxr/usd/sdf/payload.h>
@@ -25,9 +25,25 @@
 #include <edfDataProviderFactory.h>
 
 #include "omniMetProvider.h"
-
+#include "omniMetConnectionPool.h"
+#include "omniMetCurlTransport.h"
+#include "omniMetFetchEngine.h"
+#include "omniMetJsonReader.h"
+#include "omniMetObjectFields.h"
+#include "omniMetObjectStore.h"
+#include "omniMetRecordedTransport.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
 #include <iostream>
-#include <curl/curl.h>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+#include <tbb/task_arena.h>
+#include <tbb/task_group.h>
 
 PXR_NAMESPACE_OPEN_SCOPE
 
@@ -38,6 +54,18 @@ TF_DEFINE_PUBLIC_TOKENS(
     (dataLodLevel)
     (deferredRead)
     (lod1Count)
+    (maxInFlightRequests)
+    (offline)
+    (baseUrl)
+    (transport)
+    (recordingDirectory)
+    (replayLatencyMs)
+    (replayJitterMs)
+    (searchQuery)
+    (isHighlight)
+    (hasImages)
+    (dateBegin)
+    (dateEnd)
 );
 
 TF_DEFINE_PRIVATE_TOKENS(
@@ -45,6 +73,13 @@ TF_DEFINE_PRIVATE_TOKENS(
     (EdfDataParameters)
 );
 
+TF_DEFINE_PRIVATE_TOKENS(
+    OmniMetProviderTransportNames,
+    (curl)
+    (record)
+    (replay)
+);
+
 TF_DEFINE_PRIVATE_TOKENS(
     OmniMetProviderTypeNames,
     (AmaDepartment)
@@ -55,62 +90,32 @@ TF_DEFINE_PRIVATE_TOKENS(
     OmniMetProviderFieldKeys,
     (departmentId)
     (displayName)
-    (objectID)
-    (isHighlight)
-    (accessionNumber)
-    (accessionYear)
-    (isPublicDomain)
-    (primaryImage)
-    (primaryImageSmall)
-    (additionalImages)
-    (constituents)
-    (department)
-    (objectName)
-    (title)
-    (culture)
-    (period)
-    (dynasty)
-    (reign)
-    (portfolio)
-    (artistRole)
-    (artistPrefix)
-    (artistDisplayName)
-    (artistDisplayBio)
-    (artistSuffix)
-    (artistAlphaSort)
-    (artistNationality)
-    (artistGender)
-    (artistWikidata_URL)
-    (artistULAN_URL)
-    (objectDate)
-    (objectBeginDate)
-    (objectEndDate)
-    (medium)
-    (dimensions)
-    (measurements)
-    (creditLine)
-    (geographyType)
-    (city)
-    (state)
-    (county)
-    (country)
-    (region)
-    (subregion)
-    (locale)
-    (locus)
-    (excavation)
-    (river)
-    (classification)
-    (rightsAndReproduction)
-    (linkResource)
-    (metadataDate)
-    (repository)
-    (objectURL)
-    (objectWikidataURL)
-    (isTimelineWork)
-    (galleryNumber)
 );
 
+// percent-encodes everything but the unreserved characters of RFC 3986
+static std::string _EncodeUrlComponent(const std::string& value)
+{
+    static const char hexDigits[] = "0123456789ABCDEF";
+    std::string encoded;
+    encoded.reserve(value.size() * 3);
+    for (char c : value)
+    {
+        unsigned char byte = static_cast<unsigned char>(c);
+        if (std::isalnum(byte) || c == '-' || c == '_' || c == '.' || c == '~')
+        {
+            encoded += c;
+        }
+        else
+        {
+            encoded += '%';
+            encoded += hexDigits[byte >> 4];
+            encoded += hexDigits[byte & 0x0F];
+        }
+    }
+
+    return encoded;
+}
+
 enum struct DataLodLevel
 {
     Level0 = 0,
@@ -118,20 +123,39 @@ enum struct DataLodLevel
     Level2 = 2
 };
 
-// urls used to retrieve the data
-static const std::string DEPARTMENT_URL = "https://collectionapi.metmuseum.org/public/collection/v1/departments";
-static const std::string OBJECTS_IN_DEPARTMENT_URL = "https://collectionapi.metmuseum.org/public/collection/v1/objects?departmentIds=";
-static const std::string OBJECT_URL = "https://collectionapi.metmuseum.org/public/collection/v1/objects/";
+// urls used to retrieve the data, relative to the base url
+static const std::string DEFAULT_BASE_URL = "https://collectionapi.metmuseum.org/public/collection/v1/";
+static const std::string DEPARTMENT_URL = "departments";
+static const std::string OBJECTS_IN_DEPARTMENT_URL = "objects?departmentIds=";
+static const std::string SEARCH_IN_DEPARTMENT_URL = "search?departmentId=";
+static const std::string OBJECT_URL = "objects/";
 static const SdfPath DATA_ROOT_PATH("/Data");
 
+// the search endpoint requires a query, this one matches everything
+static const std::string DEFAULT_SEARCH_QUERY = "*";
+
+// default number of object requests we keep in flight at once
+static const size_t DEFAULT_MAX_IN_FLIGHT_REQUESTS = 16;
+
 OmniMetProvider::OmniMetProvider(const EdfDataParameters& parameters) : IEdfDataProvider(parameters)
 {
-    curl_global_init(CURL_GLOBAL_DEFAULT);
+    // libcurl is initialized once per process by the connection pool
+    // rather than per provider, since curl_global_init is neither
+    // cheap nor safe to call while other threads are using libcurl
+    OmniMetConnectionPool::GetInstance();
+
+    this->_baseUrl = this->_GetStringArg(OmniMetProviderProviderArgKeys->baseUrl, DEFAULT_BASE_URL);
+    if (!TfStringEndsWith(this->_baseUrl, "/"))
+    {
+        this->_baseUrl += "/";
+    }
+
+    this->_transport = this->_CreateTransport();
+    this->_searchParameters = this->_GetSearchParameters();
 }
 
 OmniMetProvider::~OmniMetProvider()
 {
-    curl_global_cleanup();
 }
 
 bool OmniMetProvider::Read(std::shared_ptr<IEdfSourceData> sourceData)
@@ -176,45 +200,35 @@ void OmniMetProvider::_LoadData(bool includeObjects, size_t objectCount, std::sh
     {
         for (auto it = departments.begin(); it != departments.end(); it++)
         {
-            std::vector<std::string> objectData = this->_LoadObjects(TfStringify(it->second), objectCount);
-            for (auto itt = objectData.begin(); itt != objectData.end(); itt++)
-            {
-                this->_ParseObject(*itt, it->first, sourceData);
-            }
+            this->_LoadObjects(TfStringify(it->second), objectCount, it->first, sourceData);
         }
     }
 }
 
 std::string OmniMetProvider::_LoadDepartments()
 {
-    std::string departments;
-    CURL* departmentCurl = curl_easy_init();
-    if (departmentCurl != nullptr)
+    OmniMetObjectStore& objectStore = OmniMetObjectStore::GetInstance();
+    OmniMetDocumentPtr storedDepartments = objectStore.FindDepartments(this->_baseUrl);
+    if (storedDepartments != nullptr)
     {
-        CURLcode resultCode;
-        curl_easy_setopt(departmentCurl, CURLOPT_URL, DEPARTMENT_URL.c_str());
-        curl_easy_setopt(departmentCurl, CURLOPT_HTTPGET, 1L);
-        curl_easy_setopt(departmentCurl, CURLOPT_WRITEFUNCTION, OmniMetProvider::_CurlWriteCallback);
-
-        // allocate a string that we can append the result onto
-        std::string* result = new std::string();
-        curl_easy_setopt(departmentCurl, CURLOPT_WRITEDATA, reinterpret_cast<void*>(result));
-
-        resultCode = curl_easy_perform(departmentCurl);
-        if (resultCode == CURLE_OK)
-        {
-            departments = *result;
-        }
-        else
-        {
-            TF_CODING_ERROR("Unable to load departments from '%s'!", DEPARTMENT_URL.c_str());
-        }
+        return *storedDepartments;
+    }
 
-        // done with the callback data
-        delete result;
+    std::string departments;
+    std::string url = this->_baseUrl + DEPARTMENT_URL;
+    OmniMetFetchEngine fetchEngine(this->_transport, 1, this->IsOffline());
+    fetchEngine.Fetch({ url }, [&departments](const std::string& url, const OmniMetDocumentPtr& response)
+    {
+        departments = *response;
+    });
 
-        // done with the request handle
-        curl_easy_cleanup(departmentCurl);
+    if (departments.empty())
+    {
+        TF_CODING_ERROR("Unable to load departments from '%s'!", url.c_str());
+    }
+    else
+    {
+        objectStore.StoreDepartments(this->_baseUrl, departments);
     }
 
     return departments;
@@ -222,301 +236,420 @@ std::string OmniMetProvider::_LoadDepartments()
 
 std::vector<int> OmniMetProvider::_ParseObjectIds(const std::string& response) const
 {
+    // the id list of a large department can be several MB of integers,
+    // so they are read straight into the vector rather than through a DOM
     std::vector<int> objectIds;
-    PXR_NS::JsValue jsValue = PXR_NS::JsParseString(response, nullptr);
-    if (!jsValue.IsNull())
+    bool foundObjectIds = false;
+    OmniMetJsonReader reader(response);
+    reader.ReadObject([&reader, &response, &objectIds, &foundObjectIds](const OmniMetJsonString& key)
     {
-        PXR_NS::JsObject rootObject = jsValue.GetJsObject();
-        PXR_NS::JsObject::iterator it = rootObject.find("objectIDs");
-        if (it != rootObject.end())
+        if (key.Equals("total", 5))
         {
-            PXR_NS::JsArray jsonObjectIdArray = it->second.GetJsArray();
-            for (auto objectIdIt = jsonObjectIdArray.begin(); objectIdIt != jsonObjectIdArray.end(); objectIdIt++)
+            // total precedes the ids, so we know how much room they need,
+            // but it comes from the server: each id takes at least two
+            // characters of the document, so never reserve more than that
+            int total = 0;
+            if (reader.ReadInt(&total) && total > 0)
             {
-                objectIds.push_back((*objectIdIt).GetInt());
+                objectIds.reserve(std::min(static_cast<size_t>(total), response.size() / 2));
             }
         }
-        else
+        else if (key.Equals("objectIDs", 9) && reader.PeekType() == OmniMetJsonValue::Type::Null)
         {
-            TF_CODING_ERROR("Unable to find 'objectIDs' array in returned data '%s'!", response.c_str());
+            // a search without matches
+            foundObjectIds = true;
         }
-    }
-    else
+        else if (key.Equals("objectIDs", 9) && reader.PeekType() == OmniMetJsonValue::Type::Array)
+        {
+            foundObjectIds = true;
+            reader.ReadArray([&reader, &objectIds]()
+            {
+                int objectId = 0;
+                if (reader.ReadInt(&objectId))
+                {
+                    objectIds.push_back(objectId);
+                }
+            });
+        }
+    });
+
+    if (!reader.IsValid())
     {
         TF_CODING_ERROR("Data returned '%s' was not JSON or was empty!", response.c_str());
     }
+    else if (!foundObjectIds)
+    {
+        TF_CODING_ERROR("Unable to find 'objectIDs' array in returned data '%s'!", response.c_str());
+    }
 
     return objectIds;
 }
 
-std::vector<std::string> OmniMetProvider::_LoadObjects(const std::string& departmentId, size_t objectCount)
+void OmniMetProvider::_LoadObjects(const std::string& departmentId, size_t objectCount, const std::string& parentPath,
+    std::shared_ptr<IEdfSourceData> sourceData)
 {
-    // NOTE: this should be updated to make these requests in parallel in the case
-    // where we aren't doing deferred reads
-    // ideally we wouldn't want to initialize a new curl handle here, but since this
-    // call can be made in the parallel prim indexing, we can't share the easy handle
-    // across threads, so we take the overhead hit here
-    std::vector<std::string> objects;
-    CURL* objectCurl = curl_easy_init();
-    std::string url = OBJECTS_IN_DEPARTMENT_URL + departmentId;
-    std::string* result = new std::string();
-    CURLcode resultCode;
-
-    *result = "";
-    curl_easy_setopt(objectCurl, CURLOPT_URL, url.c_str());
-    curl_easy_setopt(objectCurl, CURLOPT_HTTPGET, 1L);
-    curl_easy_setopt(objectCurl, CURLOPT_WRITEFUNCTION, OmniMetProvider::_CurlWriteCallback);
-    curl_easy_setopt(objectCurl, CURLOPT_WRITEDATA, reinterpret_cast<void*>(result));
-    resultCode = curl_easy_perform(objectCurl);
-    if (resultCode == CURLE_OK)
-    {
-        // process result
-        std::vector<int> objectIds = this->_ParseObjectIds(*result);
-
-        // objectCount = 0 means load all objects
-        // objectCount > 0 means load max that many objects
-        size_t counter = 0;
-        for (auto objectIdIterator = objectIds.begin(); objectIdIterator != objectIds.end() && (objectCount == 0 || counter < objectCount); objectIdIterator++)
+    // this call can be made in the parallel prim indexing, so the
+    // transfers run on handles pooled for the calling thread
+    OmniMetFetchEngine fetchEngine(this->_transport, this->GetMaxInFlightRequests(), this->IsOffline());
+
+    // first get the ids of the objects in the department, a previous
+    // layer at a different LOD may already have them
+    OmniMetObjectStore& objectStore = OmniMetObjectStore::GetInstance();
+    // with search filters the server selects the objects, so we only
+    // get (and fetch) the ids of the objects that match
+    std::string objectListUrl = this->_searchParameters.empty() ?
+        OBJECTS_IN_DEPARTMENT_URL + departmentId :
+        SEARCH_IN_DEPARTMENT_URL + departmentId + this->_searchParameters;
+    OmniMetObjectIdsPtr objectIds = objectStore.FindObjectIds(this->_baseUrl, objectListUrl);
+    if (objectIds == nullptr)
+    {
+        OmniMetDocumentPtr objectIdData;
+        fetchEngine.Fetch({ this->_baseUrl + objectListUrl }, [&objectIdData](const std::string& url, const OmniMetDocumentPtr& response)
+        {
+            objectIdData = response;
+        });
+
+        if (objectIdData == nullptr || objectIdData->empty())
+        {
+            return;
+        }
+
+        objectIds = std::make_shared<const std::vector<int>>(this->_ParseObjectIds(*objectIdData));
+        if (!objectIds->empty())
+        {
+            objectStore.StoreObjectIds(this->_baseUrl, objectListUrl, objectIds);
+        }
+    }
+
+    // objectCount = 0 means load all objects
+    // objectCount > 0 means load max that many objects
+    size_t loadCount = objectIds->size();
+    if (objectCount > 0 && loadCount > objectCount)
+    {
+        loadCount = objectCount;
+    }
+
+    // the objects flow through a pipeline: each document is handed to a
+    // parse task on a TBB worker, so parsing runs alongside the transfers
+    // on this thread, and the parsed objects are ingested into the layer
+    // one at a time, in order; once pipelineDepth documents are in the pipeline the
+    // network loop parses the next one itself, which bounds the documents
+    // held in memory and slows the transfers down to the rate we can ingest
+    const size_t pipelineDepth = 2 * static_cast<size_t>(tbb::this_task_arena::max_concurrency());
+    std::atomic<size_t> documentsInPipeline(0);
+    tbb::task_group parseTasks;
+
+    // the objects are ingested in the order of objectIds, whatever order
+    // their responses arrive in, so the children of the department are
+    // the same from one load to the next.  Objects ready ahead of the next
+    // one to ingest wait in the reorder window, keyed by their index;
+    // those that failed to parse hold no object and are skipped.  Whether
+    // an object was parsed by a task or by the network loop, it goes
+    // through the window, and one thread at a time drains it: the others
+    // leave their object behind and return to parsing or transferring
+    std::mutex reorderWindowMutex;
+    bool draining = false;
+    size_t nextIngestIndex = 0;
+    std::map<size_t, std::unique_ptr<_ParsedObject>> reorderWindow;
+    auto ingestInOrder = [this, &parentPath, &sourceData, &reorderWindowMutex, &draining, &nextIngestIndex,
+        &reorderWindow](size_t index, std::unique_ptr<_ParsedObject> parsedObject)
+    {
+        std::unique_lock<std::mutex> lock(reorderWindowMutex);
+        reorderWindow.emplace(index, std::move(parsedObject));
+        if (draining)
+        {
+            return;
+        }
+
+        draining = true;
+        while (!reorderWindow.empty() && reorderWindow.begin()->first == nextIngestIndex)
         {
-            // reset the URL and result buffer
-            // NOTE: this should be updated to make these requests in parallel
-            url = OBJECT_URL + TfStringify(*objectIdIterator);
-            *result = "";
-            curl_easy_setopt(objectCurl, CURLOPT_URL, url.c_str());
-            resultCode = curl_easy_perform(objectCurl);
-            if (resultCode == CURLE_OK)
+            std::unique_ptr<_ParsedObject> nextObject = std::move(reorderWindow.begin()->second);
+            reorderWindow.erase(reorderWindow.begin());
+            nextIngestIndex++;
+
+            lock.unlock();
+            if (nextObject != nullptr)
             {
-                objects.push_back(*result);
+                this->_IngestObject(*nextObject, parentPath, sourceData);
             }
-            counter++;
+            lock.lock();
+        }
+        draining = false;
+    };
+    auto processDocument = [this, &ingestInOrder](size_t index, const std::string& document)
+    {
+        std::unique_ptr<_ParsedObject> parsedObject(new _ParsedObject());
+        if (!this->_ParseObject(document, parsedObject.get()))
+        {
+            parsedObject.reset();
+        }
+
+        ingestInOrder(index, std::move(parsedObject));
+    };
+    auto submitDocument = [pipelineDepth, &documentsInPipeline, &parseTasks, &processDocument](size_t index,
+        OmniMetDocumentPtr document)
+    {
+        if (documentsInPipeline.load() >= pipelineDepth)
+        {
+            processDocument(index, *document);
+            return;
+        }
+
+        documentsInPipeline++;
+        parseTasks.run([&documentsInPipeline, &processDocument, index, document]()
+        {
+            processDocument(index, *document);
+            documentsInPipeline--;
+        });
+    };
+
+    // objects another layer already fetched are created straight from the
+    // store, so raising the LOD only fetches the objects that were added
+    std::vector<std::string> urls;
+    std::unordered_map<std::string, std::pair<int, std::vector<size_t>>> urlObjects;
+    for (size_t i = 0; i < loadCount; i++)
+    {
+        int objectId = (*objectIds)[i];
+        OmniMetDocumentPtr objectDocument = objectStore.FindObject(this->_baseUrl, objectId);
+        if (objectDocument != nullptr)
+        {
+            submitDocument(i, objectDocument);
+            continue;
+        }
+
+        // an id listed twice is fetched once
+        std::string url = this->_baseUrl + OBJECT_URL + TfStringify(objectId);
+        std::pair<int, std::vector<size_t>>& urlObject = urlObjects[url];
+        if (urlObject.second.empty())
+        {
+            urls.push_back(url);
+            urlObject.first = objectId;
         }
+        urlObject.second.push_back(i);
     }
 
-    // done with the callback data
-    delete result;
+    // fetch the objects concurrently and create the prims as their data
+    // arrives rather than waiting for the whole batch
+    fetchEngine.Fetch(urls, [this, &objectStore, &urlObjects, &submitDocument](const std::string& url, const OmniMetDocumentPtr& response)
+    {
+        const std::pair<int, std::vector<size_t>>& urlObject = urlObjects[url];
+        objectStore.StoreObject(this->_baseUrl, urlObject.first, response);
+        for (size_t index : urlObject.second)
+        {
+            submitDocument(index, response);
+        }
+    });
 
-    // done with the request handle
-    curl_easy_cleanup(objectCurl);
+    parseTasks.wait();
 
-    return objects;
+    // failed fetches leave gaps the window can't drain past,
+    // the objects after them are ingested in order now
+    for (const std::pair<const size_t, std::unique_ptr<_ParsedObject>>& waitingObject : reorderWindow)
+    {
+        if (waitingObject.second != nullptr)
+        {
+            this->_IngestObject(*waitingObject.second, parentPath, sourceData);
+        }
+    }
 }
 
 std::vector<std::pair<std::string, int>> OmniMetProvider::_ParseDepartments(const std::string& departmentJson, 
     std::shared_ptr<IEdfSourceData> sourceData)
 {
     std::vector<std::pair<std::string, int>> parsedDepartments;
-    JsValue jsValue = JsParseString(departmentJson, nullptr);
-    if (!jsValue.IsNull())
+    const char* departmentKeys[] = {
+        OmniMetProviderFieldKeys->departmentId.GetText(),
+        OmniMetProviderFieldKeys->displayName.GetText()
+    };
+    const size_t departmentKeyLengths[] = {
+        OmniMetProviderFieldKeys->departmentId.size(),
+        OmniMetProviderFieldKeys->displayName.size()
+    };
+
+    bool foundDepartments = false;
+    OmniMetJsonReader reader(departmentJson);
+    reader.ReadObject([&](const OmniMetJsonString& key)
     {
-        JsObject rootObject = jsValue.GetJsObject();
-        JsObject::iterator it = rootObject.find("departments");
-        if (it != rootObject.end())
+        if (!key.Equals("departments", 11) || reader.PeekType() != OmniMetJsonValue::Type::Array)
         {
-            JsArray departments = it->second.GetJsArray();
-            std::string parent = DATA_ROOT_PATH.GetAsString();
-            for (auto departmentIt = departments.begin(); departmentIt != departments.end(); departmentIt++)
-            {
-                // for each department, create a prim to represent it
-                JsObject department = (*departmentIt).GetJsObject();
-                int departmentId = department[OmniMetProviderFieldKeys->departmentId.GetString()].GetInt();
-                std::string displayName = department[OmniMetProviderFieldKeys->displayName.GetString()].GetString();
-
-                // create the prim
-                std::string primName = TfMakeValidIdentifier(displayName);
-                sourceData->CreatePrim(DATA_ROOT_PATH, primName, SdfSpecifier::SdfSpecifierDef,
-                    OmniMetProviderTypeNames->AmaDepartment);
-
-                // create the attributes for the prim
-                SdfPath parentPrim = SdfPath(parent + "/" + primName);
-                sourceData->CreateAttribute(parentPrim, OmniMetProviderFieldKeys->departmentId.GetString(),
-                    SdfValueTypeNames->Int, SdfVariability::SdfVariabilityUniform, VtValue(departmentId));
-                sourceData->CreateAttribute(parentPrim, OmniMetProviderFieldKeys->displayName.GetString(),
-                    SdfValueTypeNames->String, SdfVariability::SdfVariabilityUniform, VtValue(displayName));
-
-                parsedDepartments.push_back(std::make_pair(parentPrim.GetAsString(), departmentId));
-            }
+            return;
         }
-        else
+
+        foundDepartments = true;
+        reader.ReadArray([&]()
         {
-            TF_CODING_ERROR("Unable to find 'departments' array in returned data '%s'!", departmentJson.c_str());
-        }
-    }
-    else
+            // for each department, create a prim to represent it
+            OmniMetJsonValue values[2];
+            if (!reader.ReadMembers(departmentKeys, departmentKeyLengths, 2, values))
+            {
+                return;
+            }
+
+            int departmentId = values[0].GetInt();
+            std::string displayName = values[1].GetString();
+
+            // create the prim
+            std::string primName = TfMakeValidIdentifier(displayName);
+            sourceData->CreatePrim(DATA_ROOT_PATH, primName, SdfSpecifier::SdfSpecifierDef,
+                OmniMetProviderTypeNames->AmaDepartment);
+
+            // create the attributes for the prim
+            SdfPath parentPrim = DATA_ROOT_PATH.AppendChild(TfToken(primName));
+            sourceData->CreateAttribute(parentPrim, OmniMetProviderFieldKeys->departmentId.GetString(),
+                SdfValueTypeNames->Int, SdfVariability::SdfVariabilityUniform, VtValue(departmentId));
+            sourceData->CreateAttribute(parentPrim, OmniMetProviderFieldKeys->displayName.GetString(),
+                SdfValueTypeNames->String, SdfVariability::SdfVariabilityUniform, VtValue(displayName));
+
+            parsedDepartments.push_back(std::make_pair(parentPrim.GetAsString(), departmentId));
+        });
+    });
+
+    if (!reader.IsValid())
     {
         TF_CODING_ERROR("Data returned '%s' was not JSON or was empty!", departmentJson.c_str());
     }
+    else if (!foundDepartments)
+    {
+        TF_CODING_ERROR("Unable to find 'departments' array in returned data '%s'!", departmentJson.c_str());
+    }
 
     return parsedDepartments;
 }
 
-void OmniMetProvider::_ParseObject(const std::string& objectData, const std::string& parentPath,
-    std::shared_ptr<IEdfSourceData> sourceData)
+bool OmniMetProvider::_ParseObject(const std::string& objectData, _ParsedObject* parsedObject) const
 {
-    // from the parent path given and the data contained in the JSON
-    // object retrieved from the server, we can create the full prim
-    JsValue jsValue = JsParseString(objectData, nullptr);
-    if (!jsValue.IsNull())
-    {
-        JsObject rootObject = jsValue.GetJsObject();
-
-        // the root object contains all of our properties that we now need
-        // to create a prim spec for the object and a set of property
-        // specs for it
-        // NOTE: this code uses the "default value" of a property spec
-        // to represent the authored value coming from the external system
-        // We don't need to do sub-composition over the data coming
-        // from the external system, so we ever only have a value or not
-        // so if HasDefaultValue is true on the property spec, it means
-        // there was an authored value that came from the remote system
-        // One optimization we could do in the layer above (EdfData) is 
-        // to add schema acquisition and checking in the loop.  This would allow us 
-        // to create the property spec or not depending on if the value that came in 
-        // is different from the true fallback declared in the schema 
-        // (but we'd have to change the ask for the property to check whether
-        // the schema has the property rather than if the property spec exists)
-        std::string objectName = rootObject[OmniMetProviderFieldKeys->objectName.GetString()].GetString();
-        std::string primName = TfMakeValidIdentifier(objectName) +
-            TfStringify(rootObject[OmniMetProviderFieldKeys->objectID.GetString()].GetInt());
-
-        // create the prim
-        SdfPath newPrimParentPath(parentPath);
-        sourceData->CreatePrim(newPrimParentPath, primName, SdfSpecifier::SdfSpecifierDef,
-            OmniMetProviderTypeNames->AmaObject);
-
-        // set the fact that this prim has an API schema attached to it
-        // usdGenSchema doesn't generate a public token for the actual
-        // API schema class name, so we hard code that here
-        SdfPath parentPrim = SdfPath(parentPath + "/" + primName);
-        TfTokenVector apiSchemas;
-        apiSchemas.push_back(TfToken("OmniMetArtistAPI"));
-        VtValue apiSchemasValue(apiSchemas);
-        sourceData->SetField(parentPrim, UsdTokens->apiSchemas, apiSchemasValue);
-
-        // create the attributes for the prim
-        sourceData->CreateAttribute(parentPrim, OmniMetProviderFieldKeys->objectID.GetString(),
-            SdfValueTypeNames->Int, SdfVariability::SdfVariabilityUniform,
-            VtValue(rootObject[OmniMetProviderFieldKeys->objectID.GetString()].GetInt()));
-        sourceData->CreateAttribute(parentPrim, OmniMetProviderFieldKeys->isHighlight.GetString(),
-            SdfValueTypeNames->Bool, SdfVariability::SdfVariabilityUniform,
-            VtValue(rootObject[OmniMetProviderFieldKeys->isHighlight.GetString()].GetBool()));
-        sourceData->CreateAttribute(parentPrim, OmniMetProviderFieldKeys->accessionNumber.GetString(),
-            SdfValueTypeNames->String, SdfVariability::SdfVariabilityUniform,
-            VtValue(rootObject[OmniMetProviderFieldKeys->accessionNumber.GetString()].GetString()));
-        sourceData->CreateAttribute(parentPrim, OmniMetProviderFieldKeys->accessionYear.GetString(),
-            SdfValueTypeNames->String, SdfVariability::SdfVariabilityUniform,
-            VtValue(rootObject[OmniMetProviderFieldKeys->accessionYear.GetString()].GetString()));
-        sourceData->CreateAttribute(parentPrim, OmniMetProviderFieldKeys->isPublicDomain.GetString(),
-            SdfValueTypeNames->Bool, SdfVariability::SdfVariabilityUniform,
-            VtValue(rootObject[OmniMetProviderFieldKeys->isPublicDomain.GetString()].GetBool()));
-        sourceData->CreateAttribute(parentPrim, OmniMetProviderFieldKeys->primaryImage.GetString(),
-            SdfValueTypeNames->String, SdfVariability::SdfVariabilityUniform,
-            VtValue(rootObject[OmniMetProviderFieldKeys->primaryImage.GetString()].GetString()));
-        sourceData->CreateAttribute(parentPrim, OmniMetProviderFieldKeys->primaryImageSmall.GetString(),
-            SdfValueTypeNames->String, SdfVariability::SdfVariabilityUniform,
-            VtValue(rootObject[OmniMetProviderFieldKeys->primaryImageSmall.GetString()].GetString()));
-
-        sourceData->CreateAttribute(parentPrim, OmniMetProviderFieldKeys->department.GetString(),
-            SdfValueTypeNames->String, SdfVariability::SdfVariabilityUniform,
-            VtValue(rootObject[OmniMetProviderFieldKeys->department.GetString()].GetString()));
-        sourceData->CreateAttribute(parentPrim, OmniMetProviderFieldKeys->title.GetString(),
-            SdfValueTypeNames->String, SdfVariability::SdfVariabilityUniform,
-            VtValue(rootObject[OmniMetProviderFieldKeys->title.GetString()].GetString()));
-        sourceData->CreateAttribute(parentPrim, OmniMetProviderFieldKeys->culture.GetString(),
-            SdfValueTypeNames->String, SdfVariability::SdfVariabilityUniform,
-            VtValue(rootObject[OmniMetProviderFieldKeys->culture.GetString()].GetString()));
-        sourceData->CreateAttribute(parentPrim, OmniMetProviderFieldKeys->period.GetString(),
-            SdfValueTypeNames->String, SdfVariability::SdfVariabilityUniform,
-            VtValue(rootObject[OmniMetProviderFieldKeys->period.GetString()].GetString()));
-        sourceData->CreateAttribute(parentPrim, OmniMetProviderFieldKeys->dynasty.GetString(),
-            SdfValueTypeNames->String, SdfVariability::SdfVariabilityUniform,
-            VtValue(rootObject[OmniMetProviderFieldKeys->dynasty.GetString()].GetString()));
-        sourceData->CreateAttribute(parentPrim, OmniMetProviderFieldKeys->reign.GetString(),
-            SdfValueTypeNames->String, SdfVariability::SdfVariabilityUniform,
-            VtValue(rootObject[OmniMetProviderFieldKeys->reign.GetString()].GetString()));
-        sourceData->CreateAttribute(parentPrim, OmniMetProviderFieldKeys->portfolio.GetString(),
-            SdfValueTypeNames->String, SdfVariability::SdfVariabilityUniform,
-            VtValue(rootObject[OmniMetProviderFieldKeys->portfolio.GetString()].GetString()));
-
-        // artist information complying with sample API schema
-        std::string namespaceFieldPrefix = "omni:met:artist:";
-        JsObject::const_iterator i = rootObject.find(OmniMetProviderFieldKeys->artistRole.GetString());
-        if (i != rootObject.end())
-        {
-            sourceData->CreateAttribute(parentPrim, namespaceFieldPrefix + OmniMetProviderFieldKeys->artistRole.GetString(),
-                SdfValueTypeNames->String, SdfVariability::SdfVariabilityUniform,
-                VtValue(rootObject[OmniMetProviderFieldKeys->artistRole.GetString()].GetString()));
-        }
-        i = rootObject.find(OmniMetProviderFieldKeys->artistPrefix.GetString());
-        if (i != rootObject.end())
-        {
-            sourceData->CreateAttribute(parentPrim, namespaceFieldPrefix + OmniMetProviderFieldKeys->artistPrefix.GetString(),
-                SdfValueTypeNames->String, SdfVariability::SdfVariabilityUniform,
-                VtValue(rootObject[OmniMetProviderFieldKeys->artistPrefix.GetString()].GetString()));
-        }
-        i = rootObject.find(OmniMetProviderFieldKeys->artistDisplayName.GetString());
-        if (i != rootObject.end())
-        {
-            sourceData->CreateAttribute(parentPrim, namespaceFieldPrefix + OmniMetProviderFieldKeys->artistDisplayName.GetString(),
-                SdfValueTypeNames->String, SdfVariability::SdfVariabilityUniform,
-                VtValue(rootObject[OmniMetProviderFieldKeys->artistDisplayName.GetString()].GetString()));
-        }
-        i = rootObject.find(OmniMetProviderFieldKeys->artistDisplayBio.GetString());
-        if (i != rootObject.end())
-        {
-            sourceData->CreateAttribute(parentPrim, namespaceFieldPrefix + OmniMetProviderFieldKeys->artistDisplayBio.GetString(),
-                SdfValueTypeNames->String, SdfVariability::SdfVariabilityUniform,
-                VtValue(rootObject[OmniMetProviderFieldKeys->artistDisplayBio.GetString()].GetString()));
-        }
-        i = rootObject.find(OmniMetProviderFieldKeys->artistSuffix.GetString());
-        if (i != rootObject.end())
-        {
-            sourceData->CreateAttribute(parentPrim, namespaceFieldPrefix + OmniMetProviderFieldKeys->artistSuffix.GetString(),
-                SdfValueTypeNames->String, SdfVariability::SdfVariabilityUniform,
-                VtValue(rootObject[OmniMetProviderFieldKeys->artistSuffix.GetString()].GetString()));
-        }
-        i = rootObject.find(OmniMetProviderFieldKeys->artistAlphaSort.GetString());
-        if (i != rootObject.end())
-        {
-            sourceData->CreateAttribute(parentPrim, namespaceFieldPrefix + OmniMetProviderFieldKeys->artistAlphaSort.GetString(),
-                SdfValueTypeNames->String, SdfVariability::SdfVariabilityUniform,
-                VtValue(rootObject[OmniMetProviderFieldKeys->artistAlphaSort.GetString()].GetString()));
-        }
-        i = rootObject.find(OmniMetProviderFieldKeys->artistNationality.GetString());
-        if (i != rootObject.end())
+    // the attribute names of the fields, built once from the field table
+    static const std::vector<TfToken> fieldAttributeNames = []()
+    {
+        std::vector<TfToken> attributeNames;
+        attributeNames.reserve(OMNI_MET_OBJECT_FIELD_COUNT);
+        for (const OmniMetFieldDescriptor& field : OMNI_MET_OBJECT_FIELDS)
         {
-            sourceData->CreateAttribute(parentPrim, namespaceFieldPrefix + OmniMetProviderFieldKeys->artistNationality.GetString(),
-                SdfValueTypeNames->String, SdfVariability::SdfVariabilityUniform,
-                VtValue(rootObject[OmniMetProviderFieldKeys->artistNationality.GetString()].GetString()));
+            attributeNames.push_back(TfToken(std::string(field.namespacePrefix) + field.jsonKey));
         }
-        i = rootObject.find(OmniMetProviderFieldKeys->artistGender.GetString());
-        if (i != rootObject.end())
+
+        return attributeNames;
+    }();
+
+    // a single pass over the members of the object document, the document
+    // has ~60 members and the ones that aren't in the field table are skipped
+    // since members arrive in table order, the search for the next one starts
+    // after the field that matched last, which usually finds it immediately
+    OmniMetJsonValue values[OMNI_MET_OBJECT_FIELD_COUNT];
+    size_t nextField = 0;
+    OmniMetJsonReader reader(objectData);
+    reader.ReadObject([&](const OmniMetJsonString& key)
+    {
+        for (size_t i = 0; i < OMNI_MET_OBJECT_FIELD_COUNT; i++)
         {
-            sourceData->CreateAttribute(parentPrim, namespaceFieldPrefix + OmniMetProviderFieldKeys->artistGender.GetString(),
-                SdfValueTypeNames->String, SdfVariability::SdfVariabilityUniform,
-                VtValue(rootObject[OmniMetProviderFieldKeys->artistGender.GetString()].GetString()));
+            size_t fieldIndex = nextField + i;
+            if (fieldIndex >= OMNI_MET_OBJECT_FIELD_COUNT)
+            {
+                fieldIndex -= OMNI_MET_OBJECT_FIELD_COUNT;
+            }
+
+            const OmniMetFieldDescriptor& field = OMNI_MET_OBJECT_FIELDS[fieldIndex];
+            if (key.Equals(field.jsonKey, field.jsonKeyLength))
+            {
+                reader.ReadValue(&values[fieldIndex]);
+                nextField = fieldIndex + 1;
+                return;
+            }
         }
-        i = rootObject.find(OmniMetProviderFieldKeys->artistWikidata_URL.GetString());
-        if (i != rootObject.end())
+    });
+
+    if (!reader.IsValid())
+    {
+        TF_CODING_ERROR("Data returned '%s' was not JSON or was empty!", objectData.c_str());
+        return false;
+    }
+
+    // the prim is named after the object's name and id
+    int objectId = values[OMNI_MET_OBJECT_ID_FIELD].GetInt();
+    parsedObject->primName = TfMakeValidIdentifier(values[OMNI_MET_OBJECT_NAME_FIELD].GetString()) +
+        TfStringify(objectId);
+
+    // the values are converted here so that the
+    // ingestion only has to hand them to the layer
+    parsedObject->attributes.clear();
+    parsedObject->attributes.reserve(OMNI_MET_OBJECT_FIELD_COUNT);
+    for (size_t i = 0; i < OMNI_MET_OBJECT_FIELD_COUNT; i++)
+    {
+        const OmniMetFieldDescriptor& field = OMNI_MET_OBJECT_FIELDS[i];
+        if (field.presence == OmniMetFieldPresence::Unauthored ||
+            (field.presence == OmniMetFieldPresence::Optional && !values[i].IsPresent()))
         {
-            sourceData->CreateAttribute(parentPrim, namespaceFieldPrefix + OmniMetProviderFieldKeys->artistWikidata_URL.GetString(),
-                SdfValueTypeNames->String, SdfVariability::SdfVariabilityUniform,
-                VtValue(rootObject[OmniMetProviderFieldKeys->artistWikidata_URL.GetString()].GetString()));
+            continue;
         }
-        i = rootObject.find(OmniMetProviderFieldKeys->artistULAN_URL.GetString());
-        if (i != rootObject.end())
+
+        _ParsedAttribute attribute;
+        attribute.name = fieldAttributeNames[i];
+        switch (field.type)
         {
-            sourceData->CreateAttribute(parentPrim, namespaceFieldPrefix + OmniMetProviderFieldKeys->artistULAN_URL.GetString(),
-                SdfValueTypeNames->String, SdfVariability::SdfVariabilityUniform,
-                VtValue(rootObject[OmniMetProviderFieldKeys->artistULAN_URL.GetString()].GetString()));
+            case OmniMetFieldType::String:
+            {
+                attribute.typeName = SdfValueTypeNames->String;
+                attribute.value = VtValue(values[i].GetString());
+                break;
+            }
+            case OmniMetFieldType::Int:
+            {
+                attribute.typeName = SdfValueTypeNames->Int;
+                attribute.value = VtValue(values[i].GetInt());
+                break;
+            }
+            case OmniMetFieldType::Bool:
+            {
+                attribute.typeName = SdfValueTypeNames->Bool;
+                attribute.value = VtValue(values[i].GetBool());
+                break;
+            }
         }
 
-        // note that there are quite a few additional properties that could be pulled, the above
-        // represents only a sample of the data that is there - if you'd like to try the rest as an
-        // exercise, you can enhance the schema attributes and read the remaining ones here
+        parsedObject->attributes.push_back(std::move(attribute));
     }
-    else
+
+    // note that there are quite a few additional properties that could be pulled, the field
+    // table represents only a sample of the data that is there - if you'd like to try the rest
+    // as an exercise, you can enhance the schema attributes and add their rows to the table
+    return true;
+}
+
+void OmniMetProvider::_IngestObject(const _ParsedObject& parsedObject, const std::string& parentPath,
+    std::shared_ptr<IEdfSourceData> sourceData)
+{
+    // create the prim
+    SdfPath newPrimParentPath(parentPath);
+    sourceData->CreatePrim(newPrimParentPath, parsedObject.primName, SdfSpecifier::SdfSpecifierDef,
+        OmniMetProviderTypeNames->AmaObject);
+
+    // set the fact that this prim has an API schema attached to it
+    // usdGenSchema doesn't generate a public token for the actual
+    // API schema class name, so we hard code that here
+    SdfPath parentPrim = newPrimParentPath.AppendChild(TfToken(parsedObject.primName));
+    TfTokenVector apiSchemas;
+    apiSchemas.push_back(TfToken("OmniMetArtistAPI"));
+    VtValue apiSchemasValue(apiSchemas);
+    sourceData->SetField(parentPrim, UsdTokens->apiSchemas, apiSchemasValue);
+
+    // create the attributes for the prim
+    // NOTE: this code uses the "default value" of a property spec
+    // to represent the authored value coming from the external system
+    // We don't need to do sub-composition over the data coming
+    // from the external system, so we ever only have a value or not
+    // so if HasDefaultValue is true on the property spec, it means
+    // there was an authored value that came from the remote system
+    // One optimization we could do in the layer above (EdfData) is 
+    // to add schema acquisition and checking in the loop.  This would allow us 
+    // to create the property spec or not depending on if the value that came in 
+    // is different from the true fallback declared in the schema 
+    // (but we'd have to change the ask for the property to check whether
+    // the schema has the property rather than if the property spec exists)
+    for (const _ParsedAttribute& attribute : parsedObject.attributes)
     {
-        TF_CODING_ERROR("Data returned '%s' was not JSON or was empty!", objectData.c_str());
+        sourceData->CreateAttribute(parentPrim, attribute.name.GetString(), attribute.typeName,
+            SdfVariability::SdfVariabilityUniform, attribute.value);
     }
 }
 
@@ -558,11 +691,7 @@ bool OmniMetProvider::ReadChildren(const std::string& parentPath, std::shared_pt
 
                         // load the object data
                         std::cout << "Loading object data for " + parentPath + "..." << std::endl;
-                        std::vector<std::string> objectData = this->_LoadObjects(TfStringify(departmentId.UncheckedGet<int>()), objectCount);
-                        for (auto it = objectData.begin(); it != objectData.end(); it++)
-                        {
-                            this->_ParseObject(*it, parentPath, sourceData);
-                        }
+                        this->_LoadObjects(TfStringify(departmentId.UncheckedGet<int>()), objectCount, parentPath, sourceData);
                     }
                 }
             }
@@ -631,12 +760,127 @@ bool OmniMetProvider::IsDeferredRead() const
     return deferredRead;
 }
 
-size_t OmniMetProvider::_CurlWriteCallback(void* data, size_t size, size_t nmemb, void* userp)
+size_t OmniMetProvider::GetMaxInFlightRequests() const
+{
+    size_t maxInFlightRequests = DEFAULT_MAX_IN_FLIGHT_REQUESTS;
+    EdfDataParameters parameters = this->GetParameters();
+    std::unordered_map<std::string, std::string>::const_iterator it = parameters.providerArgs.find(OmniMetProviderProviderArgKeys->maxInFlightRequests);
+    if (it != parameters.providerArgs.end())
+    {
+        int value = TfUnstringify<int>(it->second);
+        maxInFlightRequests = value < 1 ? 1 : static_cast<size_t>(value);
+    }
+
+    return maxInFlightRequests;
+}
+
+bool OmniMetProvider::IsOffline() const
+{
+    bool offline = false;
+    EdfDataParameters parameters = this->GetParameters();
+    std::unordered_map<std::string, std::string>::const_iterator it = parameters.providerArgs.find(OmniMetProviderProviderArgKeys->offline);
+    if (it != parameters.providerArgs.end())
+    {
+        offline = TfUnstringify<bool>(it->second);
+    }
+
+    return offline;
+}
+
+std::string OmniMetProvider::_GetStringArg(const TfToken& key, const std::string& defaultValue) const
+{
+    const EdfDataParameters& parameters = this->GetParameters();
+    std::unordered_map<std::string, std::string>::const_iterator it = parameters.providerArgs.find(key);
+    if (it != parameters.providerArgs.end())
+    {
+        return it->second;
+    }
+
+    return defaultValue;
+}
+
+size_t OmniMetProvider::_GetSizeArg(const TfToken& key, size_t defaultValue) const
+{
+    const EdfDataParameters& parameters = this->GetParameters();
+    std::unordered_map<std::string, std::string>::const_iterator it = parameters.providerArgs.find(key);
+    if (it != parameters.providerArgs.end())
+    {
+        int value = TfUnstringify<int>(it->second);
+        return value < 0 ? 0 : static_cast<size_t>(value);
+    }
+
+    return defaultValue;
+}
+
+std::string OmniMetProvider::_GetSearchParameters() const
+{
+    // the filters are appended to the department's search url,
+    // no filters means the department's full object list is used
+    std::string parameters;
+    if (TfUnstringify<bool>(this->_GetStringArg(OmniMetProviderProviderArgKeys->isHighlight, "false")))
+    {
+        parameters += "&isHighlight=true";
+    }
+    if (TfUnstringify<bool>(this->_GetStringArg(OmniMetProviderProviderArgKeys->hasImages, "false")))
+    {
+        parameters += "&hasImages=true";
+    }
+
+    // the API only accepts a date range as a pair
+    std::string dateBegin = this->_GetStringArg(OmniMetProviderProviderArgKeys->dateBegin, "");
+    std::string dateEnd = this->_GetStringArg(OmniMetProviderProviderArgKeys->dateEnd, "");
+    if (!dateBegin.empty() && !dateEnd.empty())
+    {
+        parameters += "&dateBegin=" + TfStringify(TfUnstringify<int>(dateBegin)) +
+            "&dateEnd=" + TfStringify(TfUnstringify<int>(dateEnd));
+    }
+    else if (!dateBegin.empty() || !dateEnd.empty())
+    {
+        TF_WARN("The '%s' and '%s' provider arguments must be given together, ignoring the date range",
+            OmniMetProviderProviderArgKeys->dateBegin.GetText(), OmniMetProviderProviderArgKeys->dateEnd.GetText());
+    }
+
+    std::string searchQuery = this->_GetStringArg(OmniMetProviderProviderArgKeys->searchQuery, "");
+    if (parameters.empty() && searchQuery.empty())
+    {
+        return parameters;
+    }
+
+    return parameters + "&q=" + _EncodeUrlComponent(searchQuery.empty() ? DEFAULT_SEARCH_QUERY : searchQuery);
+}
+
+OmniMetTransportPtr OmniMetProvider::_CreateTransport() const
 {
-    std::string* result = reinterpret_cast<std::string*>(userp);
-    result->append(reinterpret_cast<const char* const>(data), nmemb);
+    std::string transport = this->_GetStringArg(OmniMetProviderProviderArgKeys->transport,
+        OmniMetProviderTransportNames->curl);
+    std::string recordingDirectory = this->_GetStringArg(OmniMetProviderProviderArgKeys->recordingDirectory, "");
+    if ((transport == OmniMetProviderTransportNames->record || transport == OmniMetProviderTransportNames->replay) &&
+        recordingDirectory.empty())
+    {
+        TF_CODING_ERROR("The '%s' transport requires the '%s' provider argument, using '%s' instead",
+            transport.c_str(), OmniMetProviderProviderArgKeys->recordingDirectory.GetText(),
+            OmniMetProviderTransportNames->curl.GetText());
+        transport = OmniMetProviderTransportNames->curl;
+    }
+
+    if (transport == OmniMetProviderTransportNames->replay)
+    {
+        return std::make_shared<OmniMetReplayTransport>(recordingDirectory, this->_baseUrl,
+            this->_GetSizeArg(OmniMetProviderProviderArgKeys->replayLatencyMs, 0),
+            this->_GetSizeArg(OmniMetProviderProviderArgKeys->replayJitterMs, 0));
+    }
+    else if (transport == OmniMetProviderTransportNames->record)
+    {
+        return std::make_shared<OmniMetRecordingTransport>(std::make_shared<OmniMetCurlTransport>(),
+            recordingDirectory, this->_baseUrl);
+    }
+    else if (transport != OmniMetProviderTransportNames->curl)
+    {
+        TF_CODING_ERROR("Unknown transport '%s', using '%s' instead", transport.c_str(),
+            OmniMetProviderTransportNames->curl.GetText());
+    }
 
-    return nmemb;
+    return std::make_shared<OmniMetCurlTransport>();
 }
 
 PXR_NAMESPACE_CLOSE_SCOPE
@@ -21,11 +21,15 @@
 
 #include <pxr/pxr.h>
 #include <pxr/base/tf/token.h>
+#include <pxr/base/vt/value.h>
 #include <pxr/usd/sdf/layer.h>
 #include <pxr/usd/sdf/schema.h>
+#include <pxr/usd/sdf/valueTypeName.h>
 
 #include <iEdfDataProvider.h>
 
+#include "omniMetTransport.h"
+
 PXR_NAMESPACE_OPEN_SCOPE
 
 TF_DECLARE_PUBLIC_TOKENS(
@@ -33,6 +37,18 @@ TF_DECLARE_PUBLIC_TOKENS(
     (dataLodLevel)
     (deferredRead)
     (lod1Count)
+    (maxInFlightRequests)
+    (offline)
+    (baseUrl)
+    (transport)
+    (recordingDirectory)
+    (replayLatencyMs)
+    (replayJitterMs)
+    (searchQuery)
+    (isHighlight)
+    (hasImages)
+    (dateBegin)
+    (dateEnd)
 );
 
 /// \class OmniMetProvider
@@ -41,6 +57,22 @@ TF_DECLARE_PUBLIC_TOKENS(
 /// from the Metropolitan Museum of Art REST APIs and converting that
 /// into prim and attribute data that can be processed by USD.
 ///
+/// HTTP access goes through an OmniMetTransport chosen by the transport
+/// provider argument:
+///
+/// - "curl" (default): requests are made to baseUrl with libcurl
+/// - "record": as "curl", but every response is also written to
+///   recordingDirectory
+/// - "replay": responses are served from recordingDirectory, delayed by
+///   replayLatencyMs +/- replayJitterMs milliseconds
+///
+/// baseUrl defaults to the Met collection API and can be pointed at a
+/// local stand-in such as metStandInServer.py.
+///
+/// The objects of each department can be narrowed down on the server with
+/// the searchQuery, isHighlight, hasImages and dateBegin / dateEnd provider
+/// arguments, which turn the department's object list into a search.
+///
 class OmniMetProvider : public IEdfDataProvider
 {
 public:
@@ -54,16 +86,41 @@ public:
 
 private:
 
+    // an object document parsed into the prim and attributes it becomes,
+    // so that parsing can run in parallel and only the ingestion into
+    // the layer has to be serialized
+    struct _ParsedAttribute
+    {
+        TfToken name;
+        SdfValueTypeName typeName;
+        VtValue value;
+    };
+
+    struct _ParsedObject
+    {
+        std::string primName;
+        std::vector<_ParsedAttribute> attributes;
+    };
+
     int GetDataLodLevel() const;
     size_t GetLod1Count() const;
     bool IsDeferredRead() const;
+    size_t GetMaxInFlightRequests() const;
+    bool IsOffline() const;
+    std::string _GetStringArg(const TfToken& key, const std::string& defaultValue) const;
+    size_t _GetSizeArg(const TfToken& key, size_t defaultValue) const;
+    OmniMetTransportPtr _CreateTransport() const;
+    std::string _GetSearchParameters() const;
 
     void _LoadData(bool includeObjects, size_t objectCount, std::shared_ptr<IEdfSourceData> sourceData);
     std::string _LoadDepartments();
-    std::vector<std::string> _LoadObjects(const std::string& departmentId, size_t objectCount);
+    void _LoadObjects(const std::string& departmentId, size_t objectCount, const std::string& parentPath,
+        std::shared_ptr<IEdfSourceData> sourceData);
     std::vector<std::pair<std::string, int>> _ParseDepartments(const std::string& departmentJson, 
         std::shared_ptr<IEdfSourceData> sourceData);
-    void _ParseObject(const std::string& objectData, const std::string& parentPath, std::shared_ptr<IEdfSourceData> sourceData);
+    bool _ParseObject(const std::string& objectData, _ParsedObject* parsedObject) const;
+    void _IngestObject(const _ParsedObject& parsedObject, const std::string& parentPath,
+        std::shared_ptr<IEdfSourceData> sourceData);
 
     // NOTE: these methods are not technically const, since they do change internal state
     // in the edfData object's layer data.  This is ok, because that object is a cache
@@ -78,7 +135,13 @@ private:
     std::vector<int> _ParseObjectIds(const std::string& response) const;
     void _ParseObject(const std::string& parentPath, const std::string& response) const;
 
-    static size_t _CurlWriteCallback(void* data, size_t size, size_t nmemb, void* userp);
+private:
+
+    std::string _baseUrl;
+    OmniMetTransportPtr _transport;
+
+    // query string of the search filters, empty if there are none
+    std::string _searchParameters;
 };
 
 PXR_NAMESPACE_CLOSE_SCOPE
@@ -0,0 +1,74 @@
+// Copyright 2023 NVIDIA CORPORATION
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+
+#include <pxr/base/tf/envSetting.h>
+#include <pxr/base/tf/instantiateSingleton.h>
+
+#include "omniMetRateLimiter.h"
+
+PXR_NAMESPACE_OPEN_SCOPE
+
+TF_INSTANTIATE_SINGLETON(OmniMetRateLimiter);
+
+TF_DEFINE_ENV_SETTING(OMNI_MET_MAX_REQUESTS_PER_SECOND, 80,
+    "Maximum number of requests per second sent to the Met collection API by all providers (0 is unlimited)");
+
+OmniMetRateLimiter::OmniMetRateLimiter()
+{
+    int requestsPerSecond = TfGetEnvSetting(OMNI_MET_MAX_REQUESTS_PER_SECOND);
+    this->_requestsPerSecond = requestsPerSecond < 0 ? 0.0 : static_cast<double>(requestsPerSecond);
+
+    // the bucket only holds a single token, a larger burst would let
+    // more than the allowed number of requests into some one second window
+    this->_capacity = 1.0;
+    this->_tokens = this->_capacity;
+    this->_lastRefill = Clock::now();
+}
+
+OmniMetRateLimiter::~OmniMetRateLimiter()
+{
+}
+
+bool OmniMetRateLimiter::TryAcquire(Clock::duration* wait)
+{
+    if (this->_requestsPerSecond <= 0.0)
+    {
+        return true;
+    }
+
+    std::lock_guard<std::mutex> lock(this->_mutex);
+
+    Clock::time_point now = Clock::now();
+    double elapsedSeconds = std::chrono::duration<double>(now - this->_lastRefill).count();
+    this->_tokens = std::min(this->_capacity, this->_tokens + elapsedSeconds * this->_requestsPerSecond);
+    this->_lastRefill = now;
+
+    if (this->_tokens >= 1.0)
+    {
+        this->_tokens -= 1.0;
+        return true;
+    }
+
+    if (wait != nullptr)
+    {
+        *wait = std::chrono::duration_cast<Clock::duration>(
+            std::chrono::duration<double>((1.0 - this->_tokens) / this->_requestsPerSecond));
+    }
+
+    return false;
+}
+
+PXR_NAMESPACE_CLOSE_SCOPE
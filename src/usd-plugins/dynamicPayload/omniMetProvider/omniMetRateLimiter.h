@@ -0,0 +1,71 @@
+// Copyright 2023 NVIDIA CORPORATION
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef OMNI_OMNIMETPROVIDER_OMNIMETRATELIMITER_H_
+#define OMNI_OMNIMETPROVIDER_OMNIMETRATELIMITER_H_
+
+#include <chrono>
+#include <mutex>
+
+#include <pxr/pxr.h>
+#include <pxr/base/tf/singleton.h>
+
+PXR_NAMESPACE_OPEN_SCOPE
+
+/// \class OmniMetRateLimiter
+///
+/// Process-wide token bucket limiting the rate at which requests are
+/// sent to the Met collection API, shared by all provider instances
+/// so that opening several layers at once doesn't exceed the limit.
+/// The rate defaults to the 80 requests per second the API documents
+/// and can be changed with the OMNI_MET_MAX_REQUESTS_PER_SECOND
+/// environment setting (0 disables the limit).
+///
+class OmniMetRateLimiter
+{
+public:
+    typedef std::chrono::steady_clock Clock;
+
+    static OmniMetRateLimiter& GetInstance()
+    {
+        return TfSingleton<OmniMetRateLimiter>::GetInstance();
+    }
+
+    // prevent copying and assignment
+    OmniMetRateLimiter(const OmniMetRateLimiter&) = delete;
+    OmniMetRateLimiter& operator=(const OmniMetRateLimiter&) = delete;
+
+    /// Takes a token if one is available and returns true, otherwise
+    /// returns false and sets wait to how long until the next one is.
+    bool TryAcquire(Clock::duration* wait);
+
+private:
+
+    OmniMetRateLimiter();
+    ~OmniMetRateLimiter();
+
+    friend class TfSingleton<OmniMetRateLimiter>;
+
+private:
+
+    std::mutex _mutex;
+    double _requestsPerSecond;
+    double _capacity;
+    double _tokens;
+    Clock::time_point _lastRefill;
+};
+
+PXR_NAMESPACE_CLOSE_SCOPE
+
+#endif
@@ -0,0 +1,228 @@
+// Copyright 2023 NVIDIA CORPORATION
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <fstream>
+#include <functional>
+#include <iterator>
+#include <queue>
+#include <thread>
+#include <utility>
+
+#include <pxr/base/arch/hash.h>
+#include <pxr/base/tf/atomicOfstreamWrapper.h>
+#include <pxr/base/tf/diagnostic.h>
+#include <pxr/base/tf/fileUtils.h>
+#include <pxr/base/tf/pathUtils.h>
+#include <pxr/base/tf/stringUtils.h>
+
+#include "omniMetRecordedTransport.h"
+
+PXR_NAMESPACE_OPEN_SCOPE
+
+static const long HTTP_OK = 200;
+static const long HTTP_NOT_MODIFIED = 304;
+static const long HTTP_NOT_FOUND = 404;
+
+// recording names keep at most this many characters of the url,
+// the hash suffix tells apart urls sharing them
+static const size_t RECORDING_NAME_MAX_PREFIX = 96;
+
+// 64 bit FNV-1a, simple enough for metStandInServer.py to compute the same
+static uint64_t _HashRecordingUrl(const std::string& url)
+{
+    uint64_t hash = 14695981039346656037ULL;
+    for (char c : url)
+    {
+        hash ^= static_cast<unsigned char>(c);
+        hash *= 1099511628211ULL;
+    }
+
+    return hash;
+}
+
+std::string OmniMetGetRecordingName(const std::string& url, const std::string& baseUrl)
+{
+    std::string relativeUrl;
+    if (TfStringStartsWith(url, baseUrl))
+    {
+        relativeUrl = url.substr(baseUrl.length());
+    }
+    else
+    {
+        // drop the scheme and host
+        size_t schemeEnd = url.find("://");
+        size_t pathStart = url.find('/', schemeEnd == std::string::npos ? 0 : schemeEnd + 3);
+        relativeUrl = (pathStart == std::string::npos) ? std::string() : url.substr(pathStart + 1);
+    }
+
+    std::string name = relativeUrl.substr(0, RECORDING_NAME_MAX_PREFIX);
+    for (char& c : name)
+    {
+        if (!std::isalnum(static_cast<unsigned char>(c)))
+        {
+            c = '_';
+        }
+    }
+
+    return name + TfStringPrintf("_%016llx.json",
+        static_cast<unsigned long long>(_HashRecordingUrl(relativeUrl)));
+}
+
+OmniMetRecordingTransport::OmniMetRecordingTransport(OmniMetTransportPtr transport, const std::string& directory,
+    const std::string& baseUrl) :
+    _transport(transport),
+    _directory(directory),
+    _baseUrl(baseUrl)
+{
+    if (!TfIsDir(this->_directory) && !TfMakeDirs(this->_directory, -1, true))
+    {
+        TF_WARN("Unable to create recording directory '%s'", this->_directory.c_str());
+    }
+}
+
+OmniMetRecordingTransport::~OmniMetRecordingTransport()
+{
+}
+
+void OmniMetRecordingTransport::Fetch(const std::vector<OmniMetHttpRequest>& requests, size_t maxInFlightRequests,
+    const CompletionCallback& onComplete)
+{
+    // recordings must be complete responses, so the requests are sent
+    // unconditionally rather than risk recording an empty 304
+    std::vector<OmniMetHttpRequest> unconditionalRequests;
+    unconditionalRequests.reserve(requests.size());
+    for (const OmniMetHttpRequest& request : requests)
+    {
+        OmniMetHttpRequest unconditionalRequest;
+        unconditionalRequest.url = request.url;
+        unconditionalRequests.push_back(std::move(unconditionalRequest));
+    }
+
+    this->_transport->Fetch(unconditionalRequests, maxInFlightRequests,
+        [this, &requests, &unconditionalRequests, &onComplete](const OmniMetHttpRequest& request, OmniMetHttpResponse& response)
+    {
+        if (response.statusCode >= 200 && response.statusCode < 300)
+        {
+            std::string path = TfStringCatPaths(this->_directory, OmniMetGetRecordingName(request.url, this->_baseUrl));
+            std::string reason;
+            TfAtomicOfstreamWrapper wrapper(path);
+            if (wrapper.Open(&reason))
+            {
+                wrapper.GetStream().write(response.body.data(), response.body.size());
+                wrapper.Commit(&reason);
+            }
+
+            if (!reason.empty())
+            {
+                TF_WARN("Unable to record response for '%s': %s", request.url.c_str(), reason.c_str());
+            }
+        }
+
+        // report back against the caller's request
+        onComplete(requests[&request - unconditionalRequests.data()], response);
+    });
+}
+
+OmniMetReplayTransport::OmniMetReplayTransport(const std::string& directory, const std::string& baseUrl,
+    size_t latencyMs, size_t jitterMs) :
+    _directory(directory),
+    _baseUrl(baseUrl),
+    _latencyMs(latencyMs),
+    _jitterMs(std::min(jitterMs, latencyMs))
+{
+    if (!TfIsDir(this->_directory))
+    {
+        TF_WARN("Replay directory '%s' does not exist, all requests will fail", this->_directory.c_str());
+    }
+}
+
+OmniMetReplayTransport::~OmniMetReplayTransport()
+{
+}
+
+void OmniMetReplayTransport::Fetch(const std::vector<OmniMetHttpRequest>& requests, size_t maxInFlightRequests,
+    const CompletionCallback& onComplete)
+{
+    // each slot holds a response until its simulated arrival time, the
+    // earliest pending response is delivered first, as a server would
+    typedef std::chrono::steady_clock Clock;
+    typedef std::pair<Clock::time_point, size_t> PendingResponse;
+    std::priority_queue<PendingResponse, std::vector<PendingResponse>, std::greater<PendingResponse>> pendingResponses;
+
+    size_t maxPending = std::max<size_t>(maxInFlightRequests, 1);
+    size_t nextRequest = 0;
+    while (nextRequest < requests.size() || !pendingResponses.empty())
+    {
+        while (nextRequest < requests.size() && pendingResponses.size() < maxPending)
+        {
+            Clock::time_point arrival = Clock::now() + std::chrono::duration_cast<Clock::duration>(
+                std::chrono::duration<double>(this->_GetDelaySeconds(requests[nextRequest].url)));
+            pendingResponses.push(std::make_pair(arrival, nextRequest++));
+        }
+
+        PendingResponse next = pendingResponses.top();
+        pendingResponses.pop();
+        std::this_thread::sleep_until(next.first);
+
+        const OmniMetHttpRequest& request = requests[next.second];
+        OmniMetHttpResponse response = this->_ReadResponse(request);
+        onComplete(request, response);
+    }
+}
+
+OmniMetHttpResponse OmniMetReplayTransport::_ReadResponse(const OmniMetHttpRequest& request) const
+{
+    OmniMetHttpResponse response;
+    std::ifstream stream(TfStringCatPaths(this->_directory, OmniMetGetRecordingName(request.url, this->_baseUrl)),
+        std::ios::in | std::ios::binary);
+    if (!stream)
+    {
+        response.statusCode = HTTP_NOT_FOUND;
+        return response;
+    }
+
+    response.body.assign(std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>());
+    response.validators.etag = TfStringPrintf("\"%016llx\"",
+        static_cast<unsigned long long>(ArchHash64(response.body.data(), response.body.size())));
+
+    if (!request.validators.etag.empty() && request.validators.etag == response.validators.etag)
+    {
+        response.statusCode = HTTP_NOT_MODIFIED;
+        response.body.clear();
+    }
+    else
+    {
+        response.statusCode = HTTP_OK;
+    }
+
+    return response;
+}
+
+double OmniMetReplayTransport::_GetDelaySeconds(const std::string& url) const
+{
+    // map the hash of the url onto [-1, 1] to pick the jitter
+    double jitter = 0.0;
+    if (this->_jitterMs > 0)
+    {
+        uint64_t hash = ArchHash64(url.data(), url.size());
+        jitter = (static_cast<double>(hash >> 11) / static_cast<double>(1ULL << 53)) * 2.0 - 1.0;
+    }
+
+    return (static_cast<double>(this->_latencyMs) + jitter * static_cast<double>(this->_jitterMs)) / 1000.0;
+}
+
+PXR_NAMESPACE_CLOSE_SCOPE
@@ -0,0 +1,98 @@
+// Copyright 2023 NVIDIA CORPORATION
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef OMNI_OMNIMETPROVIDER_OMNIMETRECORDEDTRANSPORT_H_
+#define OMNI_OMNIMETPROVIDER_OMNIMETRECORDEDTRANSPORT_H_
+
+#include <string>
+
+#include <pxr/pxr.h>
+
+#include "omniMetTransport.h"
+
+PXR_NAMESPACE_OPEN_SCOPE
+
+/// Returns the name of the file a response for url is recorded in.
+/// The name is derived from the part of url following baseUrl (or the
+/// host, if url doesn't start with baseUrl): its first 96 characters
+/// with every character that isn't alphanumeric replaced by '_',
+/// followed by the 64 bit FNV-1a hash of all of it, so urls differing
+/// only in punctuation or past the prefix get files of their own, e.g.
+/// "objects?departmentIds=1" is recorded in
+/// "objects_departmentIds_1_<16 hex digits>.json".  metStandInServer.py
+/// uses the same naming.
+std::string OmniMetGetRecordingName(const std::string& url, const std::string& baseUrl);
+
+/// \class OmniMetRecordingTransport
+///
+/// Transport forwarding all requests to another transport and writing
+/// the body of every successful response to a directory, from which
+/// OmniMetReplayTransport or metStandInServer.py can serve it later.
+///
+class OmniMetRecordingTransport : public OmniMetTransport
+{
+public:
+
+    OmniMetRecordingTransport(OmniMetTransportPtr transport, const std::string& directory, const std::string& baseUrl);
+    virtual ~OmniMetRecordingTransport();
+
+    virtual void Fetch(const std::vector<OmniMetHttpRequest>& requests, size_t maxInFlightRequests,
+        const CompletionCallback& onComplete) override;
+
+private:
+
+    OmniMetTransportPtr _transport;
+    std::string _directory;
+    std::string _baseUrl;
+};
+
+/// \class OmniMetReplayTransport
+///
+/// Transport serving responses recorded by OmniMetRecordingTransport
+/// without touching the network.  Each response is delayed by latencyMs
+/// plus or minus up to jitterMs milliseconds, with at most
+/// maxInFlightRequests responses pending at once, so concurrent fetching
+/// behaves much as it would against a real server.  The delay of a URL
+/// is derived from the URL itself, so runs are reproducible.
+///
+/// Responses carry an ETag computed from their content and conditional
+/// requests matching it are answered with 304, so revalidation can be
+/// exercised as well.  URLs without a recording are answered with 404.
+///
+class OmniMetReplayTransport : public OmniMetTransport
+{
+public:
+
+    OmniMetReplayTransport(const std::string& directory, const std::string& baseUrl, size_t latencyMs, size_t jitterMs);
+    virtual ~OmniMetReplayTransport();
+
+    virtual void Fetch(const std::vector<OmniMetHttpRequest>& requests, size_t maxInFlightRequests,
+        const CompletionCallback& onComplete) override;
+
+private:
+
+    OmniMetHttpResponse _ReadResponse(const OmniMetHttpRequest& request) const;
+    double _GetDelaySeconds(const std::string& url) const;
+
+private:
+
+    std::string _directory;
+    std::string _baseUrl;
+    size_t _latencyMs;
+    size_t _jitterMs;
+};
+
+PXR_NAMESPACE_CLOSE_SCOPE
+
+#endif
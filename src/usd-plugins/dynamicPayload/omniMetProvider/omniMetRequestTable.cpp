@@ -0,0 +1,105 @@
+// Copyright 2023 NVIDIA CORPORATION
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <utility>
+
+#include <pxr/base/tf/diagnostic.h>
+#include <pxr/base/tf/instantiateSingleton.h>
+
+#include "omniMetRequestTable.h"
+
+PXR_NAMESPACE_OPEN_SCOPE
+
+TF_INSTANTIATE_SINGLETON(OmniMetRequestTable);
+
+OmniMetRequestTable::OmniMetRequestTable() :
+    _sent(0),
+    _coalesced(0),
+    _retried(0),
+    _failed(0)
+{
+}
+
+OmniMetRequestTable::~OmniMetRequestTable()
+{
+}
+
+bool OmniMetRequestTable::Claim(const std::string& url, Waiter* waiter)
+{
+    std::lock_guard<std::mutex> lock(this->_mutex);
+    auto result = this->_inFlightRequests.emplace(url, _InFlightRequest());
+    _InFlightRequest& inFlightRequest = result.first->second;
+    if (result.second)
+    {
+        inFlightRequest.waiter = inFlightRequest.promise.get_future().share();
+        return true;
+    }
+
+    *waiter = inFlightRequest.waiter;
+    return false;
+}
+
+void OmniMetRequestTable::Complete(const std::string& url, OmniMetDocumentPtr response)
+{
+    std::promise<OmniMetDocumentPtr> promise;
+    {
+        std::lock_guard<std::mutex> lock(this->_mutex);
+        auto it = this->_inFlightRequests.find(url);
+        if (it == this->_inFlightRequests.end())
+        {
+            TF_CODING_ERROR("Completing request for '%s' which was never claimed", url.c_str());
+            return;
+        }
+
+        promise = std::move(it->second.promise);
+        this->_inFlightRequests.erase(it);
+    }
+
+    // waiters are released outside the lock, a later claim of the
+    // same url starts a new transfer
+    promise.set_value(response);
+}
+
+OmniMetRequestStatistics OmniMetRequestTable::GetStatistics() const
+{
+    OmniMetRequestStatistics statistics;
+    statistics.sent = this->_sent.load();
+    statistics.coalesced = this->_coalesced.load();
+    statistics.retried = this->_retried.load();
+    statistics.failed = this->_failed.load();
+
+    return statistics;
+}
+
+void OmniMetRequestTable::CountSent(size_t count)
+{
+    this->_sent += count;
+}
+
+void OmniMetRequestTable::CountCoalesced(size_t count)
+{
+    this->_coalesced += count;
+}
+
+void OmniMetRequestTable::CountRetried(size_t count)
+{
+    this->_retried += count;
+}
+
+void OmniMetRequestTable::CountFailed(size_t count)
+{
+    this->_failed += count;
+}
+
+PXR_NAMESPACE_CLOSE_SCOPE
@@ -0,0 +1,119 @@
+// Copyright 2023 NVIDIA CORPORATION
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef OMNI_OMNIMETPROVIDER_OMNIMETREQUESTTABLE_H_
+#define OMNI_OMNIMETPROVIDER_OMNIMETREQUESTTABLE_H_
+
+#include <atomic>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include <pxr/pxr.h>
+#include <pxr/base/tf/singleton.h>
+
+#include "omniMetTransport.h"
+
+PXR_NAMESPACE_OPEN_SCOPE
+
+/// \struct OmniMetRequestStatistics
+///
+/// Counts of the requests made through the fetch engine since the
+/// process started.
+///
+struct OmniMetRequestStatistics
+{
+    // requests sent, including retries
+    size_t sent = 0;
+
+    // fetches that waited on an identical request already in flight
+    size_t coalesced = 0;
+
+    // requests sent again after a transient failure
+    size_t retried = 0;
+
+    // requests that failed for good
+    size_t failed = 0;
+};
+
+/// \class OmniMetRequestTable
+///
+/// Process-wide table of the URLs currently being fetched.  When several
+/// layers or threads expand the same department at once, the first fetch
+/// of a URL claims it and performs the transfer, later fetches of the same
+/// URL wait for its result instead of sending an identical request.
+///
+/// Whoever claims a URL must complete it, whether the transfer
+/// succeeded or not, or the fetches waiting on it never return.
+///
+class OmniMetRequestTable
+{
+public:
+    // the response of the transfer, null if it failed
+    typedef std::shared_future<OmniMetDocumentPtr> Waiter;
+
+    static OmniMetRequestTable& GetInstance()
+    {
+        return TfSingleton<OmniMetRequestTable>::GetInstance();
+    }
+
+    // prevent copying and assignment
+    OmniMetRequestTable(const OmniMetRequestTable&) = delete;
+    OmniMetRequestTable& operator=(const OmniMetRequestTable&) = delete;
+
+    /// Returns true if the caller now owns the transfer of url, otherwise
+    /// returns false and sets waiter to the result of the transfer already
+    /// in flight.
+    bool Claim(const std::string& url, Waiter* waiter);
+
+    /// Publishes the result of a transfer claimed with Claim
+    /// to its waiters and removes url from the table.
+    void Complete(const std::string& url, OmniMetDocumentPtr response);
+
+    OmniMetRequestStatistics GetStatistics() const;
+
+    void CountSent(size_t count);
+    void CountCoalesced(size_t count);
+    void CountRetried(size_t count);
+    void CountFailed(size_t count);
+
+private:
+
+    OmniMetRequestTable();
+    ~OmniMetRequestTable();
+
+    friend class TfSingleton<OmniMetRequestTable>;
+
+private:
+
+    struct _InFlightRequest
+    {
+        std::promise<OmniMetDocumentPtr> promise;
+        Waiter waiter;
+    };
+
+    std::mutex _mutex;
+    std::unordered_map<std::string, _InFlightRequest> _inFlightRequests;
+
+    std::atomic<size_t> _sent;
+    std::atomic<size_t> _coalesced;
+    std::atomic<size_t> _retried;
+    std::atomic<size_t> _failed;
+};
+
+PXR_NAMESPACE_CLOSE_SCOPE
+
+#endif
@@ -0,0 +1,105 @@
+// Copyright 2023 NVIDIA CORPORATION
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef OMNI_OMNIMETPROVIDER_OMNIMETTRANSPORT_H_
+#define OMNI_OMNIMETPROVIDER_OMNIMETTRANSPORT_H_
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <pxr/pxr.h>
+
+PXR_NAMESPACE_OPEN_SCOPE
+
+/// \struct OmniMetHttpValidators
+///
+/// The validators a server returned with a response, sent back
+/// on later requests to ask whether the response has changed.
+///
+struct OmniMetHttpValidators
+{
+    std::string etag;
+    std::string lastModified;
+
+    bool IsEmpty() const
+    {
+        return this->etag.empty() && this->lastModified.empty();
+    }
+};
+
+/// \struct OmniMetHttpRequest
+///
+/// A GET request, made conditional if validators are given.
+///
+struct OmniMetHttpRequest
+{
+    std::string url;
+    OmniMetHttpValidators validators;
+};
+
+/// \struct OmniMetHttpResponse
+///
+/// The outcome of a request.  statusCode is 0 if the request
+/// failed before any response was received, in which case
+/// error describes why.  retryAfterSeconds is the delay the
+/// server asked for with Retry-After, or -1 if it didn't.
+///
+struct OmniMetHttpResponse
+{
+    long statusCode = 0;
+    std::string body;
+    OmniMetHttpValidators validators;
+    long retryAfterSeconds = -1;
+    std::string error;
+};
+
+/// A response body, shared between everyone who holds on to it
+/// (the HTTP cache, the object store and the parse tasks) so
+/// that it is never copied once it has been received.
+typedef std::shared_ptr<const std::string> OmniMetDocumentPtr;
+
+/// \class OmniMetTransport
+///
+/// Interface for the HTTP access of the Met provider, so that the
+/// provider can run against the live API, record what it receives
+/// or replay recorded responses without touching the network.
+///
+/// Transports must be safe to use from several threads at once,
+/// each call to Fetch is independent.
+///
+class OmniMetTransport
+{
+public:
+
+    typedef std::function<void(const OmniMetHttpRequest& request, OmniMetHttpResponse& response)> CompletionCallback;
+
+    virtual ~OmniMetTransport();
+
+    /// Performs all of requests with at most maxInFlightRequests of them
+    /// in flight at once, calling onComplete for each one (whether it
+    /// succeeded or not) in completion order on the calling thread.
+    /// The request passed to onComplete is the element of requests the
+    /// response belongs to, onComplete may move the body out of the
+    /// response.
+    virtual void Fetch(const std::vector<OmniMetHttpRequest>& requests, size_t maxInFlightRequests,
+        const CompletionCallback& onComplete) = 0;
+};
+
+typedef std::shared_ptr<OmniMetTransport> OmniMetTransportPtr;
+
+PXR_NAMESPACE_CLOSE_SCOPE
+
+#endif
@@ -0,0 +1,166 @@
+// Copyright 2023 NVIDIA CORPORATION
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <map>
+
+#include <pxr/base/tf/stringUtils.h>
+
+#include "edfCachingProvider.h"
+#include "edfDataProviderFactory.h"
+#include "edfPluginManager.h"
+#include "edfResponseCache.h"
+
+PXR_NAMESPACE_OPEN_SCOPE
+
+EDF_DEFINE_DATAPROVIDER(EdfCachingProvider);
+
+TF_DEFINE_PUBLIC_TOKENS(
+	EdfCachingProviderProviderArgKeys,
+
+	// the dataProviderId of the provider whose responses are cached
+	(innerDataProviderId)
+
+	// how long (in seconds) a cached response is valid for
+	(cacheTtlSeconds)
+);
+
+static const std::string READ_KEY = "#Read";
+static const std::string READ_CHILDREN_KEY = "#ReadChildren:";
+
+EdfCachingProvider::EdfCachingProvider(const EdfDataParameters& parameters) : IEdfDataProvider(parameters)
+{
+	this->_ttlSeconds = 0.0;
+
+	// split our arguments into the ones meant for us and the ones
+	// we forward to the inner provider, the latter are sorted so the
+	// cache key doesn't depend on the hash map iteration order
+	std::map<std::string, std::string> sortedInnerArgs;
+	for (const std::pair<const std::string, std::string>& arg : parameters.providerArgs)
+	{
+		if (arg.first == EdfCachingProviderProviderArgKeys->innerDataProviderId)
+		{
+			this->_innerParameters.dataProviderId = arg.second;
+		}
+		else if (arg.first == EdfCachingProviderProviderArgKeys->cacheTtlSeconds)
+		{
+			this->_ttlSeconds = TfUnstringify<double>(arg.second);
+		}
+		else
+		{
+			this->_innerParameters.providerArgs[arg.first] = arg.second;
+			sortedInnerArgs[arg.first] = arg.second;
+		}
+	}
+
+	this->_cacheKeyPrefix = this->_innerParameters.dataProviderId;
+	for (const std::pair<const std::string, std::string>& arg : sortedInnerArgs)
+	{
+		this->_cacheKeyPrefix += "|" + arg.first + "=" + arg.second;
+	}
+
+	if (this->_innerParameters.dataProviderId.empty())
+	{
+		TF_CODING_ERROR("'%s' must be specified for the caching data provider!",
+			EdfCachingProviderProviderArgKeys->innerDataProviderId.GetText());
+	}
+}
+
+EdfCachingProvider::~EdfCachingProvider()
+{
+}
+
+bool EdfCachingProvider::Read(std::shared_ptr<IEdfSourceData> sourceData)
+{
+	const std::string key = this->_cacheKeyPrefix + READ_KEY;
+	EdfRecordedResponseConstPtr response = EdfResponseCache::GetInstance().Find(key, this->_ttlSeconds);
+	if (response == nullptr)
+	{
+		IEdfDataProvider* innerProvider = this->_GetInnerProvider();
+		if (innerProvider == nullptr)
+		{
+			return false;
+		}
+
+		std::shared_ptr<EdfRecordingSourceData> recordingSourceData = std::make_shared<EdfRecordingSourceData>(sourceData);
+		bool result = innerProvider->Read(recordingSourceData);
+
+		// failures may be transient (a network error, a record not there
+		// yet), so they are tried again next time rather than replayed
+		if (result)
+		{
+			EdfResponseCache::GetInstance().Insert(key, recordingSourceData->TakeResponse(result));
+		}
+
+		return result;
+	}
+
+	response->Replay(sourceData);
+
+	return response->GetResult();
+}
+
+bool EdfCachingProvider::ReadChildren(const std::string& primPath, std::shared_ptr<IEdfSourceData> sourceData)
+{
+	const std::string key = this->_cacheKeyPrefix + READ_CHILDREN_KEY + primPath;
+	EdfRecordedResponseConstPtr response = EdfResponseCache::GetInstance().Find(key, this->_ttlSeconds);
+	if (response == nullptr)
+	{
+		IEdfDataProvider* innerProvider = this->_GetInnerProvider();
+		if (innerProvider == nullptr)
+		{
+			return false;
+		}
+
+		std::shared_ptr<EdfRecordingSourceData> recordingSourceData = std::make_shared<EdfRecordingSourceData>(sourceData);
+		bool result = innerProvider->ReadChildren(primPath, recordingSourceData);
+
+		// failures may be transient (a network error, a record not there
+		// yet), so they are tried again next time rather than replayed
+		if (result)
+		{
+			EdfResponseCache::GetInstance().Insert(key, recordingSourceData->TakeResponse(result));
+		}
+
+		return result;
+	}
+
+	response->Replay(sourceData);
+
+	return response->GetResult();
+}
+
+bool EdfCachingProvider::IsDataCached() const
+{
+	// whether data arrives on Read or on demand depends on the inner
+	// provider, which may never be created if everything comes from
+	// the cache, so we conservatively report that data is streamed
+	return false;
+}
+
+IEdfDataProvider* EdfCachingProvider::_GetInnerProvider()
+{
+	// ReadChildren may be called concurrently during prim indexing
+	std::call_once(this->_innerProviderCreated, [this]()
+	{
+		if (!this->_innerParameters.dataProviderId.empty())
+		{
+			this->_innerProvider = EdfPluginManager::GetInstance().CreateDataProvider(
+				this->_innerParameters.dataProviderId, this->_innerParameters);
+		}
+	});
+
+	return this->_innerProvider.get();
+}
+
+PXR_NAMESPACE_CLOSE_SCOPE
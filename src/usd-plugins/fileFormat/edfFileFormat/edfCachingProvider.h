@@ -0,0 +1,78 @@
+// Copyright 2023 NVIDIA CORPORATION
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef OMNI_EDF_EDFCACHINGPROVIDER_H_
+#define OMNI_EDF_EDFCACHINGPROVIDER_H_
+
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include <pxr/pxr.h>
+#include <pxr/base/tf/staticTokens.h>
+
+#include "iEdfDataProvider.h"
+
+PXR_NAMESPACE_OPEN_SCOPE
+
+TF_DECLARE_PUBLIC_TOKENS(
+	EdfCachingProviderProviderArgKeys,
+	(innerDataProviderId)
+	(cacheTtlSeconds)
+);
+
+/// \class EdfCachingProvider
+///
+/// A data provider that wraps another data provider and shares its
+/// responses across layers through the process-wide EdfResponseCache.
+///
+/// The wrapped provider is identified by the innerDataProviderId
+/// provider argument and receives all of the remaining provider
+/// arguments except cacheTtlSeconds, which controls how long a cached
+/// response is considered valid (0, the default, never expires).
+/// Only successful responses are cached, a failed read is passed
+/// on to the wrapped provider again the next time.
+/// The wrapped provider is only created when a response is not
+/// already in the cache.
+///
+class EdfCachingProvider : public IEdfDataProvider
+{
+public:
+
+	EdfCachingProvider(const EdfDataParameters& parameters);
+	virtual ~EdfCachingProvider();
+
+	virtual bool Read(std::shared_ptr<IEdfSourceData> sourceData) override;
+	virtual bool ReadChildren(const std::string& primPath, std::shared_ptr<IEdfSourceData> sourceData) override;
+	virtual bool IsDataCached() const override;
+
+private:
+
+	IEdfDataProvider* _GetInnerProvider();
+
+private:
+
+	EdfDataParameters _innerParameters;
+	double _ttlSeconds;
+
+	// identifies the inner provider configuration in cache keys
+	std::string _cacheKeyPrefix;
+
+	std::once_flag _innerProviderCreated;
+	std::unique_ptr<IEdfDataProvider> _innerProvider;
+};
+
+PXR_NAMESPACE_CLOSE_SCOPE
+
+#endif
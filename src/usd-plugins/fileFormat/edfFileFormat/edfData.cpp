@@ -21,8 +21,6 @@
 #include "edfDataProviderFactory.h"
 #include "edfPluginManager.h"
 
-#include <iostream>
-
 PXR_NAMESPACE_OPEN_SCOPE
 
 static const SdfPath ROOT_PATH("/");
@@ -252,7 +250,6 @@ bool EdfData::Has(const SdfPath& path, const TfToken& fieldName, VtValue* value)
 	// if we asked the data provider to load the children, and after that the field
 	// still isn't present, then we insert the field with an empty list since
 	// the provider never created any children (maybe the back-end query returned nothing)
-    std::cout << path.GetAsString() << " " << fieldName.GetString() << std::endl;
 	bool hasValue = this->_GetFieldValue(path, fieldName, value);
 	if (!hasValue && fieldName == SdfChildrenKeys->PrimChildren &&
 		this->_dataProvider != nullptr)
@@ -524,7 +521,7 @@ void EdfData::_CreateAttribute(const SdfPath& primPath, const std::string& name,
 	this->_CreateSpec(attributePath, SdfSpecType::SdfSpecTypeAttribute);
 	this->_SetFieldValue(attributePath, SdfFieldKeys->TypeName, VtValue(typeName));
 	this->_SetFieldValue(attributePath, SdfFieldKeys->Variability, VtValue(variability));
-	this->_SetFieldValue(attributePath, SdfFieldKeys->Default, value);
+	this->_SetFieldValue(attributePath, SdfFieldKeys->Default, this->_stringValues.Intern(attributePath.GetNameToken(), value));
 
     // add this attribute to PropertyChildren of primPath
     VtValue existingPropertyChildrenValue;
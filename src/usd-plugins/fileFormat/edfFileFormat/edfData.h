@@ -25,6 +25,7 @@
 
 #include <tbb/concurrent_hash_map.h>
 
+#include "edfStringDictionary.h"
 #include "iEdfDataProvider.h"
 
 PXR_NAMESPACE_OPEN_SCOPE
@@ -148,6 +149,10 @@ private:
 	// used to callback on to create prims / attributes
 	std::shared_ptr<IEdfSourceData> _sourceData;
 
+	// shares the storage of repeated string attribute values
+	// (departments, cultures, dates) across the prims of all open layers
+	EdfStringDictionary::References _stringValues;
+
     // mimic the storage structure of SdfData, just put it
     // in a concurrent_hash_map rather than a TfHashMap
     // the downside here is if we lock one field value for a write
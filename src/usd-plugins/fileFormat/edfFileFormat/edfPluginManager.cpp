@@ -81,6 +81,7 @@ void EdfPluginManager::_GetDataProviders()
 {
 	// this uses the standard Pixar plug-in mechansim to load and discover
 	// plug-ins of a certain type
+	std::lock_guard<std::mutex> lock(this->_pluginsMutex);
 	if (!this->_pluginsLoaded)
 	{
 		std::set<TfType> dataProviderTypes;
@@ -15,6 +15,7 @@
 #ifndef OMNI_EDF_EDFPLUGINMANAGER_H_
 #define OMNI_EDF_EDFPLUGINMANAGER_H_
 
+#include <mutex>
 #include <string>
 #include <unordered_map>
 
@@ -64,6 +65,9 @@ private:
 
 private:
 
+	// data providers can create other data providers (e.g. the caching provider)
+	// from within their own reads, so discovery may happen on several threads
+	std::mutex _pluginsMutex;
 	bool _pluginsLoaded;
 	std::unordered_map<std::string, _DataProviderInfo> _dataProviderPlugins;
 };
@@ -0,0 +1,245 @@
+// Copyright 2023 NVIDIA CORPORATION
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <pxr/base/tf/envSetting.h>
+#include <pxr/base/tf/instantiateSingleton.h>
+
+#include "edfResponseCache.h"
+
+PXR_NAMESPACE_OPEN_SCOPE
+
+TF_INSTANTIATE_SINGLETON(EdfResponseCache);
+
+TF_DEFINE_ENV_SETTING(EDF_RESPONSE_CACHE_MAX_BYTES, 256 * 1024 * 1024,
+	"Maximum number of bytes of recorded data provider responses kept by the EDF response cache");
+
+// rough estimate of the memory held by a value, we only need this
+// to be in the right ballpark for the size bound of the cache
+static size_t _EstimateValueSize(const VtValue& value)
+{
+	size_t size = sizeof(VtValue);
+	if (value.IsHolding<std::string>())
+	{
+		size += value.UncheckedGet<std::string>().capacity();
+	}
+	else if (value.IsHolding<TfTokenVector>())
+	{
+		size += value.UncheckedGet<TfTokenVector>().size() * sizeof(TfToken);
+	}
+	else if (value.IsArrayValued())
+	{
+		size += value.GetArraySize() * sizeof(double);
+	}
+
+	return size;
+}
+
+EdfRecordedResponse::EdfRecordedResponse(bool result, std::vector<EdfSourceDataOperation>&& operations) :
+	_result(result),
+	_size(sizeof(EdfRecordedResponse)),
+	_operations(std::move(operations))
+{
+	for (const EdfSourceDataOperation& operation : this->_operations)
+	{
+		this->_size += sizeof(EdfSourceDataOperation) + operation.name.capacity() + _EstimateValueSize(operation.value);
+	}
+}
+
+bool EdfRecordedResponse::GetResult() const
+{
+	return this->_result;
+}
+
+size_t EdfRecordedResponse::GetSize() const
+{
+	return this->_size;
+}
+
+void EdfRecordedResponse::Replay(std::shared_ptr<IEdfSourceData> sourceData) const
+{
+	for (const EdfSourceDataOperation& operation : this->_operations)
+	{
+		switch (operation.type)
+		{
+			case EdfSourceDataOperation::Type::CreatePrim:
+				sourceData->CreatePrim(operation.path, operation.name, operation.specifier, operation.token);
+				break;
+			case EdfSourceDataOperation::Type::CreateAttribute:
+				sourceData->CreateAttribute(operation.path, operation.name, operation.valueTypeName,
+					operation.variability, operation.value);
+				break;
+			case EdfSourceDataOperation::Type::SetField:
+				sourceData->SetField(operation.path, operation.token, operation.value);
+				break;
+		}
+	}
+}
+
+EdfRecordingSourceData::EdfRecordingSourceData(std::shared_ptr<IEdfSourceData> sourceData) : _sourceData(sourceData)
+{
+}
+
+EdfRecordingSourceData::~EdfRecordingSourceData() = default;
+
+void EdfRecordingSourceData::CreatePrim(const SdfPath& parentPath, const std::string& name, const SdfSpecifier& specifier,
+	const TfToken& typeName)
+{
+	this->_sourceData->CreatePrim(parentPath, name, specifier, typeName);
+
+	EdfSourceDataOperation operation;
+	operation.type = EdfSourceDataOperation::Type::CreatePrim;
+	operation.path = parentPath;
+	operation.name = name;
+	operation.specifier = specifier;
+	operation.token = typeName;
+
+	std::lock_guard<std::mutex> lock(this->_operationsMutex);
+	this->_operations.push_back(std::move(operation));
+}
+
+void EdfRecordingSourceData::CreateAttribute(const SdfPath& parentPrimPath, const std::string& name, const SdfValueTypeName& typeName,
+	const SdfVariability& variability, const VtValue& value)
+{
+	this->_sourceData->CreateAttribute(parentPrimPath, name, typeName, variability, value);
+
+	EdfSourceDataOperation operation;
+	operation.type = EdfSourceDataOperation::Type::CreateAttribute;
+	operation.path = parentPrimPath;
+	operation.name = name;
+	operation.valueTypeName = typeName;
+	operation.variability = variability;
+	operation.value = value;
+
+	std::lock_guard<std::mutex> lock(this->_operationsMutex);
+	this->_operations.push_back(std::move(operation));
+}
+
+void EdfRecordingSourceData::SetField(const SdfPath& primPath, const TfToken& fieldName, const VtValue& value)
+{
+	this->_sourceData->SetField(primPath, fieldName, value);
+
+	EdfSourceDataOperation operation;
+	operation.type = EdfSourceDataOperation::Type::SetField;
+	operation.path = primPath;
+	operation.token = fieldName;
+	operation.value = value;
+
+	std::lock_guard<std::mutex> lock(this->_operationsMutex);
+	this->_operations.push_back(std::move(operation));
+}
+
+bool EdfRecordingSourceData::HasField(const SdfPath& primPath, const TfToken& fieldName, VtValue* value)
+{
+	// reads don't change the layer content, so they aren't recorded
+	return this->_sourceData->HasField(primPath, fieldName, value);
+}
+
+bool EdfRecordingSourceData::HasAttribute(const SdfPath& attributePath, VtValue* defaultValue)
+{
+	return this->_sourceData->HasAttribute(attributePath, defaultValue);
+}
+
+EdfRecordedResponseConstPtr EdfRecordingSourceData::TakeResponse(bool result)
+{
+	std::lock_guard<std::mutex> lock(this->_operationsMutex);
+	return std::make_shared<const EdfRecordedResponse>(result, std::move(this->_operations));
+}
+
+EdfResponseCache::EdfResponseCache()
+{
+	this->_maxSize = static_cast<size_t>(TfGetEnvSetting(EDF_RESPONSE_CACHE_MAX_BYTES));
+	this->_size = 0;
+}
+
+EdfResponseCache::~EdfResponseCache()
+{
+}
+
+EdfRecordedResponseConstPtr EdfResponseCache::Find(const std::string& key, double ttlSeconds)
+{
+	std::lock_guard<std::mutex> lock(this->_mutex);
+	std::unordered_map<std::string, _Entry>::iterator it = this->_entries.find(key);
+	if (it == this->_entries.end())
+	{
+		return nullptr;
+	}
+
+	if (ttlSeconds > 0.0)
+	{
+		std::chrono::duration<double> age = _Clock::now() - it->second.insertionTime;
+		if (age.count() > ttlSeconds)
+		{
+			// expired, drop it so the caller refetches
+			this->_size -= it->second.response->GetSize();
+			this->_lru.erase(it->second.lruPosition);
+			this->_entries.erase(it);
+
+			return nullptr;
+		}
+	}
+
+	// mark as most recently used
+	this->_lru.splice(this->_lru.begin(), this->_lru, it->second.lruPosition);
+
+	return it->second.response;
+}
+
+void EdfResponseCache::Insert(const std::string& key, EdfRecordedResponseConstPtr response)
+{
+	if (response == nullptr || response->GetSize() > this->_maxSize)
+	{
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock(this->_mutex);
+	std::unordered_map<std::string, _Entry>::iterator it = this->_entries.find(key);
+	if (it != this->_entries.end())
+	{
+		// another layer raced us to the same response, replace it
+		this->_size -= it->second.response->GetSize();
+		this->_lru.erase(it->second.lruPosition);
+		this->_entries.erase(it);
+	}
+
+	this->_EvictToSize(this->_maxSize - response->GetSize());
+
+	this->_lru.push_front(key);
+	_Entry& entry = this->_entries[key];
+	entry.response = response;
+	entry.insertionTime = _Clock::now();
+	entry.lruPosition = this->_lru.begin();
+	this->_size += response->GetSize();
+}
+
+void EdfResponseCache::Clear()
+{
+	std::lock_guard<std::mutex> lock(this->_mutex);
+	this->_entries.clear();
+	this->_lru.clear();
+	this->_size = 0;
+}
+
+void EdfResponseCache::_EvictToSize(size_t maxSize)
+{
+	// must be called with the mutex held
+	while (this->_size > maxSize && !this->_lru.empty())
+	{
+		std::unordered_map<std::string, _Entry>::iterator it = this->_entries.find(this->_lru.back());
+		this->_size -= it->second.response->GetSize();
+		this->_entries.erase(it);
+		this->_lru.pop_back();
+	}
+}
+
+PXR_NAMESPACE_CLOSE_SCOPE
@@ -0,0 +1,182 @@
+// Copyright 2023 NVIDIA CORPORATION
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef OMNI_EDF_EDFRESPONSECACHE_H_
+#define OMNI_EDF_EDFRESPONSECACHE_H_
+
+#include <chrono>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <pxr/pxr.h>
+#include <pxr/base/tf/singleton.h>
+#include <pxr/base/tf/token.h>
+#include <pxr/base/vt/value.h>
+#include <pxr/usd/sdf/path.h>
+#include <pxr/usd/sdf/types.h>
+#include <pxr/usd/sdf/valueTypeName.h>
+
+#include "iEdfDataProvider.h"
+
+PXR_NAMESPACE_OPEN_SCOPE
+
+/// \struct EdfSourceDataOperation
+///
+/// A single call a data provider made on an IEdfSourceData object.
+///
+struct EdfSourceDataOperation
+{
+	enum class Type
+	{
+		CreatePrim,
+		CreateAttribute,
+		SetField
+	};
+
+	Type type;
+	SdfPath path;
+	std::string name;
+	SdfSpecifier specifier;
+
+	// the prim type name for CreatePrim, the field name for SetField
+	TfToken token;
+	SdfValueTypeName valueTypeName;
+	SdfVariability variability;
+	VtValue value;
+};
+
+/// \class EdfRecordedResponse
+///
+/// The stream of IEdfSourceData calls a data provider made while
+/// servicing one Read / ReadChildren request, along with the result
+/// it returned.  The stream can be replayed into the source data of
+/// any later layer to reproduce the same prims and attributes without
+/// asking the data provider again.
+///
+class EdfRecordedResponse
+{
+public:
+
+	EdfRecordedResponse(bool result, std::vector<EdfSourceDataOperation>&& operations);
+
+	bool GetResult() const;
+	size_t GetSize() const;
+
+	void Replay(std::shared_ptr<IEdfSourceData> sourceData) const;
+
+private:
+
+	bool _result;
+	size_t _size;
+	std::vector<EdfSourceDataOperation> _operations;
+};
+
+using EdfRecordedResponseConstPtr = std::shared_ptr<const EdfRecordedResponse>;
+
+/// \class EdfRecordingSourceData
+///
+/// Forwards all calls to another IEdfSourceData object while
+/// recording the ones that create content so they can be stored
+/// as an EdfRecordedResponse.
+///
+class EdfRecordingSourceData : public IEdfSourceData
+{
+public:
+
+	EdfRecordingSourceData(std::shared_ptr<IEdfSourceData> sourceData);
+	virtual ~EdfRecordingSourceData();
+
+	virtual void CreatePrim(const SdfPath& parentPath, const std::string& name, const SdfSpecifier& specifier,
+		const TfToken& typeName) override;
+	virtual void CreateAttribute(const SdfPath& parentPrimPath, const std::string& name, const SdfValueTypeName& typeName,
+		const SdfVariability& variability, const VtValue& value) override;
+	virtual void SetField(const SdfPath& primPath, const TfToken& fieldName, const VtValue& value) override;
+	virtual bool HasField(const SdfPath& primPath, const TfToken& fieldName, VtValue* value) override;
+	virtual bool HasAttribute(const SdfPath& attributePath, VtValue* defaultValue) override;
+
+	/// Moves the recorded operations into a new response object.
+	EdfRecordedResponseConstPtr TakeResponse(bool result);
+
+private:
+
+	std::shared_ptr<IEdfSourceData> _sourceData;
+	std::mutex _operationsMutex;
+	std::vector<EdfSourceDataOperation> _operations;
+};
+
+/// \class EdfResponseCache
+///
+/// Process-wide, size-bounded LRU cache of recorded data provider
+/// responses shared by all EDF layers.  The maximum size in bytes
+/// is controlled by the EDF_RESPONSE_CACHE_MAX_BYTES environment
+/// setting.
+///
+class EdfResponseCache
+{
+public:
+	static EdfResponseCache& GetInstance()
+	{
+		return TfSingleton<EdfResponseCache>::GetInstance();
+	}
+
+	// prevent copying and assignment
+	EdfResponseCache(const EdfResponseCache&) = delete;
+	EdfResponseCache& operator=(const EdfResponseCache&) = delete;
+
+	/// Returns the response stored for key, or nullptr if there is none
+	/// or if it is older than ttlSeconds (a ttlSeconds of 0 never expires).
+	EdfRecordedResponseConstPtr Find(const std::string& key, double ttlSeconds);
+
+	/// Stores response for key, evicting the least recently used
+	/// responses until the cache fits within its maximum size.
+	void Insert(const std::string& key, EdfRecordedResponseConstPtr response);
+
+	void Clear();
+
+private:
+
+	EdfResponseCache();
+	~EdfResponseCache();
+
+	void _EvictToSize(size_t maxSize);
+
+	friend class TfSingleton<EdfResponseCache>;
+
+private:
+
+	typedef std::chrono::steady_clock _Clock;
+
+	struct _Entry
+	{
+		EdfRecordedResponseConstPtr response;
+		_Clock::time_point insertionTime;
+		std::list<std::string>::iterator lruPosition;
+	};
+
+	std::mutex _mutex;
+	size_t _maxSize;
+	size_t _size;
+
+	// most recently used keys are at the front
+	std::list<std::string> _lru;
+	std::unordered_map<std::string, _Entry> _entries;
+};
+
+PXR_NAMESPACE_CLOSE_SCOPE
+
+#endif
@@ -0,0 +1,428 @@
+// Copyright 2023 NVIDIA CORPORATION
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <chrono>
+#include <unordered_map>
+
+#include <pxr/base/tf/hashmap.h>
+#include <pxr/base/tf/stringUtils.h>
+#include <pxr/usd/sdf/schema.h>
+
+#include "edfShardedProvider.h"
+#include "edfDataProviderFactory.h"
+#include "edfPluginManager.h"
+#include "edfResponseCache.h"
+
+PXR_NAMESPACE_OPEN_SCOPE
+
+EDF_DEFINE_DATAPROVIDER(EdfShardedProvider);
+
+TF_DEFINE_PUBLIC_TOKENS(
+	EdfShardedProviderProviderArgKeys,
+
+	// the number of shards the hierarchy is split across
+	(shardCount)
+
+	// how long to wait for a shard on each call
+	(shardTimeoutMs)
+
+	// the per-shard argument naming the shard's data provider
+	(dataProviderId)
+);
+
+static const std::string SHARD_ARG_PREFIX = "shard";
+
+/// \class _ShardSourceData
+///
+/// Buffers what a single shard creates during one call so that the
+/// results of all shards can be merged in a deterministic order once
+/// they have all answered.  Reads are answered from the buffer first
+/// and then from the layer, until the call is abandoned, after which
+/// the layer may no longer exist.  The buffered operations are indexed
+/// by the path they target as they are recorded, so a read costs a
+/// lookup rather than a scan of everything the shard created so far.
+///
+class _ShardSourceData : public IEdfSourceData
+{
+public:
+
+	_ShardSourceData(std::shared_ptr<IEdfSourceData> sourceData) : _sourceData(sourceData)
+	{
+	}
+
+	virtual ~_ShardSourceData() = default;
+
+	virtual void CreatePrim(const SdfPath& parentPath, const std::string& name, const SdfSpecifier& specifier,
+		const TfToken& typeName) override
+	{
+		EdfSourceDataOperation operation;
+		operation.type = EdfSourceDataOperation::Type::CreatePrim;
+		operation.path = parentPath;
+		operation.name = name;
+		operation.specifier = specifier;
+		operation.token = typeName;
+		SdfPath primPath = parentPath.AppendChild(TfToken(name));
+
+		std::lock_guard<std::mutex> lock(this->_mutex);
+		this->_fieldOperations[primPath][SdfFieldKeys->TypeName] = this->_operations.size();
+		this->_operations.push_back(std::move(operation));
+	}
+
+	virtual void CreateAttribute(const SdfPath& parentPrimPath, const std::string& name, const SdfValueTypeName& typeName,
+		const SdfVariability& variability, const VtValue& value) override
+	{
+		EdfSourceDataOperation operation;
+		operation.type = EdfSourceDataOperation::Type::CreateAttribute;
+		operation.path = parentPrimPath;
+		operation.name = name;
+		operation.valueTypeName = typeName;
+		operation.variability = variability;
+		operation.value = value;
+		SdfPath attributePath = parentPrimPath.AppendProperty(TfToken(name));
+
+		std::lock_guard<std::mutex> lock(this->_mutex);
+		this->_attributeOperations[attributePath] = this->_operations.size();
+		this->_operations.push_back(std::move(operation));
+	}
+
+	virtual void SetField(const SdfPath& primPath, const TfToken& fieldName, const VtValue& value) override
+	{
+		EdfSourceDataOperation operation;
+		operation.type = EdfSourceDataOperation::Type::SetField;
+		operation.path = primPath;
+		operation.token = fieldName;
+		operation.value = value;
+
+		std::lock_guard<std::mutex> lock(this->_mutex);
+		this->_fieldOperations[primPath][fieldName] = this->_operations.size();
+		this->_operations.push_back(std::move(operation));
+	}
+
+	virtual bool HasField(const SdfPath& primPath, const TfToken& fieldName, VtValue* value) override
+	{
+		std::lock_guard<std::mutex> lock(this->_mutex);
+
+		// the index holds the most recent buffered write, which
+		// wins as it would in the layer
+		auto primIt = this->_fieldOperations.find(primPath);
+		if (primIt != this->_fieldOperations.end())
+		{
+			auto fieldIt = primIt->second.find(fieldName);
+			if (fieldIt != primIt->second.end())
+			{
+				if (value != nullptr)
+				{
+					const EdfSourceDataOperation& operation = this->_operations[fieldIt->second];
+					*value = operation.type == EdfSourceDataOperation::Type::CreatePrim ?
+						VtValue(operation.token) : operation.value;
+				}
+
+				return true;
+			}
+		}
+
+		if (this->_sourceData == nullptr)
+		{
+			return false;
+		}
+
+		return this->_sourceData->HasField(primPath, fieldName, value);
+	}
+
+	virtual bool HasAttribute(const SdfPath& attributePath, VtValue* defaultValue) override
+	{
+		std::lock_guard<std::mutex> lock(this->_mutex);
+		auto it = this->_attributeOperations.find(attributePath);
+		if (it != this->_attributeOperations.end())
+		{
+			if (defaultValue != nullptr)
+			{
+				*defaultValue = this->_operations[it->second].value;
+			}
+
+			return true;
+		}
+
+		if (this->_sourceData == nullptr)
+		{
+			return false;
+		}
+
+		return this->_sourceData->HasAttribute(attributePath, defaultValue);
+	}
+
+	/// Stops forwarding reads to the layer, called when the
+	/// call is abandoned because the shard timed out.
+	void Detach()
+	{
+		std::lock_guard<std::mutex> lock(this->_mutex);
+		this->_sourceData = nullptr;
+	}
+
+	std::vector<EdfSourceDataOperation> TakeOperations()
+	{
+		std::lock_guard<std::mutex> lock(this->_mutex);
+		this->_fieldOperations.clear();
+		this->_attributeOperations.clear();
+		return std::move(this->_operations);
+	}
+
+private:
+
+	std::mutex _mutex;
+	std::shared_ptr<IEdfSourceData> _sourceData;
+	std::vector<EdfSourceDataOperation> _operations;
+
+	// the index in _operations of the most recent operation
+	// setting each field of a prim, CreatePrim sets its type name
+	TfHashMap<SdfPath, TfHashMap<TfToken, size_t, TfToken::HashFunctor>, SdfPath::Hash> _fieldOperations;
+
+	// the index in _operations of the most recent
+	// CreateAttribute of each attribute path
+	TfHashMap<SdfPath, size_t, SdfPath::Hash> _attributeOperations;
+};
+
+EdfShardedProvider::EdfShardedProvider(const EdfDataParameters& parameters) : IEdfDataProvider(parameters)
+{
+	this->_timeoutMs = 0;
+	size_t shardCount = 0;
+	std::unordered_map<std::string, std::string>::const_iterator it = parameters.providerArgs.find(EdfShardedProviderProviderArgKeys->shardCount);
+	if (it != parameters.providerArgs.end())
+	{
+		int count = TfUnstringify<int>(it->second);
+		shardCount = count < 0 ? 0 : static_cast<size_t>(count);
+	}
+
+	it = parameters.providerArgs.find(EdfShardedProviderProviderArgKeys->shardTimeoutMs);
+	if (it != parameters.providerArgs.end())
+	{
+		int timeout = TfUnstringify<int>(it->second);
+		this->_timeoutMs = timeout < 0 ? 0 : static_cast<size_t>(timeout);
+	}
+
+	// unpack the "shard<i>:<key>" arguments into one parameter set per shard
+	std::vector<EdfDataParameters> shardParameters(shardCount);
+	for (const std::pair<const std::string, std::string>& arg : parameters.providerArgs)
+	{
+		size_t separator = arg.first.find(':');
+		if (separator == std::string::npos || arg.first.compare(0, SHARD_ARG_PREFIX.length(), SHARD_ARG_PREFIX) != 0)
+		{
+			continue;
+		}
+
+		bool validIndex = false;
+		size_t shardIndex = TfUnstringify<size_t>(
+			arg.first.substr(SHARD_ARG_PREFIX.length(), separator - SHARD_ARG_PREFIX.length()), &validIndex);
+		if (!validIndex || shardIndex >= shardCount)
+		{
+			TF_WARN("Ignoring sharded provider argument '%s' for an unknown shard", arg.first.c_str());
+			continue;
+		}
+
+		std::string key = arg.first.substr(separator + 1);
+		if (key == EdfShardedProviderProviderArgKeys->dataProviderId)
+		{
+			shardParameters[shardIndex].dataProviderId = arg.second;
+		}
+		else
+		{
+			shardParameters[shardIndex].providerArgs[key] = arg.second;
+		}
+	}
+
+	// each shard is created through the same factory path as any top level provider
+	for (size_t i = 0; i < shardCount; i++)
+	{
+		std::unique_ptr<IEdfDataProvider> shard = EdfPluginManager::GetInstance().CreateDataProvider(
+			shardParameters[i].dataProviderId, shardParameters[i]);
+		if (shard == nullptr)
+		{
+			TF_CODING_ERROR("Failed to create data provider '%s' for shard %zu",
+				shardParameters[i].dataProviderId.c_str(), i);
+			continue;
+		}
+
+		this->_shards.push_back(std::move(shard));
+	}
+}
+
+EdfShardedProvider::~EdfShardedProvider()
+{
+	std::lock_guard<std::mutex> lock(this->_abandonedCallsMutex);
+	for (_AbandonedCall& call : this->_abandonedCalls)
+	{
+		call.result.wait();
+	}
+}
+
+bool EdfShardedProvider::Read(std::shared_ptr<IEdfSourceData> sourceData)
+{
+	return this->_DispatchToShards([](IEdfDataProvider* shard, std::shared_ptr<IEdfSourceData> shardSourceData)
+	{
+		return shard->Read(shardSourceData);
+	}, sourceData);
+}
+
+bool EdfShardedProvider::ReadChildren(const std::string& primPath, std::shared_ptr<IEdfSourceData> sourceData)
+{
+	return this->_DispatchToShards([primPath](IEdfDataProvider* shard, std::shared_ptr<IEdfSourceData> shardSourceData)
+	{
+		return shard->ReadChildren(primPath, shardSourceData);
+	}, sourceData);
+}
+
+bool EdfShardedProvider::IsDataCached() const
+{
+	for (const std::shared_ptr<IEdfDataProvider>& shard : this->_shards)
+	{
+		if (!shard->IsDataCached())
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+bool EdfShardedProvider::_DispatchToShards(const _ShardCall& call, std::shared_ptr<IEdfSourceData> sourceData)
+{
+	// NOTE: the shards run on their own threads rather than in a TBB task group
+	// because a shard that times out has to be abandoned while it is still
+	// running - waiting on it from a TBB worker would either block until it is
+	// done or, if all workers end up waiting, never make progress at all
+	std::vector<bool> busy = this->_GetBusyShards();
+	std::vector<std::shared_ptr<_ShardSourceData>> shardSourceData(this->_shards.size());
+	std::vector<std::future<bool>> shardResults(this->_shards.size());
+	for (size_t i = 0; i < this->_shards.size(); i++)
+	{
+		// a shard still running a call that timed out isn't entered
+		// again, the provider may not expect concurrent calls and
+		// would most likely be as slow to answer this one
+		if (busy[i])
+		{
+			TF_WARN("Shard %zu is still running a call that timed out, leaving it out of the result", i);
+			continue;
+		}
+
+		std::shared_ptr<IEdfDataProvider> shard = this->_shards[i];
+		std::shared_ptr<_ShardSourceData> shardSource = std::make_shared<_ShardSourceData>(sourceData);
+		shardSourceData[i] = shardSource;
+		shardResults[i] = std::async(std::launch::async, [call, shard, shardSource]()
+		{
+			return call(shard.get(), shardSource);
+		});
+	}
+
+	// collect the answers, the latency of the whole call is that of the
+	// slowest shard (or the timeout) since they all run at the same time
+	const std::chrono::steady_clock::time_point deadline =
+		std::chrono::steady_clock::now() + std::chrono::milliseconds(this->_timeoutMs);
+	std::vector<bool> answered(shardResults.size(), false);
+	bool result = false;
+	for (size_t i = 0; i < shardResults.size(); i++)
+	{
+		if (!shardResults[i].valid())
+		{
+			continue;
+		}
+
+		if (this->_timeoutMs > 0 && shardResults[i].wait_until(deadline) == std::future_status::timeout)
+		{
+			TF_WARN("Shard %zu did not answer within %zu ms, leaving it out of the result", i, this->_timeoutMs);
+			shardSourceData[i]->Detach();
+
+			std::lock_guard<std::mutex> lock(this->_abandonedCallsMutex);
+			this->_abandonedCalls.push_back(_AbandonedCall{ i, std::move(shardResults[i]) });
+			continue;
+		}
+
+		answered[i] = true;
+		result = shardResults[i].get() || result;
+	}
+
+	// merge in shard order, the first shard to create a prim or attribute
+	// owns it and the same content from later shards is dropped, otherwise
+	// the children lists in the layer would contain duplicates
+	std::unordered_map<SdfPath, size_t, SdfPath::Hash> owners;
+	for (size_t i = 0; i < shardSourceData.size(); i++)
+	{
+		if (!answered[i])
+		{
+			continue;
+		}
+
+		for (const EdfSourceDataOperation& operation : shardSourceData[i]->TakeOperations())
+		{
+			SdfPath target;
+			switch (operation.type)
+			{
+				case EdfSourceDataOperation::Type::CreatePrim:
+					target = operation.path.AppendChild(TfToken(operation.name));
+					break;
+				case EdfSourceDataOperation::Type::CreateAttribute:
+					target = operation.path.AppendProperty(TfToken(operation.name));
+					break;
+				case EdfSourceDataOperation::Type::SetField:
+					target = operation.path;
+					break;
+			}
+
+			std::pair<std::unordered_map<SdfPath, size_t, SdfPath::Hash>::iterator, bool> owner = owners.emplace(target, i);
+			if (!owner.second && owner.first->second != i)
+			{
+				continue;
+			}
+
+			switch (operation.type)
+			{
+				case EdfSourceDataOperation::Type::CreatePrim:
+					sourceData->CreatePrim(operation.path, operation.name, operation.specifier, operation.token);
+					break;
+				case EdfSourceDataOperation::Type::CreateAttribute:
+					sourceData->CreateAttribute(operation.path, operation.name, operation.valueTypeName,
+						operation.variability, operation.value);
+					break;
+				case EdfSourceDataOperation::Type::SetField:
+					sourceData->SetField(operation.path, operation.token, operation.value);
+					break;
+			}
+		}
+	}
+
+	return result;
+}
+
+std::vector<bool> EdfShardedProvider::_GetBusyShards()
+{
+	// drop abandoned calls that have finished in the meantime,
+	// the shards of the others are still busy
+	std::vector<bool> busy(this->_shards.size(), false);
+	std::lock_guard<std::mutex> lock(this->_abandonedCallsMutex);
+	for (auto it = this->_abandonedCalls.begin(); it != this->_abandonedCalls.end();)
+	{
+		if (it->result.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+		{
+			it = this->_abandonedCalls.erase(it);
+		}
+		else
+		{
+			busy[it->shardIndex] = true;
+			it++;
+		}
+	}
+
+	return busy;
+}
+
+PXR_NAMESPACE_CLOSE_SCOPE
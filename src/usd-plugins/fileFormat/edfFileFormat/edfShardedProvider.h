@@ -0,0 +1,99 @@
+// Copyright 2023 NVIDIA CORPORATION
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef OMNI_EDF_EDFSHARDEDPROVIDER_H_
+#define OMNI_EDF_EDFSHARDEDPROVIDER_H_
+
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <pxr/pxr.h>
+#include <pxr/base/tf/staticTokens.h>
+
+#include "iEdfDataProvider.h"
+
+PXR_NAMESPACE_OPEN_SCOPE
+
+TF_DECLARE_PUBLIC_TOKENS(
+	EdfShardedProviderProviderArgKeys,
+	(shardCount)
+	(shardTimeoutMs)
+	(dataProviderId)
+);
+
+/// \class EdfShardedProvider
+///
+/// A data provider that reads one hierarchy from several inner data
+/// providers (shards) at once and merges what they create into a single
+/// namespace under /Data.
+///
+/// The number of shards is given by the shardCount provider argument.
+/// Each shard is configured by arguments prefixed with "shard<i>:",
+/// where "shard<i>:dataProviderId" names the data provider to create
+/// and all other "shard<i>:<key>" arguments are forwarded to it as
+/// "<key>".  Every Read / ReadChildren call is issued to all shards
+/// concurrently so the latency of a call is that of the slowest shard
+/// rather than the sum over all shards.  Shards that don't answer within
+/// shardTimeoutMs milliseconds (0, the default, waits forever) are left
+/// out of the result of that call, and out of every call issued while
+/// the call that timed out is still running, so a slow shard is never
+/// entered again before it has answered.
+///
+/// Results are merged in shard order, so the order of children does not
+/// depend on which shard finished first.  If several shards create the
+/// same prim or attribute, the lowest numbered shard wins.
+///
+class EdfShardedProvider : public IEdfDataProvider
+{
+public:
+
+	EdfShardedProvider(const EdfDataParameters& parameters);
+	virtual ~EdfShardedProvider();
+
+	virtual bool Read(std::shared_ptr<IEdfSourceData> sourceData) override;
+	virtual bool ReadChildren(const std::string& primPath, std::shared_ptr<IEdfSourceData> sourceData) override;
+	virtual bool IsDataCached() const override;
+
+private:
+
+	typedef std::function<bool(IEdfDataProvider*, std::shared_ptr<IEdfSourceData>)> _ShardCall;
+
+	struct _AbandonedCall
+	{
+		size_t shardIndex;
+		std::future<bool> result;
+	};
+
+	bool _DispatchToShards(const _ShardCall& call, std::shared_ptr<IEdfSourceData> sourceData);
+	std::vector<bool> _GetBusyShards();
+
+private:
+
+	size_t _timeoutMs;
+	std::vector<std::shared_ptr<IEdfDataProvider>> _shards;
+
+	// calls that timed out are still running on their own threads,
+	// we have to wait for those before the shards can go away, and
+	// the shards they run on are skipped until they are done
+	std::mutex _abandonedCallsMutex;
+	std::vector<_AbandonedCall> _abandonedCalls;
+};
+
+PXR_NAMESPACE_CLOSE_SCOPE
+
+#endif
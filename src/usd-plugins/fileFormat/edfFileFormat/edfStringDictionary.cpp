@@ -0,0 +1,223 @@
+// Copyright 2023 NVIDIA CORPORATION
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <pxr/base/tf/envSetting.h>
+#include <pxr/base/tf/instantiateSingleton.h>
+
+#include "edfStringDictionary.h"
+
+PXR_NAMESPACE_OPEN_SCOPE
+
+TF_INSTANTIATE_SINGLETON(EdfStringDictionary);
+
+TF_DEFINE_ENV_SETTING(EDF_INTERN_STRING_VALUES, true,
+	"Share the storage of equal string attribute values in EDF layers");
+
+// the number of values of an attribute we look at before deciding
+// whether its values repeat often enough to be worth interning
+static const size_t SAMPLE_SIZE = 1024;
+
+// attributes with more than this fraction of distinct values
+// in the sample aren't interned
+static const double MAX_DISTINCT_FRACTION = 0.5;
+
+EdfStringDictionary::EdfStringDictionary() : _enabled(TfGetEnvSetting(EDF_INTERN_STRING_VALUES))
+{
+}
+
+EdfStringDictionary::~EdfStringDictionary()
+{
+}
+
+EdfStringDictionary::References::References()
+{
+}
+
+EdfStringDictionary::References::~References()
+{
+	if (!this->_values.empty())
+	{
+		EdfStringDictionary::GetInstance()._Release(this);
+	}
+}
+
+VtValue EdfStringDictionary::References::Intern(const TfToken& attributeName, const VtValue& value)
+{
+	return EdfStringDictionary::GetInstance()._Intern(this, attributeName, value);
+}
+
+EdfStringDictionary::_AttributeDictionaryPtr EdfStringDictionary::_GetDictionary(const TfToken& attributeName,
+	const _AttributeDictionaryPtr& retired)
+{
+	if (!retired)
+	{
+		_Dictionaries::const_accessor constAccessor;
+		if (this->_dictionaries.find(constAccessor, attributeName))
+		{
+			return constAccessor->second;
+		}
+	}
+
+	// create the dictionary, or replace the retired one we found,
+	// unless another layer got there first
+	_Dictionaries::accessor accessor;
+	this->_dictionaries.insert(accessor, attributeName);
+	if (!accessor->second || accessor->second == retired)
+	{
+		accessor->second = std::make_shared<_AttributeDictionary>();
+	}
+
+	return accessor->second;
+}
+
+VtValue EdfStringDictionary::_Intern(References* references, const TfToken& attributeName, const VtValue& value)
+{
+	if (!this->_enabled || !value.IsHolding<std::string>())
+	{
+		return value;
+	}
+
+	// count the layer against the value the first time it interns it,
+	// copying the value shares its storage
+	auto hold = [references, &attributeName](const std::string* key, _Entry& entry) -> VtValue
+	{
+		std::lock_guard<std::mutex> referencesLock(references->_mutex);
+		if (references->_values.emplace(key, std::make_pair(attributeName, entry.value)).second)
+		{
+			entry.referenceCount++;
+		}
+
+		return entry.value;
+	};
+
+	const std::string& stringValue = value.UncheckedGet<std::string>();
+	_AttributeDictionaryPtr dictionary = this->_GetDictionary(attributeName, nullptr);
+	for (;;)
+	{
+		tbb::spin_rw_mutex::scoped_lock lock(dictionary->mutex, false);
+		if (!dictionary->retired)
+		{
+			if (dictionary->disabled)
+			{
+				return value;
+			}
+
+			// once the sample is taken, the values the dictionary
+			// already holds are handed out under the read lock
+			if (dictionary->lookups >= SAMPLE_SIZE)
+			{
+				auto it = dictionary->values.find(&stringValue);
+				if (it != dictionary->values.end())
+				{
+					dictionary->lookups++;
+					return hold(it->first, *it->second);
+				}
+			}
+		}
+
+		// upgrading may let go of the lock on the way,
+		// so everything is looked at again under the write lock
+		lock.upgrade_to_writer();
+		if (dictionary->retired)
+		{
+			// the last value of the dictionary was released meanwhile
+			lock.release();
+			dictionary = this->_GetDictionary(attributeName, dictionary);
+			continue;
+		}
+
+		if (dictionary->disabled)
+		{
+			return value;
+		}
+
+		auto it = dictionary->values.find(&stringValue);
+		if (it != dictionary->values.end())
+		{
+			dictionary->lookups++;
+		}
+		else if (++dictionary->lookups >= SAMPLE_SIZE &&
+			static_cast<double>(dictionary->values.size()) > MAX_DISTINCT_FRACTION * static_cast<double>(dictionary->lookups))
+		{
+			// mostly distinct values, the values already handed out
+			// keep their storage alive without the dictionary
+			dictionary->disabled = true;
+			dictionary->values.clear();
+			return value;
+		}
+		else
+		{
+			// the stored value shares the storage of the one we were given,
+			// the key points at the string in that storage
+			std::unique_ptr<_Entry> entry(new _Entry());
+			entry->value = value;
+			const std::string* key = &entry->value.UncheckedGet<std::string>();
+			it = dictionary->values.emplace(key, std::move(entry)).first;
+		}
+
+		return hold(it->first, *it->second);
+	}
+}
+
+void EdfStringDictionary::_Release(References* references)
+{
+	// only called as the layer's references are destroyed,
+	// so nothing interns through them any more
+	for (const auto& heldValue : references->_values)
+	{
+		const TfToken& attributeName = heldValue.second.first;
+		_AttributeDictionaryPtr dictionary;
+		{
+			_Dictionaries::const_accessor accessor;
+			if (!this->_dictionaries.find(accessor, attributeName))
+			{
+				continue;
+			}
+
+			dictionary = accessor->second;
+		}
+
+		tbb::spin_rw_mutex::scoped_lock lock(dictionary->mutex, true);
+		if (dictionary->disabled || dictionary->retired)
+		{
+			// the values of disabled dictionaries were already dropped,
+			// retired ones hold none
+			continue;
+		}
+
+		auto it = dictionary->values.find(heldValue.first);
+		if (it != dictionary->values.end() && it->first == heldValue.first && --it->second->referenceCount == 0)
+		{
+			dictionary->values.erase(it);
+		}
+
+		if (dictionary->values.empty())
+		{
+			// no open layer holds values of the attribute, so its
+			// sample starts over with the next layer
+			dictionary->retired = true;
+			lock.release();
+
+			_Dictionaries::accessor accessor;
+			if (this->_dictionaries.find(accessor, attributeName) && accessor->second == dictionary)
+			{
+				this->_dictionaries.erase(accessor);
+			}
+		}
+	}
+
+	references->_values.clear();
+}
+
+PXR_NAMESPACE_CLOSE_SCOPE
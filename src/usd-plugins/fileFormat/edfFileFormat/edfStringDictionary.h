@@ -0,0 +1,181 @@
+// Copyright 2023 NVIDIA CORPORATION
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef OMNI_EDF_EDFSTRINGDICTIONARY_H_
+#define OMNI_EDF_EDFSTRINGDICTIONARY_H_
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include <tbb/concurrent_hash_map.h>
+#include <tbb/spin_rw_mutex.h>
+
+#include <pxr/pxr.h>
+#include <pxr/base/tf/singleton.h>
+#include <pxr/base/tf/token.h>
+#include <pxr/base/vt/value.h>
+
+PXR_NAMESPACE_OPEN_SCOPE
+
+/// \class EdfStringDictionary
+///
+/// Process-wide dictionary encoding the string values of attributes.
+/// Back-end data tends to repeat the same few values of an attribute
+/// (a department, a culture, a year) across many records, and across
+/// the layers opened over the same back-end; rather than each record
+/// holding its own copy, Intern returns a VtValue sharing the storage
+/// of the first value equal to it, so each distinct value is held once.
+///
+/// Values are encoded per attribute name.  Attributes whose values turn
+/// out to be mostly distinct (titles, identifiers) gain nothing from a
+/// dictionary, so after a sample of values the dictionary of such an
+/// attribute is dropped and its values are passed through as they are.
+///
+/// Layers intern their values through a References object, which counts
+/// them against the values of the dictionary.  A value is evicted when
+/// the last layer holding it releases its references, so the dictionary
+/// only keeps the values of the layers that are open.
+///
+/// Each attribute name has a dictionary of its own with its own lock,
+/// so layers interning values of different attributes don't contend,
+/// and once the sample of an attribute is taken, interning a value the
+/// dictionary already holds only takes its lock for reading.
+///
+class EdfStringDictionary
+{
+public:
+
+	static EdfStringDictionary& GetInstance()
+	{
+		return TfSingleton<EdfStringDictionary>::GetInstance();
+	}
+
+	// prevent copying and assignment
+	EdfStringDictionary(const EdfStringDictionary&) = delete;
+	EdfStringDictionary& operator=(const EdfStringDictionary&) = delete;
+
+	/// \class References
+	///
+	/// The values of the dictionary one layer holds, released
+	/// when it is destroyed.
+	///
+	class References
+	{
+	public:
+
+		References();
+		~References();
+
+		// prevent copying and assignment
+		References(const References&) = delete;
+		References& operator=(const References&) = delete;
+
+		/// Returns the interned equivalent of value if it holds a string
+		/// value of the attribute attributeName, otherwise returns value.
+		VtValue Intern(const TfToken& attributeName, const VtValue& value);
+
+	private:
+
+		friend class EdfStringDictionary;
+
+		// the attribute name and value of each interned value held,
+		// keyed by the address of its string; holding the value keeps
+		// the string alive for as long as it is a key
+		std::mutex _mutex;
+		std::unordered_map<const std::string*, std::pair<TfToken, VtValue>> _values;
+	};
+
+private:
+
+	EdfStringDictionary();
+	~EdfStringDictionary();
+
+	VtValue _Intern(References* references, const TfToken& attributeName, const VtValue& value);
+	void _Release(References* references);
+
+	friend class TfSingleton<EdfStringDictionary>;
+
+private:
+
+	// the keys point at the strings held by the values of the
+	// dictionary, so each distinct string is stored only once
+	struct _StringPtrHash
+	{
+		size_t operator()(const std::string* value) const
+		{
+			return std::hash<std::string>()(*value);
+		}
+	};
+
+	struct _StringPtrEqual
+	{
+		bool operator()(const std::string* left, const std::string* right) const
+		{
+			return *left == *right;
+		}
+	};
+
+	struct _Entry
+	{
+		VtValue value;
+
+		// the number of References objects holding the value,
+		// counted up under the read lock of the dictionary
+		std::atomic<size_t> referenceCount{0};
+	};
+
+	struct _AttributeDictionary
+	{
+		// held for reading to look up a value, for writing to insert
+		// or release one, or to decide on the sample
+		tbb::spin_rw_mutex mutex;
+		std::unordered_map<const std::string*, std::unique_ptr<_Entry>, _StringPtrHash, _StringPtrEqual> values;
+		std::atomic<size_t> lookups{0};
+		bool disabled = false;
+
+		// set when the last value is released and the dictionary is
+		// removed, a layer that still finds it looks it up again
+		bool retired = false;
+	};
+
+	typedef std::shared_ptr<_AttributeDictionary> _AttributeDictionaryPtr;
+
+	// Hash structure consistent with what TBB expects
+	struct _TokenHash
+	{
+		static size_t hash(const TfToken& token)
+		{
+			return token.Hash();
+		}
+
+		static bool equal(const TfToken& token1, const TfToken& token2)
+		{
+			return token1 == token2;
+		}
+	};
+
+	_AttributeDictionaryPtr _GetDictionary(const TfToken& attributeName, const _AttributeDictionaryPtr& retired);
+
+	typedef tbb::concurrent_hash_map<TfToken, _AttributeDictionaryPtr, _TokenHash> _Dictionaries;
+
+	bool _enabled;
+	_Dictionaries _dictionaries;
+};
+
+PXR_NAMESPACE_CLOSE_SCOPE
+
+#endif